@@ -0,0 +1,90 @@
+// Lõi Arduino giả lập tối thiểu để biên dịch thư mục json/ của Firebase-ESP-Client
+// trên Linux (chỉ dùng cho bench, không phải môi trường chạy firmware).
+#ifndef _BENCH_MOCK_ARDUINO_H_
+#define _BENCH_MOCK_ARDUINO_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+
+#define PROGMEM
+#define PGM_P const char *
+#define PSTR(s) (s)
+#define pgm_read_byte(p) (*(const uint8_t *)(p))
+#define strlen_P strlen
+#define strcpy_P strcpy
+#define strcmp_P strcmp
+#define strncmp_P strncmp
+#define memcpy_P memcpy
+#define strstr_P strstr
+#define strcat_P strcat
+
+class __FlashStringHelper;
+#define FPSTR(p) (reinterpret_cast<const __FlashStringHelper *>(p))
+#define F(s) FPSTR(s)
+
+unsigned long millis();
+inline void delay(unsigned long) {}
+inline void yield() {}
+
+// String của Arduino dựng trên std::string, đủ cho các API mà FirebaseJson gọi tới
+class String : public std::string {
+public:
+  String() {}
+  String(const char *s) : std::string(s ? s : "") {}
+  String(const std::string &s) : std::string(s) {}
+  String(int v) : std::string(std::to_string(v)) {}
+  unsigned int length() const { return (unsigned int)size(); }
+  void reserve(size_t n) { std::string::reserve(n); }
+  String &operator+=(const char *s) { append(s); return *this; }
+  String &operator+=(char c) { push_back(c); return *this; }
+  String &operator+=(const String &s) { append(s); return *this; }
+  bool concat(const char *s) { append(s); return true; }
+  bool concat(char c) { push_back(c); return true; }
+  void remove(unsigned int i, unsigned int n) { erase(i, n); }
+  void remove(unsigned int i) { erase(i); }
+  int indexOf(const char *s) const { size_t p = find(s); return p == npos ? -1 : (int)p; }
+  String substring(unsigned a, unsigned b) const { return String(substr(a, b - a)); }
+  String substring(unsigned a) const { return String(substr(a)); }
+  char charAt(unsigned i) const { return at(i); }
+  void trim() {}
+  long toInt() const { return atol(c_str()); }
+  float toFloat() const { return (float)atof(c_str()); }
+};
+
+class StringSumHelper : public String {
+public:
+  using String::String;
+};
+
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t) { return 1; }
+  virtual size_t write(const uint8_t *, size_t n) { return n; }
+  size_t print(const char *s) { return write((const uint8_t *)s, strlen(s)); }
+  size_t print(const String &s) { return print(s.c_str()); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t println(const char *s = "") { return print(s) + print("\n"); }
+  size_t printf(const char *, ...) { return 0; }
+  void flush() {}
+};
+
+class Stream : public Print {
+public:
+  virtual int available() { return 0; }
+  virtual int read() { return -1; }
+  virtual int peek() { return -1; }
+  void setTimeout(unsigned long) {}
+  size_t readBytes(char *, size_t) { return 0; }
+  size_t readBytes(uint8_t *, size_t) { return 0; }
+  String readStringUntil(char) { return String(); }
+};
+
+extern Print Serial;
+
+#endif
@@ -787,6 +787,34 @@ struct firebase_chunk_state_info
     int dataLen = 0;
 };
 
+class FB_ReadBuffer;
+
+typedef struct firebase_connection_stats_t
+{
+    // the new server connections (TCP connect and TLS handshake)
+    uint32_t connects = 0;
+    // the requests sent
+    uint32_t requests = 0;
+    // the requests sent on the already opened connection
+    uint32_t reused = 0;
+    // the requests sent without waiting for the previous response
+    uint32_t pipelined = 0;
+    // the highest number of responses waiting to be read
+    uint16_t maxInflight = 0;
+
+} FirebaseConnectionStats;
+
+typedef struct firebase_connection_pool_stats_t
+{
+    // the idle connections taken by a session
+    uint32_t leases = 0;
+    // the connections returned to the pool after the request
+    uint32_t parks = 0;
+    // the idle connections closed to meet the idle count or buffer limit
+    uint32_t evictions = 0;
+
+} FirebaseConnectionPoolStats;
+
 struct firebase_tcp_response_handler_t
 {
     // the chunk index of all data that is being process
@@ -831,6 +859,10 @@ struct firebase_tcp_response_handler_t
     int base64PadLenSignature = 0;
     // the tcp client pointer
     Client *client = nullptr;
+    // the client receive window (buffered line reads), null for plain byte reads
+    FB_ReadBuffer *rx = nullptr;
+    // the next (pipelined) response follows, do not flush the remaining data
+    bool keepRx = false;
     // the chunk state info
     firebase_chunk_state_info chunkState;
 
@@ -889,6 +921,81 @@ typedef struct firebase_rtdb_download_status_info_t
 typedef void (*RTDB_UploadProgressCallback)(RTDB_UploadStatusInfo);
 typedef void (*RTDB_DownloadProgressCallback)(RTDB_DownloadStatusInfo);
 
+typedef struct firebase_rtdb_pipeline_result_t
+{
+    // the request order in pipeline, starts from 1
+    uint16_t id = 0;
+    firebase_request_method method = http_undefined;
+    MB_String path;
+    int httpCode = 0;
+    bool success = false;
+    MB_String errorMsg;
+
+} RTDB_PipelineResult;
+
+typedef void (*RTDB_PipelineResultCallback)(RTDB_PipelineResult);
+
+struct firebase_rtdb_pipeline_request_t
+{
+    uint16_t id = 0;
+    firebase_request_method method = http_undefined;
+    firebase_data_type type = d_any;
+    MB_String path;
+};
+
+struct firebase_rtdb_combined_write_t
+{
+    MB_String path;
+    // the JSON serialized value
+    MB_String value;
+};
+
+struct firebase_rtdb_write_combiner_t
+{
+    bool enable = false;
+    // sending the combined update
+    bool flushing = false;
+    unsigned long deadline_ms = 0;
+    // the time of the oldest pending write
+    unsigned long first_ms = 0;
+    // the latest pending value per path, in the first write order
+    MB_VECTOR<firebase_rtdb_combined_write_t> writes;
+};
+
+// The prebuilt parts of RTDB request header, rebuilt when one of its keys changes
+struct firebase_rtdb_header_template_t
+{
+    // ".json?auth=<token>&timeout=<ms>ms&writeSizeLimit=<size>"
+    MB_String query;
+    // " HTTP/1.1\r\nHost: <host>\r\nUser-Agent: ESP\r\n<custom headers>[Authorization: Bearer <token>\r\n]"
+    MB_String headers;
+    bool has_query_params = false;
+    // the token position in query (or headers for OAuth2.0 access token)
+    bool token_in_headers = false;
+    size_t token_ofs = 0;
+    size_t token_len = 0;
+
+    // keys
+    firebase_auth_token_type token_type = token_type_undefined;
+    bool test_mode = false;
+    int read_tmo = -1;
+    MB_String write_limit;
+    MB_String host;
+    MB_String custom_headers;
+    MB_String auth_type;
+};
+
+struct firebase_rtdb_pipeline_info_t
+{
+    bool enable = false;
+    // reading the pipelined responses
+    bool reading = false;
+    uint16_t id = 0;
+    RTDB_PipelineResultCallback cb = NULL;
+    // the sent requests that their responses are not read yet, in request order
+    MB_VECTOR<firebase_rtdb_pipeline_request_t> inflight;
+};
+
 struct firebase_rtdb_request_info_t
 {
     MB_String path;
@@ -1121,6 +1228,10 @@ struct firebase_cfg_int_t
     TaskHandle_t functions_deployment_task_handle = NULL;
 
     TaskHandle_t stream_task_handle = NULL;
+#if defined(ESP32)
+    // loopback UDP socket that wakes the stream task from select
+    int stream_wake_fd = -1;
+#endif
     TaskHandle_t queue_task_handle = NULL;
 #endif
     size_t stream_task_stack_size = STREAM_TASK_STACK_SIZE;
@@ -1428,6 +1539,9 @@ struct firebase_rtdb_info_t
     size_t file_size = 0;
 
     struct firebase_stream_info_t stream;
+    struct firebase_rtdb_pipeline_info_t pipeline;
+    struct firebase_rtdb_header_template_t header_tpl;
+    struct firebase_rtdb_write_combiner_t combiner;
 
 #if defined(ESP32) || defined(MB_ARDUINO_PICO)
     bool stream_loop_task_enable = false;
@@ -2224,6 +2338,8 @@ static const char firebase_rtdb_pgm_str_37[] PROGMEM = "Keep-Alive: timeout=30,
 static const char firebase_rtdb_pgm_str_38[] PROGMEM = "Accept-Encoding: identity;q=1,chunked;q=0.1,*;q=0\r\n";
 static const char firebase_rtdb_pgm_str_39[] PROGMEM = "{\".sv\": \"timestamp\"}";
 static const char firebase_rtdb_pgm_str_40[] PROGMEM = "object";
+static const char firebase_rtdb_pgm_str_41[] PROGMEM = ".hd";
+static const char firebase_rtdb_pgm_str_42[] PROGMEM = ".tmp";
 #endif
 
 // FCM class string
@@ -0,0 +1,256 @@
+/*
+ * FB_ReadBuffer, version 1.0.0
+ *
+ * Buffered receive window of the HTTP response reader.
+ *
+ * Created October 18, 2026
+ *
+ * The MIT License (MIT)
+ * Copyright (c) 2023 K. Suwatchai (Mobizt)
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person returning a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef FB_READ_BUFFER_H
+#define FB_READ_BUFFER_H
+
+#include <Arduino.h>
+#include <Client.h>
+#include "./FirebaseFS.h"
+#include "./json/MB_String.h"
+
+#if defined(ESP8266)
+#if __has_include(<core_esp8266_version.h>)
+#include <core_esp8266_version.h>
+#endif
+#endif
+
+namespace FBUtils
+{
+    inline void idle()
+    {
+#if defined(ARDUINO_ESP8266_MAJOR) && defined(ARDUINO_ESP8266_MINOR) && defined(ARDUINO_ESP8266_REVISION) && ((ARDUINO_ESP8266_MAJOR == 3 && ARDUINO_ESP8266_MINOR >= 1) || ARDUINO_ESP8266_MAJOR > 3)
+        esp_yield();
+#else
+        delay(0);
+#endif
+    }
+};
+
+#if !defined(FIREBASE_RX_WINDOW_SIZE)
+#define FIREBASE_RX_WINDOW_SIZE 512
+#endif
+
+/* Receive window over a Client.
+ * Pulls whatever the client has decrypted in one bulk read and serves bytes and
+ * lines from memory, so a line costs one memchr instead of one read() (and one
+ * TLS engine pump) per byte.
+ */
+class FB_ReadBuffer
+{
+public:
+    ~FB_ReadBuffer() { release(); }
+
+    void setClient(Client *client) { _client = client; }
+
+    // Drop buffered bytes (connection closed, flushed or replaced).
+    void reset() { _pos = _len = 0; }
+
+    void release()
+    {
+        if (_buf)
+            free(_buf);
+        _buf = nullptr;
+        reset();
+    }
+
+    int buffered() const { return _len - _pos; }
+
+    int available()
+    {
+        int n = buffered();
+        if (_client)
+        {
+            int c = _client->available();
+            if (c > 0)
+                n += c;
+        }
+        return n;
+    }
+
+    int read()
+    {
+        if (_pos == _len && fill() <= 0)
+            return -1;
+        return _buf[_pos++];
+    }
+
+    int peek()
+    {
+        if (_pos == _len && fill() <= 0)
+            return -1;
+        return _buf[_pos];
+    }
+
+    int read(uint8_t *dst, int len)
+    {
+        int idx = 0;
+        while (idx < len)
+        {
+            if (_pos == _len)
+            {
+                // large reads bypass the window
+                if (len - idx >= FIREBASE_RX_WINDOW_SIZE && _client && _client->available() > 0)
+                {
+                    int n = _client->read(dst + idx, len - idx);
+                    if (n <= 0)
+                        break;
+                    idx += n;
+                    continue;
+                }
+                if (fill() <= 0)
+                    break;
+            }
+            int n = _len - _pos;
+            if (n > len - idx)
+                n = len - idx;
+            memcpy(dst + idx, _buf + _pos, n);
+            _pos += n;
+            idx += n;
+        }
+        return idx;
+    }
+
+    // Read up to and including '\n' or until dstLen bytes or no more data.
+    // The output is null terminated when there is room for it.
+    int readLine(char *dst, int dstLen)
+    {
+        int idx = 0;
+        while (idx < dstLen)
+        {
+            if (_pos == _len && fill() <= 0)
+                break;
+            int n = _len - _pos;
+            if (n > dstLen - idx)
+                n = dstLen - idx;
+            const uint8_t *nl = reinterpret_cast<const uint8_t *>(memchr(_buf + _pos, '\n', n));
+            if (nl)
+                n = nl - (_buf + _pos) + 1;
+            memcpy(dst + idx, _buf + _pos, n);
+            _pos += n;
+            idx += n;
+            if (nl)
+                break;
+        }
+        if (idx < dstLen)
+            dst[idx] = 0;
+        return idx;
+    }
+
+    int readLine(MB_String &dst)
+    {
+        int idx = 0;
+        for (;;)
+        {
+            if (_pos == _len && fill() <= 0)
+                break;
+            int n = _len - _pos;
+            const uint8_t *nl = reinterpret_cast<const uint8_t *>(memchr(_buf + _pos, '\n', n));
+            if (nl)
+                n = nl - (_buf + _pos) + 1;
+            dst.append(reinterpret_cast<const char *>(_buf + _pos), n);
+            _pos += n;
+            idx += n;
+            if (nl)
+                break;
+        }
+        return idx;
+    }
+
+    // Consume one line that is still arriving, e.g. the CRLF after the last chunk
+    // when the next pipelined response follows.
+    bool skipLine(unsigned long tmo)
+    {
+        unsigned long ms = millis();
+        while (millis() - ms < tmo)
+        {
+            int c = read();
+            if (c == '\n')
+                return true;
+            if (c < 0)
+                FBUtils::idle();
+        }
+        return false;
+    }
+
+    // Parse the chunk size in place: the hex digits up to the first other character
+    // (';' of extension, ' ' or '\r'), the rest of line is not needed.
+    // Returns -1 when the line has no digit, the digits are not terminated in len
+    // or the size does not fit in int.
+    static int chunkSize(const char *line, int len)
+    {
+        uint32_t val = 0;
+        int i = 0;
+        for (; i < len; i++)
+        {
+            uint8_t c = line[i];
+            if (c >= '0' && c <= '9')
+                c = c - '0';
+            else if (c >= 'a' && c <= 'f')
+                c = c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F')
+                c = c - 'A' + 10;
+            else
+                break;
+            if (val > 0x7FFFFFF)
+                return -1;
+            val = (val << 4) | c;
+        }
+        if (i == 0 || i == len)
+            return -1;
+        return val;
+    }
+
+private:
+    int fill()
+    {
+        if (!_client || _client->available() <= 0)
+            return 0;
+
+        if (!_buf)
+        {
+            _buf = reinterpret_cast<uint8_t *>(malloc(FIREBASE_RX_WINDOW_SIZE));
+            if (!_buf)
+                return 0;
+        }
+
+        FBUtils::idle();
+        int n = _client->read(_buf, FIREBASE_RX_WINDOW_SIZE);
+        _pos = 0;
+        _len = n > 0 ? n : 0;
+        return _len;
+    }
+
+    Client *_client = nullptr;
+    uint8_t *_buf = nullptr;
+    int _pos = 0;
+    int _len = 0;
+};
+
+#endif
@@ -358,6 +358,21 @@ public:
    */
   void setDoubleDigits(uint8_t digits);
 
+  /** Share the idle TLS connections between the FirebaseData objects.
+   *
+   * @param maxIdle The maximum number of idle connections kept open, 0 (default) disables the pool.
+   * @param maxBufferSize (Optional) The maximum BearSSL io buffer bytes of all pooled connections
+   * (in use and idle), 0 for no limit.
+   * @param idleTimeoutMs (Optional) The time in ms that the idle connection is kept open.
+   *
+   * @note The FirebaseData object returns its connection to the pool after the synchronous
+   * RTDB, Firestore or FCM request was completed and takes the idle connection to the same host
+   * when it begins the next request, the TCP and TLS handshakes are skipped.
+   * Only the connections of the internal WiFi client are pooled.
+   * When the buffer limit is reached, the oldest idle connections are closed.
+   */
+  void setConnectionPool(uint8_t maxIdle, size_t maxBufferSize = 0, uint32_t idleTimeoutMs = 30000);
+
 #if defined(FIREBASE_ESP32_CLIENT) || defined(FIREBASE_ESP8266_CLIENT)
 
 #if defined(ENABLE_RTDB) || defined(FIREBASE_ENABLE_RTDB)
@@ -200,6 +200,21 @@
  * 🏷️ For debug port assignment.
  * #define FIREBASE_DEFAULT_DEBUG_PORT Serial
  *
+ * 🏷️ For the HTTP response receive window size in bytes (default 512).
+ * #define FIREBASE_RX_WINDOW_SIZE 1024
+ *
+ * 🏷️ For the maximum RTDB pipelined requests that wait for their responses (default 8).
+ * #define FIREBASE_RTDB_PIPELINE_MAX_INFLIGHT 4
+ *
+ * 🏷️ For the persistent error queue records replayed by each processErrorQueue call (default 16).
+ * #define FIREBASE_ERROR_QUEUE_REPLAY_BATCH 32
+ *
+ * 🏷️ For the replayed bytes of the persistent error queue file before it is compacted (default 4096).
+ * #define FIREBASE_ERROR_QUEUE_COMPACT_SIZE 8192
+ *
+ * 🏷️ For the longest wait of ESP32 stream task for the stream socket data in ms (default 1000).
+ * #define FIREBASE_STREAM_IDLE_WAKE_MS 500
+ *
  */
 #define ENABLE_ESP8266_ENC28J60_ETH
 
@@ -52,6 +52,8 @@
 #define BASE_WIFICLIENT WiFiClient
 #endif
 
+#include "./client/FB_ConnectionPool.h"
+
 #pragma GCC diagnostic ignored "-Wdelete-non-virtual-dtor"
 #pragma GCC diagnostic ignored "-Wunused-variable"
 
@@ -95,10 +97,13 @@ public:
   Firebase_TCP_Client()
   {
     _tcp_client = new ESP_SSLClient();
+    _rx.setClient(_tcp_client);
   };
 
   virtual ~Firebase_TCP_Client()
   {
+    if (_pool_size)
+      Firebase_Connection_Pool::instance().release(_pool_size);
     clear();
     if (_tcp_client)
       delete (ESP_SSLClient *)_tcp_client;
@@ -234,6 +239,7 @@ public:
    */
   void setTimeout(uint32_t timeoutSec)
   {
+    _timeout_sec = timeoutSec;
     _tcp_client->setTimeout(timeoutSec);
   }
 
@@ -518,8 +524,16 @@ public:
    */
   bool begin(const char *host, uint16_t port, int *response_code)
   {
+    // keep the connection to the other host warm for the other sessions
+    if (pooled() && connected() && (_port != port || strcmp(_host.c_str(), host) != 0))
+      release();
+
     _host = host;
     _port = port;
+
+    if (pooled() && !connected())
+      lease();
+
     _tcp_client->setBufferSizes(_rx_size, _tx_size);
     _last_error = 0;
     this->response_code = response_code;
@@ -588,6 +602,14 @@ public:
     if (!_tcp_client->connect(_host.c_str(), _port))
       return setError(FIREBASE_ERROR_TCP_ERROR_CONNECTION_REFUSED);
 
+    _stats.connects++;
+
+    if (pooled() && !_pool_size)
+    {
+      _pool_size = _rx_size + _tx_size;
+      Firebase_Connection_Pool::instance().acquire(_pool_size);
+    }
+
 #if defined(FIREBASE_WIFI_IS_AVAILABLE) && (defined(ESP32) || defined(ESP8266) || defined(MB_ARDUINO_PICO))
     if (_client_type == firebase_client_type_internal_basic_client)
     {
@@ -647,8 +669,37 @@ public:
    */
   void stop()
   {
+    _rx.reset();
     if (_tcp_client)
       _tcp_client->stop();
+
+    if (_pool_size)
+      Firebase_Connection_Pool::instance().release(_pool_size);
+    _pool_size = 0;
+  }
+
+  /**
+   * Return the connection to the shared pool after the request was completed.
+   * The connection stays open and can be leased by any session that begins the
+   * request to the same host. Nothing is done when pool is disabled, the client is
+   * external or the response was not read completely.
+   */
+  void release()
+  {
+    if (!pooled() || !connected() || _rx.available() > 0)
+      return;
+
+    _rx.reset();
+
+    if (!Firebase_Connection_Pool::instance().park(_tcp_client, _basic_client, _host.c_str(), _port, _cert_type, _pool_size))
+      return;
+
+    // the pool owns the connected clients now, the new WiFi client will be created on the next connect
+    _pool_size = 0;
+    _basic_client = nullptr;
+    _tcp_client = new ESP_SSLClient();
+    _rx.setClient(_tcp_client);
+    applySecurity();
   }
 
   int setError(int code)
@@ -765,7 +816,7 @@ public:
     if (!_tcp_client)
       return setError(FIREBASE_ERROR_TCP_CLIENT_NOT_INITIALIZED);
 
-    return _tcp_client->available();
+    return _rx.available();
   }
 
   /**
@@ -777,7 +828,7 @@ public:
     if (!_basic_client)
       return setError(FIREBASE_ERROR_TCP_CLIENT_NOT_INITIALIZED);
 
-    return _tcp_client->read();
+    return _rx.read();
   }
 
   int read(uint8_t *buf, size_t len)
@@ -796,7 +847,7 @@ public:
     if (!_basic_client)
       return setError(FIREBASE_ERROR_TCP_CLIENT_NOT_INITIALIZED);
 
-    return _tcp_client->read(buf, len);
+    return _rx.read(buf, len);
   }
 
   /**
@@ -815,10 +866,23 @@ public:
    */
   void flush()
   {
+    _rx.reset();
     if (_tcp_client && _tcp_client->connected())
       _tcp_client->flush();
   }
 
+  /**
+   * Get the receive window used for buffered line reads.
+   * @return The FB_ReadBuffer pointer.
+   */
+  FB_ReadBuffer *rxBuffer() { return &_rx; }
+
+  /**
+   * Get the connection reuse statistics.
+   * @return The FirebaseConnectionStats reference.
+   */
+  FirebaseConnectionStats &stats() { return _stats; }
+
   /**
    * Set the network status which should call in side the networkStatusRequestCallback function.
    * @param status The status of network.
@@ -832,7 +896,7 @@ public:
   {
     if (!_tcp_client)
       return 0;
-    return _tcp_client->peek();
+    return _rx.peek();
   }
 
   int connect(IPAddress ip, uint16_t port)
@@ -1110,6 +1174,19 @@ public:
     return _network_status;
   }
 
+  /**
+   * Get the socket of the internal WiFi client.
+   * @return The socket descriptor or -1 when it is not connected or the client is external.
+   */
+  int socket()
+  {
+#if defined(ESP32) && defined(FIREBASE_WIFI_IS_AVAILABLE) && defined(BASE_WIFICLIENT)
+    if (_basic_client && _client_type == firebase_client_type_internal_basic_client)
+      return reinterpret_cast<BASE_WIFICLIENT *>(_basic_client)->fd();
+#endif
+    return -1;
+  }
+
   int setOption(int option, int *value)
   {
 #if defined(ESP32) && defined(FIREBASE_WIFI_IS_AVAILABLE)
@@ -1129,6 +1206,7 @@ public:
 
   void setSession(BearSSL_Session *session)
   {
+    _session = session;
     _tcp_client->setSession(session);
   }
 
@@ -1151,6 +1229,8 @@ private:
   bool _isKeepAlive = false;
 
   ESP_SSLClient *_tcp_client = nullptr;
+  FB_ReadBuffer _rx;
+  FirebaseConnectionStats _stats;
   X509List *_x509 = nullptr;
 
   MB_String _host;
@@ -1187,6 +1267,63 @@ private:
   firebase_cert_type _cert_type = firebase_cert_type_undefined;
   firebase_client_type _client_type = firebase_client_type_undefined;
   SPI_ETH_Module *eth = NULL;
+
+  BearSSL_Session *_session = nullptr;
+  uint32_t _timeout_sec = 0;
+  // the io buffer bytes of this connection in the pool accounting
+  size_t _pool_size = 0;
+
+  // Only the connections of the internal WiFi client are shared.
+  bool pooled()
+  {
+#if defined(FIREBASE_WIFI_IS_AVAILABLE)
+    return Firebase_Connection_Pool::instance().enabled() &&
+           (_client_type == firebase_client_type_internal_basic_client ||
+            (_client_type == firebase_client_type_undefined && !_basic_client));
+#else
+    return false;
+#endif
+  }
+
+  // Swap in the idle connection to _host:_port from the pool.
+  void lease()
+  {
+    ESP_SSLClient *ssl = nullptr;
+    Client *client = nullptr;
+    size_t size = 0;
+
+    if (!Firebase_Connection_Pool::instance().lease(_host.c_str(), _port, _cert_type, ssl, client, size))
+      return;
+
+    if (_pool_size)
+      Firebase_Connection_Pool::instance().release(_pool_size);
+
+    delete _tcp_client;
+    clear();
+
+    _tcp_client = ssl;
+    _basic_client = client;
+    _client_type = firebase_client_type_internal_basic_client;
+    _pool_size = size;
+    _rx.reset();
+    _rx.setClient(_tcp_client);
+    applySecurity();
+  }
+
+  // The swapped SSL client still refers to the certificate and session of its previous owner.
+  void applySecurity()
+  {
+    if (_cert_type == firebase_cert_type_none)
+      _tcp_client->setInsecure();
+    else if (_x509)
+      _tcp_client->setTrustAnchors(_x509);
+
+    if (_session)
+      _tcp_client->setSession(_session);
+
+    if (_timeout_sec > 0)
+      _tcp_client->setTimeout(_timeout_sec);
+  }
 };
 
 #endif /* Firebase_TCP_Client_H */
@@ -1056,7 +1056,7 @@ bool FirebaseCore::handleTokenResponse(int &httpCode)
     struct server_response_data_t response;
     struct firebase_tcp_response_handler_t tcpHandler;
 
-    hh.intTCPHandler(tcpClient, tcpHandler, 2048, 2048, nullptr, false);
+    hh.intTCPHandler(tcpClient, tcpHandler, 2048, 2048, nullptr, false, tcpClient->rxBuffer());
 
     while (tcpClient->connected() && tcpClient->available() == 0)
     {
@@ -1104,7 +1104,7 @@ bool FirebaseCore::handleTokenResponse(int &httpCode)
                     tcpHandler.bufferAvailable = hh.readChunkedData(&sh, &mbfs, tcpClient,
                                                                     pChunk, nullptr, tcpHandler);
                 else
-                    tcpHandler.bufferAvailable = hh.readLine(tcpClient,
+                    tcpHandler.bufferAvailable = hh.readLine(tcpHandler,
                                                              pChunk, tcpHandler.chunkBufSize);
 
                 if (tcpHandler.bufferAvailable > 0)
@@ -745,7 +745,11 @@ bool FB_Firestore::firestore_sendRequest(FirebaseData *fbdo, struct firebase_fir
     }
 
     if (fbdo->session.response.code > 0 && (fbdo->session.cfs.async || handleResponse(fbdo, req)))
+    {
+        if (!fbdo->session.cfs.async)
+            fbdo->tcpClient.release();
         return true;
+    }
 
     return false;
 }
@@ -787,7 +791,8 @@ bool FB_Firestore::handleResponse(FirebaseData *fbdo, struct firebase_firestore_
     struct firebase_tcp_response_handler_t tcpHandler;
 
     Core.hh.initTCPSession(fbdo->session);
-    Core.hh.intTCPHandler(&fbdo->tcpClient, tcpHandler, 2048, fbdo->session.resp_size, nullptr, false);
+    Core.hh.intTCPHandler(&fbdo->tcpClient, tcpHandler, 2048, fbdo->session.resp_size, nullptr, false,
+                          fbdo->tcpClient.rxBuffer());
 
     if (!fbdo->waitResponse(tcpHandler))
         return false;
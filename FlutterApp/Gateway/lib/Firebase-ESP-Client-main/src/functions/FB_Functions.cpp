@@ -755,7 +755,8 @@ bool FB_Functions::handleResponse(FirebaseData *fbdo)
     struct firebase_tcp_response_handler_t tcpHandler;
 
     Core.hh.initTCPSession(fbdo->session);
-    Core.hh.intTCPHandler(&fbdo->tcpClient, tcpHandler, 2048, fbdo->session.resp_size, nullptr, false);
+    Core.hh.intTCPHandler(&fbdo->tcpClient, tcpHandler, 2048, fbdo->session.resp_size, nullptr, false,
+                          fbdo->tcpClient.rxBuffer());
 
     MB_String js;
 
@@ -0,0 +1,339 @@
+/*
+ * FirebaseJsonArena, version 1.0.0
+ *
+ * Chunked bump allocator for the MB_JSON trees of FirebaseJson.
+ *
+ * Created October 18, 2026
+ *
+ * The MIT License (MIT)
+ * Copyright (c) 2023 K. Suwatchai (Mobizt)
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person returning a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef FirebaseJsonArena_H
+#define FirebaseJsonArena_H
+
+#include <Arduino.h>
+#include "FirebaseJsonKeyPool.h"
+
+// The default size of arena chunk in bytes.
+#if !defined(FIREBASE_JSON_ARENA_CHUNK_SIZE)
+#define FIREBASE_JSON_ARENA_CHUNK_SIZE 1024
+#endif
+
+/* The nodes and strings of the JSON tree are carved from the chunks of the arena
+ * instead of one heap block each. Freeing a single item is a no-op, the memory is
+ * given back all at once by reset() (FirebaseJson clear) which keeps the first chunk
+ * for the next tree. The heap sees a few equally sized chunks per tree instead of
+ * hundreds of small blocks, and nothing is left behind between the trees.
+ *
+ * The arena only serves the allocations made while it is the current arena of the
+ * calling thread (see FirebaseJsonArenaScope), the other allocations use the heap.
+ * Every live arena is registered so that the free hook can tell the arena memory
+ * apart from the heap memory whichever thread or object frees it.
+ */
+class FirebaseJsonArena
+{
+public:
+    /**
+     * @param chunkSize The size of chunk in bytes.
+     * @param psram Set true to place the chunks in PSRAM when available (ESP32).
+     */
+    FirebaseJsonArena(size_t chunkSize, bool psram) : _chunkSize(chunkSize < 256 ? 256 : chunkSize), _psram(psram)
+    {
+        lock();
+        _next = head();
+        head() = this;
+        count()++;
+        unlock();
+    }
+
+    ~FirebaseJsonArena()
+    {
+        lock();
+        FirebaseJsonArena **p = &head();
+        while (*p && *p != this)
+            p = &(*p)->_next;
+        if (*p)
+            *p = _next;
+        // no arena memory is left to be freed
+        if (--count() == 0)
+            low() = high() = nullptr;
+        unlock();
+
+        freeChunks(_chunks);
+        _chunks = nullptr;
+    }
+
+    /**
+     * Allocate the block.
+     * @param size The size of block.
+     * @return The block or NULL when out of memory.
+     */
+    void *allocate(size_t size)
+    {
+        // the size is kept in front of block for reallocate
+        size_t need = align(size + sizeof(size_t));
+
+        if (!_chunks || _chunks->used + need > _chunks->size)
+        {
+            size_t cap = need > _chunkSize ? need : _chunkSize;
+            chunk_t *c = newChunk(cap);
+            if (!c)
+                return NULL;
+            lock();
+            c->next = _chunks;
+            _chunks = c;
+            const uint8_t *d = data(c);
+            if (!low() || d < low())
+                low() = d;
+            if (d + c->size > high())
+                high() = d + c->size;
+            unlock();
+        }
+
+        uint8_t *p = data(_chunks) + _chunks->used;
+        _chunks->used += need;
+        _used += need;
+        if (_used > _peak)
+            _peak = _used;
+        *reinterpret_cast<size_t *>(p) = size;
+        return p + sizeof(size_t);
+    }
+
+    /**
+     * Get the size of block that was allocated from the arena.
+     * @param ptr The block.
+     * @return The requested size of block.
+     */
+    static size_t blockSize(const void *ptr)
+    {
+        return *reinterpret_cast<const size_t *>(reinterpret_cast<const uint8_t *>(ptr) - sizeof(size_t));
+    }
+
+    /**
+     * Free all blocks, the first chunk is kept for the next tree.
+     */
+    void reset()
+    {
+        if (!_chunks)
+            return;
+
+        // the oldest chunk is the last in list
+        chunk_t *first = _chunks;
+        while (first->next)
+            first = first->next;
+
+        lock();
+        chunk_t *rest = _chunks != first ? _chunks : nullptr;
+        _chunks = first;
+        unlock();
+
+        if (rest)
+        {
+            chunk_t *c = rest;
+            while (c->next != first)
+                c = c->next;
+            c->next = nullptr;
+            freeChunks(rest);
+        }
+
+        first->used = 0;
+        _used = 0;
+    }
+
+    // The bytes of the blocks that were allocated since the last reset.
+    size_t used() const { return _used; }
+
+    // The highest used bytes.
+    size_t peak() const { return _peak; }
+
+    // The bytes of the allocated chunks.
+    size_t capacity() const
+    {
+        size_t n = 0;
+        for (chunk_t *c = _chunks; c; c = c->next)
+            n += c->size;
+        return n;
+    }
+
+    /**
+     * Check whether the block belongs to any live arena.
+     * @param ptr The block.
+     * @return true when the block was allocated from the arena.
+     */
+    static bool owned(const void *ptr)
+    {
+        // the heap blocks outside of the address range of all chunks are not looked up
+        if (count() == 0 || ptr < low() || ptr >= high())
+            return false;
+
+        bool ret = false;
+        lock();
+        for (FirebaseJsonArena *a = head(); a && !ret; a = a->_next)
+        {
+            for (chunk_t *c = a->_chunks; c; c = c->next)
+            {
+                const uint8_t *d = data(c);
+                if (ptr >= d && ptr < d + c->size)
+                {
+                    ret = true;
+                    break;
+                }
+            }
+        }
+        unlock();
+        return ret;
+    }
+
+    // The arena of the calling thread that serves the allocations.
+    static FirebaseJsonArena *&current()
+    {
+#if defined(ESP8266)
+        static FirebaseJsonArena *cur = nullptr;
+#else
+        static thread_local FirebaseJsonArena *cur = nullptr;
+#endif
+        return cur;
+    }
+
+private:
+    struct chunk_t
+    {
+        chunk_t *next;
+        size_t size;
+        size_t used;
+    };
+
+    static size_t align(size_t n) { return (n + 7) & ~(size_t)7; }
+
+    static uint8_t *data(chunk_t *c) { return reinterpret_cast<uint8_t *>(c) + align(sizeof(chunk_t)); }
+
+    chunk_t *newChunk(size_t size)
+    {
+        size_t len = align(sizeof(chunk_t)) + size;
+        void *p = NULL;
+#if defined(ESP32) && defined(BOARD_HAS_PSRAM)
+        if (_psram && ESP.getPsramSize() > 0)
+            p = ps_malloc(len);
+#endif
+        if (!p)
+            p = malloc(len);
+        if (!p)
+            return nullptr;
+
+        chunk_t *c = reinterpret_cast<chunk_t *>(p);
+        c->next = nullptr;
+        c->size = size;
+        c->used = 0;
+        return c;
+    }
+
+    static void freeChunks(chunk_t *c)
+    {
+        while (c)
+        {
+            chunk_t *n = c->next;
+            free(c);
+            c = n;
+        }
+    }
+
+    static FirebaseJsonArena *&head()
+    {
+        static FirebaseJsonArena *h = nullptr;
+        return h;
+    }
+
+    static size_t &count()
+    {
+        static size_t n = 0;
+        return n;
+    }
+
+    // The lowest and highest addresses of the chunks that were allocated since the first live arena.
+    static const uint8_t *&low()
+    {
+        static const uint8_t *p = nullptr;
+        return p;
+    }
+
+    static const uint8_t *&high()
+    {
+        static const uint8_t *p = nullptr;
+        return p;
+    }
+
+#if defined(ESP32)
+    static portMUX_TYPE *mux()
+    {
+        static portMUX_TYPE m = portMUX_INITIALIZER_UNLOCKED;
+        return &m;
+    }
+#endif
+
+    static void lock()
+    {
+#if defined(ESP32)
+        portENTER_CRITICAL(mux());
+#endif
+    }
+
+    static void unlock()
+    {
+#if defined(ESP32)
+        portEXIT_CRITICAL(mux());
+#endif
+    }
+
+    chunk_t *_chunks = nullptr;
+    FirebaseJsonArena *_next = nullptr;
+    size_t _chunkSize = FIREBASE_JSON_ARENA_CHUNK_SIZE;
+    size_t _used = 0;
+    size_t _peak = 0;
+    bool _psram = false;
+};
+
+/* Make the arena and key pool current for the calling thread in this scope, the
+ * previous current ones are restored on exit. A null arena means the heap allocation
+ * and a null key pool means the own copy of keys, also inside the scope of another object.
+ */
+class FirebaseJsonArenaScope
+{
+public:
+    explicit FirebaseJsonArenaScope(FirebaseJsonArena *arena, FirebaseJsonKeyPool *keys = nullptr)
+        : _prev(FirebaseJsonArena::current()), _prevKeys(FirebaseJsonKeyPool::current())
+    {
+        FirebaseJsonArena::current() = arena;
+        FirebaseJsonKeyPool::current() = keys;
+    }
+
+    ~FirebaseJsonArenaScope()
+    {
+        FirebaseJsonArena::current() = _prev;
+        FirebaseJsonKeyPool::current() = _prevKeys;
+    }
+
+private:
+    FirebaseJsonArena *_prev;
+    FirebaseJsonKeyPool *_prevKeys;
+};
+
+#endif
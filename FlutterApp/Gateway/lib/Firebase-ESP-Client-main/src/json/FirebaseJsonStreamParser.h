@@ -0,0 +1,501 @@
+/*
+ * FirebaseJsonStreamParser, version 1.0.0
+ *
+ * Incremental MB_JSON tree builder for FirebaseJson.
+ *
+ * Created October 18, 2026
+ *
+ * The MIT License (MIT)
+ * Copyright (c) 2023 K. Suwatchai (Mobizt)
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person returning a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef FirebaseJsonStreamParser_H
+#define FirebaseJsonStreamParser_H
+
+#include <Arduino.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+#include "MB_JSON/MB_JSON.h"
+#ifdef __cplusplus
+}
+#endif
+
+// The maximum nesting level of the input JSON.
+#if !defined(FIREBASE_JSON_STREAM_MAX_NEST)
+#define FIREBASE_JSON_STREAM_MAX_NEST 32
+#endif
+
+/* Build the MB_JSON tree while the JSON text arrives, the input can be fed in any
+ * number of chunks and each chunk can be discarded as soon as feed() returns.
+ *
+ * The containers are linked into the tree when they open and the keys, strings
+ * and numbers are created when their token ends, so only the current token is
+ * kept (in the internal buffer which grows to the longest token). The primitive
+ * values are created by MB_JSON itself, the result is the same tree that
+ * MB_JSON_Parse gives for the whole text.
+ *
+ * The nodes are allocated through the MB_JSON hooks, the FirebaseJson arena
+ * applies when it is current while feeding.
+ */
+class FirebaseJsonStreamParser
+{
+public:
+    FirebaseJsonStreamParser() {}
+
+    ~FirebaseJsonStreamParser()
+    {
+        reset();
+        if (_tok)
+            free(_tok);
+    }
+
+    /**
+     * Reset the parser for the new input, the tree that was not released is freed.
+     *
+     * @param open The character that the root value must begin with e.g. '{', the
+     * data before it is skipped and the data after the root value is not consumed.
+     * Set 0 to accept any JSON text, the data after the root value is an error.
+     */
+    void begin(char open = 0)
+    {
+        reset();
+        _open = open;
+        _state = open ? st_skip : st_value;
+    }
+
+    /**
+     * Reset the parser for the new input, the open character is kept.
+     */
+    void clear() { reset(); }
+
+    /**
+     * Feed the JSON text.
+     *
+     * @param data The JSON text chunk.
+     * @param len The length of chunk.
+     * @return The number of bytes consumed, it is less than len when the root
+     * value was completed (with the open character) or on error (the bad byte is consumed).
+     */
+    size_t feed(const char *data, size_t len)
+    {
+        size_t i = 0;
+        while (i < len)
+        {
+            if (_state == st_error || (_state == st_done && _open))
+                break;
+
+            if (_state == st_in_str || _state == st_in_key)
+            {
+                // copy the plain characters of string at once
+                size_t j = i;
+                while (j < len && data[j] != '"' && data[j] != '\\')
+                    j++;
+                if (j > i)
+                {
+                    if (!append(data + i, j - i))
+                        break;
+                    _pos += j - i;
+                    i = j;
+                    continue;
+                }
+            }
+
+            step(data[i++]);
+            if (_state != st_error)
+                _pos++;
+        }
+        return i;
+    }
+
+    /**
+     * Terminate the input, completes the number or literal of a primitive root value.
+     * @return boolean status, true when the JSON text is complete.
+     */
+    bool finish()
+    {
+        if (_state == st_in_lit && _depth == 0)
+            endPrimitive();
+        return done();
+    }
+
+    // Check whether the root value was completed.
+    bool done() const { return _state == st_done; }
+
+    // Check whether the input is malformed, too deep or out of memory.
+    bool failed() const { return _state == st_error; }
+
+    // The position of the error or the number of bytes that were consumed.
+    size_t position() const { return _pos; }
+
+    /**
+     * Take the completed tree, it should be freed by MB_JSON_Delete.
+     * @return The tree or NULL when the JSON text is incomplete.
+     */
+    MB_JSON *release()
+    {
+        if (!done())
+            return NULL;
+        MB_JSON *e = _root;
+        _root = NULL;
+        return e;
+    }
+
+private:
+    enum parse_state
+    {
+        st_skip,
+        st_value,
+        st_key,
+        st_in_key,
+        st_in_key_esc,
+        st_colon,
+        st_in_str,
+        st_in_str_esc,
+        st_in_lit,
+        st_after,
+        st_done,
+        st_error
+    };
+
+    void reset()
+    {
+        if (_root)
+            MB_JSON_Delete(_root);
+        _root = NULL;
+        dropKey();
+        _depth = 0;
+        _tokLen = 0;
+        _pos = 0;
+        _empty = false;
+        _state = _open ? st_skip : st_value;
+    }
+
+    void step(char c)
+    {
+        switch (_state)
+        {
+        case st_skip:
+            if (c == _open)
+                beginValue(c);
+            return;
+
+        case st_value:
+            if (isSpace(c))
+                return;
+            if (c == ']' && _empty && isArr())
+                close();
+            else
+                beginValue(c);
+            return;
+
+        case st_key:
+            if (isSpace(c))
+                return;
+            if (c == '"')
+            {
+                _tokLen = 0;
+                _tokEsc = false;
+                if (push(c))
+                    _state = st_in_key;
+            }
+            else if (c == '}' && _empty)
+                close();
+            else
+                fail();
+            return;
+
+        case st_in_key:
+        case st_in_str:
+            if (!push(c))
+                return;
+            if (c == '\\')
+            {
+                _tokEsc = true;
+                _state = _state == st_in_key ? st_in_key_esc : st_in_str_esc;
+            }
+            else if (c == '"')
+            {
+                if (_state == st_in_key)
+                    endKey();
+                else
+                    endPrimitive();
+            }
+            return;
+
+        case st_in_key_esc:
+        case st_in_str_esc:
+            if (push(c))
+                _state = _state == st_in_key_esc ? st_in_key : st_in_str;
+            return;
+
+        case st_colon:
+            if (isSpace(c))
+                return;
+            if (c == ':')
+            {
+                _empty = false;
+                _state = st_value;
+            }
+            else
+                fail();
+            return;
+
+        case st_in_lit:
+            if (c == ',' || c == '}' || c == ']' || isSpace(c))
+            {
+                endPrimitive();
+                if (_state != st_error)
+                    step(c);
+            }
+            else if (_tokLen == 64)
+                fail(); // not a number or literal
+            else
+                push(c);
+            return;
+
+        case st_after:
+            if (isSpace(c))
+                return;
+            if (c == ',')
+            {
+                _empty = false;
+                _state = isArr() ? st_value : st_key;
+            }
+            else if ((c == '}' && !isArr()) || (c == ']' && isArr()))
+                close();
+            else
+                fail();
+            return;
+
+        case st_done:
+            // only the white spaces are allowed after the root value
+            if (!isSpace(c))
+                fail();
+            return;
+
+        default:
+            return;
+        }
+    }
+
+    void beginValue(char c)
+    {
+        if (c == '{' || c == '[')
+        {
+            if (_depth == FIREBASE_JSON_STREAM_MAX_NEST)
+            {
+                fail();
+                return;
+            }
+
+            MB_JSON *e = c == '{' ? MB_JSON_CreateObject() : MB_JSON_CreateArray();
+            if (!attach(e))
+                return;
+
+            _stack[_depth++] = e;
+            _empty = true;
+            _state = c == '{' ? st_key : st_value;
+        }
+        else if (c == '"' || c == '-' || (c >= '0' && c <= '9') || c == 't' || c == 'f' || c == 'n')
+        {
+            _tokLen = 0;
+            _tokEsc = false;
+            if (push(c))
+                _state = c == '"' ? st_in_str : st_in_lit;
+        }
+        else
+            fail();
+    }
+
+    void endKey()
+    {
+        dropKey();
+
+        if (!_tokEsc)
+        {
+            // the key text between the quotes as is, the shared copy when it was interned
+            size_t len = _tokLen - 2;
+            _key = const_cast<char *>(MB_JSON_InternKey(_tok + 1, len));
+            _keyShared = _key != NULL;
+            if (!_key)
+                _key = reinterpret_cast<char *>(MB_JSON_malloc(len + 1));
+            if (_key && !_keyShared)
+            {
+                memcpy(_key, _tok + 1, len);
+                _key[len] = 0;
+            }
+        }
+        else
+        {
+            // let MB_JSON unescape the key
+            MB_JSON *e = parseToken();
+            if (e)
+            {
+                _key = e->valuestring;
+                e->valuestring = NULL;
+                MB_JSON_Delete(e);
+            }
+        }
+
+        if (!_key)
+            fail();
+        else
+            _state = st_colon;
+    }
+
+    void endPrimitive()
+    {
+        MB_JSON *e = NULL;
+        if (_tok[0] == '"' && !_tokEsc)
+        {
+            _tok[_tokLen - 1] = 0;
+            e = MB_JSON_CreateString(_tok + 1);
+        }
+        else if (_tokLen == 4 && memcmp(_tok, "true", 4) == 0)
+            e = MB_JSON_CreateTrue();
+        else if (_tokLen == 5 && memcmp(_tok, "false", 5) == 0)
+            e = MB_JSON_CreateFalse();
+        else if (_tokLen == 4 && memcmp(_tok, "null", 4) == 0)
+            e = MB_JSON_CreateNull();
+        else if (_tok[0] == '"' || _tok[0] == '-' || (_tok[0] >= '0' && _tok[0] <= '9'))
+            e = parseToken();
+
+        if (!e)
+        {
+            fail();
+            return;
+        }
+
+        if (attach(e))
+            _state = _depth > 0 ? st_after : st_done;
+    }
+
+    // Parse the whole token (escaped string or number), NULL when it is not one valid value.
+    MB_JSON *parseToken()
+    {
+        const char *end = NULL;
+        MB_JSON *e = MB_JSON_ParseWithLengthOpts(_tok, _tokLen, &end, 0);
+        if (e && end != _tok + _tokLen)
+        {
+            MB_JSON_Delete(e);
+            e = NULL;
+        }
+        return e;
+    }
+
+    bool attach(MB_JSON *e)
+    {
+        if (!e)
+        {
+            fail();
+            return false;
+        }
+
+        if (_depth == 0)
+        {
+            _root = e;
+            return true;
+        }
+
+        MB_JSON *parent = _stack[_depth - 1];
+        if (!isArr())
+        {
+            e->string = _key;
+            if (_keyShared)
+                e->type |= MB_JSON_StringIsConst;
+            _key = NULL;
+            _keyShared = false;
+        }
+        MB_JSON_AddItemToArray(parent, e);
+        return true;
+    }
+
+    void close()
+    {
+        _depth--;
+        _empty = false;
+        _state = _depth > 0 ? st_after : st_done;
+    }
+
+    bool push(char c) { return append(&c, 1); }
+
+    bool append(const char *data, size_t len)
+    {
+        // one more byte for the string terminator
+        if (_tokLen + len + 1 > _tokCap)
+        {
+            size_t size = _tokCap ? _tokCap : 32;
+            while (size < _tokLen + len + 1)
+                size *= 2;
+            char *buf = reinterpret_cast<char *>(realloc(_tok, size));
+            if (!buf)
+            {
+                fail();
+                return false;
+            }
+            _tok = buf;
+            _tokCap = size;
+        }
+        memcpy(_tok + _tokLen, data, len);
+        _tokLen += len;
+        _tok[_tokLen] = 0;
+        return true;
+    }
+
+    void dropKey()
+    {
+        if (_key && !_keyShared)
+            MB_JSON_free(_key);
+        _key = NULL;
+        _keyShared = false;
+    }
+
+    void fail() { _state = st_error; }
+
+    bool isArr() const { return _depth > 0 && (_stack[_depth - 1]->type & 0xFF) == MB_JSON_Array; }
+
+    static bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+    MB_JSON *_root = NULL;
+    MB_JSON *_stack[FIREBASE_JSON_STREAM_MAX_NEST];
+    uint8_t _depth = 0;
+    uint8_t _state = st_value;
+    char _open = 0;
+    bool _empty = false;
+    bool _tokEsc = false;
+
+    // the pending key of object member
+    char *_key = NULL;
+    bool _keyShared = false;
+
+    // the current token
+    char *_tok = NULL;
+    size_t _tokLen = 0;
+    size_t _tokCap = 0;
+
+    // the absolute input position
+    size_t _pos = 0;
+};
+
+#endif
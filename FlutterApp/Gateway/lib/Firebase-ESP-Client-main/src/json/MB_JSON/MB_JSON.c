@@ -55,6 +55,11 @@
 #include <limits.h>
 #include <ctype.h>
 #include <float.h>
+#include <stdint.h>
+
+#if defined(ESP8266)
+#include <pgmspace.h>
+#endif
 
 #ifdef ENABLE_LOCALES
 #include <locale.h>
@@ -202,6 +207,8 @@ static void *MB_JSON_CDECL internal_realloc(void *pointer, size_t size)
 
 static MB_JSON_internal_hooks MB_JSON_global_hooks = {MB_JSON_internal_malloc, MB_JSON_internal_free, MB_JSON_internal_realloc};
 
+static MB_JSON_KeyHook MB_JSON_key_hook = NULL;
+
 static unsigned char *MB_JSON_strdup(const unsigned char *string, const MB_JSON_internal_hooks *const hooks)
 {
     size_t length = 0;
@@ -255,6 +262,23 @@ MB_JSON_InitHooks(MB_JSON_Hooks *hooks)
     }
 }
 
+MB_JSON_PUBLIC(void)
+MB_JSON_InitKeyHook(MB_JSON_KeyHook hook)
+{
+    MB_JSON_key_hook = hook;
+}
+
+MB_JSON_PUBLIC(const char *)
+MB_JSON_InternKey(const char *key, size_t len)
+{
+    if ((MB_JSON_key_hook == NULL) || (key == NULL))
+    {
+        return NULL;
+    }
+
+    return MB_JSON_key_hook(key, len);
+}
+
 /* Internal constructor. */
 static MB_JSON *MB_JSON_New_Item(const MB_JSON_internal_hooks *const hooks)
 {
@@ -320,6 +344,126 @@ typedef struct
 /* get a pointer to the buffer at the position */
 #define MB_JSON_buffer_at_offset(buffer) ((buffer)->content + (buffer)->offset)
 
+/* The exact powers of ten of double for the number fast paths */
+static const double MB_JSON_pow10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                       1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+/* Parse the plain decimal number in place without copying it.
+ * Only the numbers with up to 15 significant digits and a small decimal exponent
+ * are taken, which are converted exactly (one correctly rounded multiplication or division),
+ * the other numbers are left to strtod. */
+static MB_JSON_bool MB_JSON_parse_number_fast(const unsigned char *s, size_t length, double *number, size_t *consumed)
+{
+    size_t i = 0;
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    MB_JSON_bool negative = false;
+
+    if (i < length && s[i] == '-')
+    {
+        negative = true;
+        i++;
+    }
+
+    if (i >= length || s[i] < '0' || s[i] > '9')
+    {
+        return false;
+    }
+
+    while (i < length && s[i] >= '0' && s[i] <= '9')
+    {
+        if (mantissa > 0 || s[i] != '0')
+        {
+            digits++;
+        }
+        mantissa = mantissa * 10 + (uint64_t)(s[i] - '0');
+        if (digits > 15)
+        {
+            return false;
+        }
+        i++;
+    }
+
+    if (i < length && s[i] == '.')
+    {
+        i++;
+        while (i < length && s[i] >= '0' && s[i] <= '9')
+        {
+            if (mantissa > 0 || s[i] != '0')
+            {
+                digits++;
+            }
+            mantissa = mantissa * 10 + (uint64_t)(s[i] - '0');
+            exponent--;
+            if (digits > 15 || exponent < -22)
+            {
+                return false;
+            }
+            i++;
+        }
+    }
+
+    if (i < length && (s[i] == 'e' || s[i] == 'E'))
+    {
+        size_t j = i + 1;
+        int sign = 1;
+        int e = 0;
+
+        if (j < length && (s[j] == '+' || s[j] == '-'))
+        {
+            sign = (s[j] == '-') ? -1 : 1;
+            j++;
+        }
+
+        /* the exponent without digits is not a part of number */
+        if (j < length && s[j] >= '0' && s[j] <= '9')
+        {
+            while (j < length && s[j] >= '0' && s[j] <= '9')
+            {
+                if (e < 1000)
+                {
+                    e = e * 10 + (s[j] - '0');
+                }
+                j++;
+            }
+            exponent += sign * e;
+            i = j;
+        }
+    }
+
+    /* the input is too long for the strtod buffer, let the slow path handle it the same way */
+    if (i >= 63)
+    {
+        return false;
+    }
+
+    if (mantissa == 0)
+    {
+        *number = 0.0;
+    }
+    else if (exponent >= 0 && exponent <= 22)
+    {
+        *number = (double)mantissa * MB_JSON_pow10[exponent];
+    }
+    else if (exponent < 0 && exponent >= -22)
+    {
+        *number = (double)mantissa / MB_JSON_pow10[-exponent];
+    }
+    else
+    {
+        return false;
+    }
+
+    if (negative)
+    {
+        *number = -*number;
+    }
+
+    *consumed = i;
+    return true;
+}
+
 /* Parse the input text to generate a number, and populate the result into item. */
 static MB_JSON_bool MB_JSON_parse_number(MB_JSON *const item, MB_JSON_parse_buffer *const input_buffer)
 {
@@ -334,6 +478,12 @@ static MB_JSON_bool MB_JSON_parse_number(MB_JSON *const item, MB_JSON_parse_buff
         return false;
     }
 
+    if (MB_JSON_parse_number_fast(MB_JSON_buffer_at_offset(input_buffer), input_buffer->length - input_buffer->offset, &number, &i))
+    {
+        input_buffer->offset += i;
+        goto number_end;
+    }
+
     /* copy the number into a temporary buffer and replace '.' with the decimal point
      * of the current locale (for strtod)
      * This also takes care of '\0' not necessarily being available for marking the end of the input */
@@ -375,6 +525,9 @@ loop_end:
         return false; /* parse_error */
     }
 
+    input_buffer->offset += (size_t)(after_end - number_c_string);
+
+number_end:
     item->valuedouble = number;
 
     /* use saturation in case of overflow */
@@ -393,7 +546,6 @@ loop_end:
 
     item->type = MB_JSON_Number;
 
-    input_buffer->offset += (size_t)(after_end - number_c_string);
     return true;
 }
 
@@ -454,6 +606,8 @@ typedef struct
     MB_JSON_bool noalloc;
     MB_JSON_bool format; /* is this print a formatted print */
     MB_JSON_internal_hooks hooks;
+    MB_JSON_write_fn write; /* when set, the printed text is flushed to it instead of growing the buffer */
+    void *write_ctx;
 } MB_JSON_printbuffer;
 
 typedef struct
@@ -492,6 +646,25 @@ static unsigned char *MB_JSON_ensure(MB_JSON_printbuffer *const p, size_t needed
         return p->buffer + p->offset;
     }
 
+    /* stream mode, hand the printed text over to the writer and reuse the window */
+    if ((p->write != NULL) && (p->offset > 0))
+    {
+        if (p->write(p->write_ctx, p->buffer, p->offset) != p->offset)
+        {
+            return NULL;
+        }
+
+        needed -= p->offset;
+        p->offset = 0;
+        p->buffer[0] = '\0';
+
+        if (needed <= p->length)
+        {
+            return p->buffer;
+        }
+        /* the single token is larger than the window, grow it below */
+    }
+
     if (p->noalloc)
     {
         return NULL;
@@ -570,6 +743,416 @@ static MB_JSON_bool MB_JSON_compare_double(double a, double b)
     return (fabs(a - b) <= maxVal * DBL_EPSILON);
 }
 
+/* Grisu2 shortest digits of double (Florian Loitsch, "Printing Floating-Point Numbers
+ * Quickly and Accurately with Integers"), the digits always read back to the same double. */
+typedef struct
+{
+    uint64_t f;
+    int e;
+} MB_JSON_diy_fp;
+
+#define MB_JSON_U64(x) ((uint64_t)(x##ULL))
+#define MB_JSON_DP_HIDDEN_BIT MB_JSON_U64(0x0010000000000000)
+
+#if defined(ESP8266)
+#define MB_JSON_NUM_PROGMEM PROGMEM
+#else
+#define MB_JSON_NUM_PROGMEM
+#endif
+
+/* 10^k for k = -348, -340, ..., 340 as the normalized 64-bit significand and binary exponent */
+static const uint64_t MB_JSON_cached_powers_f[] MB_JSON_NUM_PROGMEM = {
+    MB_JSON_U64(0xfa8fd5a0081c0288), MB_JSON_U64(0xbaaee17fa23ebf76), MB_JSON_U64(0x8b16fb203055ac76),
+    MB_JSON_U64(0xcf42894a5dce35ea), MB_JSON_U64(0x9a6bb0aa55653b2d), MB_JSON_U64(0xe61acf033d1a45df),
+    MB_JSON_U64(0xab70fe17c79ac6ca), MB_JSON_U64(0xff77b1fcbebcdc4f), MB_JSON_U64(0xbe5691ef416bd60c),
+    MB_JSON_U64(0x8dd01fad907ffc3c), MB_JSON_U64(0xd3515c2831559a83), MB_JSON_U64(0x9d71ac8fada6c9b5),
+    MB_JSON_U64(0xea9c227723ee8bcb), MB_JSON_U64(0xaecc49914078536d), MB_JSON_U64(0x823c12795db6ce57),
+    MB_JSON_U64(0xc21094364dfb5637), MB_JSON_U64(0x9096ea6f3848984f), MB_JSON_U64(0xd77485cb25823ac7),
+    MB_JSON_U64(0xa086cfcd97bf97f4), MB_JSON_U64(0xef340a98172aace5), MB_JSON_U64(0xb23867fb2a35b28e),
+    MB_JSON_U64(0x84c8d4dfd2c63f3b), MB_JSON_U64(0xc5dd44271ad3cdba), MB_JSON_U64(0x936b9fcebb25c996),
+    MB_JSON_U64(0xdbac6c247d62a584), MB_JSON_U64(0xa3ab66580d5fdaf6), MB_JSON_U64(0xf3e2f893dec3f126),
+    MB_JSON_U64(0xb5b5ada8aaff80b8), MB_JSON_U64(0x87625f056c7c4a8b), MB_JSON_U64(0xc9bcff6034c13053),
+    MB_JSON_U64(0x964e858c91ba2655), MB_JSON_U64(0xdff9772470297ebd), MB_JSON_U64(0xa6dfbd9fb8e5b88f),
+    MB_JSON_U64(0xf8a95fcf88747d94), MB_JSON_U64(0xb94470938fa89bcf), MB_JSON_U64(0x8a08f0f8bf0f156b),
+    MB_JSON_U64(0xcdb02555653131b6), MB_JSON_U64(0x993fe2c6d07b7fac), MB_JSON_U64(0xe45c10c42a2b3b06),
+    MB_JSON_U64(0xaa242499697392d3), MB_JSON_U64(0xfd87b5f28300ca0e), MB_JSON_U64(0xbce5086492111aeb),
+    MB_JSON_U64(0x8cbccc096f5088cc), MB_JSON_U64(0xd1b71758e219652c), MB_JSON_U64(0x9c40000000000000),
+    MB_JSON_U64(0xe8d4a51000000000), MB_JSON_U64(0xad78ebc5ac620000), MB_JSON_U64(0x813f3978f8940984),
+    MB_JSON_U64(0xc097ce7bc90715b3), MB_JSON_U64(0x8f7e32ce7bea5c70), MB_JSON_U64(0xd5d238a4abe98068),
+    MB_JSON_U64(0x9f4f2726179a2245), MB_JSON_U64(0xed63a231d4c4fb27), MB_JSON_U64(0xb0de65388cc8ada8),
+    MB_JSON_U64(0x83c7088e1aab65db), MB_JSON_U64(0xc45d1df942711d9a), MB_JSON_U64(0x924d692ca61be758),
+    MB_JSON_U64(0xda01ee641a708dea), MB_JSON_U64(0xa26da3999aef774a), MB_JSON_U64(0xf209787bb47d6b85),
+    MB_JSON_U64(0xb454e4a179dd1877), MB_JSON_U64(0x865b86925b9bc5c2), MB_JSON_U64(0xc83553c5c8965d3d),
+    MB_JSON_U64(0x952ab45cfa97a0b3), MB_JSON_U64(0xde469fbd99a05fe3), MB_JSON_U64(0xa59bc234db398c25),
+    MB_JSON_U64(0xf6c69a72a3989f5c), MB_JSON_U64(0xb7dcbf5354e9bece), MB_JSON_U64(0x88fcf317f22241e2),
+    MB_JSON_U64(0xcc20ce9bd35c78a5), MB_JSON_U64(0x98165af37b2153df), MB_JSON_U64(0xe2a0b5dc971f303a),
+    MB_JSON_U64(0xa8d9d1535ce3b396), MB_JSON_U64(0xfb9b7cd9a4a7443c), MB_JSON_U64(0xbb764c4ca7a44410),
+    MB_JSON_U64(0x8bab8eefb6409c1a), MB_JSON_U64(0xd01fef10a657842c), MB_JSON_U64(0x9b10a4e5e9913129),
+    MB_JSON_U64(0xe7109bfba19c0c9d), MB_JSON_U64(0xac2820d9623bf429), MB_JSON_U64(0x80444b5e7aa7cf85),
+    MB_JSON_U64(0xbf21e44003acdd2d), MB_JSON_U64(0x8e679c2f5e44ff8f), MB_JSON_U64(0xd433179d9c8cb841),
+    MB_JSON_U64(0x9e19db92b4e31ba9), MB_JSON_U64(0xeb96bf6ebadf77d9), MB_JSON_U64(0xaf87023b9bf0ee6b),
+};
+
+static const int16_t MB_JSON_cached_powers_e[] MB_JSON_NUM_PROGMEM = {
+    -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980, -954, -927,
+    -901, -874, -847, -821, -794, -768, -741, -715, -688, -661, -635, -608,
+    -582, -555, -529, -502, -475, -449, -422, -396, -369, -343, -316, -289,
+    -263, -236, -210, -183, -157, -130, -103, -77, -50, -24, 3, 30,
+    56, 83, 109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+    375, 402, 428, 455, 481, 508, 534, 561, 588, 614, 641, 667,
+    694, 720, 747, 774, 800, 827, 853, 880, 907, 933, 960, 986,
+    1013, 1039, 1066,
+};
+
+static const uint64_t MB_JSON_pow10_u64[] = {
+    MB_JSON_U64(1), MB_JSON_U64(10), MB_JSON_U64(100), MB_JSON_U64(1000), MB_JSON_U64(10000),
+    MB_JSON_U64(100000), MB_JSON_U64(1000000), MB_JSON_U64(10000000), MB_JSON_U64(100000000),
+    MB_JSON_U64(1000000000), MB_JSON_U64(10000000000), MB_JSON_U64(100000000000),
+    MB_JSON_U64(1000000000000), MB_JSON_U64(10000000000000), MB_JSON_U64(100000000000000),
+    MB_JSON_U64(1000000000000000), MB_JSON_U64(10000000000000000), MB_JSON_U64(100000000000000000),
+    MB_JSON_U64(1000000000000000000), MB_JSON_U64(10000000000000000000)};
+
+static MB_JSON_diy_fp MB_JSON_diy_mul(MB_JSON_diy_fp x, MB_JSON_diy_fp y)
+{
+    const uint64_t M32 = MB_JSON_U64(0xFFFFFFFF);
+    uint64_t a = x.f >> 32, b = x.f & M32, c = y.f >> 32, d = y.f & M32;
+    uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+    uint64_t tmp = (bd >> 32) + (ad & M32) + (bc & M32);
+    MB_JSON_diy_fp r;
+    tmp += MB_JSON_U64(1) << 31; /* round */
+    r.f = ac + (ad >> 32) + (bc >> 32) + (tmp >> 32);
+    r.e = x.e + y.e + 64;
+    return r;
+}
+
+static MB_JSON_diy_fp MB_JSON_diy_normalize(MB_JSON_diy_fp x)
+{
+    while (!(x.f & (MB_JSON_U64(1) << 63)))
+    {
+        x.f <<= 1;
+        x.e--;
+    }
+    return x;
+}
+
+static MB_JSON_diy_fp MB_JSON_cached_power(int e, int *K)
+{
+    MB_JSON_diy_fp r;
+    double dk = (-61 - e) * 0.30102999566398114 + 347;
+    int k = (int)dk;
+    unsigned index;
+
+    if (dk - k > 0.0)
+    {
+        k++;
+    }
+
+    index = (unsigned)((k >> 3) + 1);
+    *K = -(-348 + (int)(index << 3));
+
+#if defined(ESP8266)
+    memcpy_P(&r.f, &MB_JSON_cached_powers_f[index], sizeof(r.f));
+    r.e = (int16_t)pgm_read_word(&MB_JSON_cached_powers_e[index]);
+#else
+    r.f = MB_JSON_cached_powers_f[index];
+    r.e = MB_JSON_cached_powers_e[index];
+#endif
+    return r;
+}
+
+static void MB_JSON_grisu_round(unsigned char *buffer, int len, uint64_t delta, uint64_t rest, uint64_t ten_kappa, uint64_t wp_w)
+{
+    while (rest < wp_w && delta - rest >= ten_kappa &&
+           (rest + ten_kappa < wp_w || wp_w - rest > rest + ten_kappa - wp_w))
+    {
+        buffer[len - 1]--;
+        rest += ten_kappa;
+    }
+}
+
+static void MB_JSON_digit_gen(MB_JSON_diy_fp W, MB_JSON_diy_fp Mp, uint64_t delta, unsigned char *buffer, int *len, int *K)
+{
+    MB_JSON_diy_fp one;
+    uint64_t wp_w = Mp.f - W.f;
+    uint32_t p1;
+    uint64_t p2;
+    int kappa = 0;
+
+    one.f = MB_JSON_U64(1) << -Mp.e;
+    one.e = Mp.e;
+    p1 = (uint32_t)(Mp.f >> -one.e);
+    p2 = Mp.f & (one.f - 1);
+
+    while (kappa < 10 && p1 >= MB_JSON_pow10_u64[kappa])
+    {
+        kappa++;
+    }
+
+    *len = 0;
+    while (kappa > 0)
+    {
+        uint32_t div = (uint32_t)MB_JSON_pow10_u64[kappa - 1];
+        uint32_t d = p1 / div;
+        uint64_t tmp;
+        p1 %= div;
+        if (d || *len)
+        {
+            buffer[(*len)++] = (unsigned char)('0' + d);
+        }
+        kappa--;
+        tmp = ((uint64_t)p1 << -one.e) + p2;
+        if (tmp <= delta)
+        {
+            *K += kappa;
+            MB_JSON_grisu_round(buffer, *len, delta, tmp, MB_JSON_pow10_u64[kappa] << -one.e, wp_w);
+            return;
+        }
+    }
+
+    for (;;)
+    {
+        unsigned char d;
+        p2 *= 10;
+        delta *= 10;
+        d = (unsigned char)(p2 >> -one.e);
+        if (d || *len)
+        {
+            buffer[(*len)++] = (unsigned char)('0' + d);
+        }
+        p2 &= one.f - 1;
+        kappa--;
+        if (p2 < delta)
+        {
+            *K += kappa;
+            MB_JSON_grisu_round(buffer, *len, delta, p2, one.f, wp_w * (-kappa < 20 ? MB_JSON_pow10_u64[-kappa] : 0));
+            return;
+        }
+    }
+}
+
+/* The shortest digits of the positive finite non-zero value, value = digits * 10^K */
+static int MB_JSON_grisu2(double value, unsigned char *buffer, int *K)
+{
+    MB_JSON_diy_fp v, w, w_p, w_m, c_mk, W, Wp, Wm;
+    uint64_t bits;
+    int biased_e;
+    int len = 0;
+
+    memcpy(&bits, &value, sizeof(bits));
+    biased_e = (int)((bits & MB_JSON_U64(0x7FF0000000000000)) >> 52);
+    v.f = bits & MB_JSON_U64(0x000FFFFFFFFFFFFF);
+    if (biased_e != 0)
+    {
+        v.f += MB_JSON_DP_HIDDEN_BIT;
+        v.e = biased_e - 1075;
+    }
+    else
+    {
+        v.e = -1074;
+    }
+
+    /* the boundaries of value */
+    w_p.f = (v.f << 1) + 1;
+    w_p.e = v.e - 1;
+    while (!(w_p.f & (MB_JSON_DP_HIDDEN_BIT << 1)))
+    {
+        w_p.f <<= 1;
+        w_p.e--;
+    }
+    w_p.f <<= 10;
+    w_p.e -= 10;
+
+    if (v.f == MB_JSON_DP_HIDDEN_BIT)
+    {
+        w_m.f = (v.f << 2) - 1;
+        w_m.e = v.e - 2;
+    }
+    else
+    {
+        w_m.f = (v.f << 1) - 1;
+        w_m.e = v.e - 1;
+    }
+    w_m.f <<= w_m.e - w_p.e;
+    w_m.e = w_p.e;
+
+    c_mk = MB_JSON_cached_power(w_p.e, K);
+    w = MB_JSON_diy_normalize(v);
+    W = MB_JSON_diy_mul(w, c_mk);
+    Wp = MB_JSON_diy_mul(w_p, c_mk);
+    Wm = MB_JSON_diy_mul(w_m, c_mk);
+    Wm.f++;
+    Wp.f--;
+    MB_JSON_digit_gen(W, Wp, Wp.f - Wm.f, buffer, &len, K);
+    return len;
+}
+
+/* Round the digits to 15 digits, keep them when they read back to the value within
+ * MB_JSON_compare_double (as the former "%1.15g" check did) */
+static MB_JSON_bool MB_JSON_round_digits15(double d, unsigned char *digits, int *n, int *K)
+{
+    unsigned char r[16];
+    int len = 15, k = *K + (*n - 15), i = 0;
+    char text[40];
+    double test = 0;
+
+    memcpy(r, digits, 15);
+    if (digits[15] >= '5')
+    {
+        for (i = 14; i >= 0; i--)
+        {
+            if (r[i] < '9')
+            {
+                r[i]++;
+                break;
+            }
+            r[i] = '0';
+        }
+        if (i < 0)
+        {
+            /* 999...9 was rounded up to 1000...0 */
+            r[0] = '1';
+            len = 1;
+            k += 15;
+        }
+    }
+
+    while (len > 1 && r[len - 1] == '0')
+    {
+        len--;
+        k++;
+    }
+
+    if (k >= -22 && k <= 22)
+    {
+        /* exact as the fast path of parser */
+        uint64_t m = 0;
+        for (i = 0; i < len; i++)
+        {
+            m = m * 10 + (uint64_t)(r[i] - '0');
+        }
+        test = k < 0 ? (double)m / MB_JSON_pow10[-k] : (double)m * MB_JSON_pow10[k];
+    }
+    else
+    {
+        memcpy(text, r, (size_t)len);
+        sprintf(text + len, "e%d", k);
+        test = strtod(text, NULL);
+    }
+
+    if (!MB_JSON_compare_double(test, d))
+    {
+        return false;
+    }
+
+    memcpy(digits, r, (size_t)len);
+    *n = len;
+    *K = k;
+    return true;
+}
+
+/* Print the number in the same notation as printf "%g" with the precision of 15
+ * (17 for the numbers that need more than 15 digits), but with the shortest digits
+ * that round trip instead of the printf-and-scanf retry. */
+static int MB_JSON_format_number(double d, unsigned char *out)
+{
+    unsigned char digits[24];
+    int n = 0, K = 0, X = 0, precision = 15, i = 0, pos = 0;
+
+    if (d == 0)
+    {
+        /* keep the sign of negative zero as printf does */
+        if (signbit(d))
+        {
+            out[pos++] = '-';
+        }
+        out[pos++] = '0';
+        out[pos] = '\0';
+        return pos;
+    }
+
+    if (d < 0)
+    {
+        out[pos++] = '-';
+        d = -d;
+    }
+
+    /* integer fast path */
+    if (d < 1e15 && d == (double)(uint64_t)d)
+    {
+        uint64_t u = (uint64_t)d;
+        unsigned char tmp[20];
+        while (u > 0)
+        {
+            tmp[n++] = (unsigned char)('0' + (u % 10));
+            u /= 10;
+        }
+        while (n > 0)
+        {
+            out[pos++] = tmp[--n];
+        }
+        out[pos] = '\0';
+        return pos;
+    }
+
+    n = MB_JSON_grisu2(d, digits, &K);
+    if (n > 15 && !MB_JSON_round_digits15(d, digits, &n, &K))
+    {
+        precision = 17;
+    }
+
+    /* the decimal exponent of the first digit */
+    X = n + K - 1;
+
+    if (X < -4 || X >= precision)
+    {
+        int e = X < 0 ? -X : X;
+        out[pos++] = digits[0];
+        if (n > 1)
+        {
+            out[pos++] = '.';
+            for (i = 1; i < n; i++)
+            {
+                out[pos++] = digits[i];
+            }
+        }
+        out[pos++] = 'e';
+        out[pos++] = X < 0 ? '-' : '+';
+        if (e >= 100)
+        {
+            out[pos++] = (unsigned char)('0' + e / 100);
+        }
+        out[pos++] = (unsigned char)('0' + (e / 10) % 10);
+        out[pos++] = (unsigned char)('0' + e % 10);
+    }
+    else if (X >= 0)
+    {
+        for (i = 0; i <= X || i < n; i++)
+        {
+            if (i == X + 1)
+            {
+                out[pos++] = '.';
+            }
+            out[pos++] = i < n ? digits[i] : '0';
+        }
+    }
+    else
+    {
+        out[pos++] = '0';
+        out[pos++] = '.';
+        for (i = -1; i > X; i--)
+        {
+            out[pos++] = '0';
+        }
+        for (i = 0; i < n; i++)
+        {
+            out[pos++] = digits[i];
+        }
+    }
+
+    out[pos] = '\0';
+    return pos;
+}
+
 /* Render the number nicely from the given item into a string. */
 static MB_JSON_bool MB_JSON_print_number(const MB_JSON *const item, MB_JSON_printbuffer *const output_buffer)
 {
@@ -578,8 +1161,6 @@ static MB_JSON_bool MB_JSON_print_number(const MB_JSON *const item, MB_JSON_prin
     int length = 0;
     size_t i = 0;
     unsigned char number_buffer[26] = {0}; /* temporary buffer to print the number into */
-    unsigned char decimal_point = MB_JSON_get_decimal_point();
-    double test = 0.0;
 
     if (output_buffer == NULL)
     {
@@ -593,15 +1174,7 @@ static MB_JSON_bool MB_JSON_print_number(const MB_JSON *const item, MB_JSON_prin
     }
     else
     {
-        /* Try 15 decimal places of precision to avoid nonsignificant nonzero digits */
-        length = sprintf((char *)number_buffer, "%1.15g", d);
-
-        /* Check whether the original double can be recovered */
-        if ((sscanf((char *)number_buffer, "%lg", &test) != 1) || !MB_JSON_compare_double((double)test, d))
-        {
-            /* If not, print with 17 decimal places of precision */
-            length = sprintf((char *)number_buffer, "%1.17g", d);
-        }
+        length = MB_JSON_format_number(d, number_buffer);
     }
 
     /* sprintf failed or buffer overrun occurred */
@@ -617,19 +1190,11 @@ static MB_JSON_bool MB_JSON_print_number(const MB_JSON *const item, MB_JSON_prin
         return false;
     }
 
-    /* copy the printed number to the output and replace locale
-     * dependent decimal point with '.' */
-    for (i = 0; i < ((size_t)length); i++)
+    /* the formatter always uses '.' as the decimal point */
+    for (i = 0; i <= ((size_t)length); i++)
     {
-        if (number_buffer[i] == decimal_point)
-        {
-            output_pointer[i] = '.';
-            continue;
-        }
-
         output_pointer[i] = number_buffer[i];
     }
-    output_pointer[i] = '\0';
 
     output_buffer->offset += (size_t)length;
 
@@ -1358,7 +1923,7 @@ MB_JSON_PrintUnformatted(const MB_JSON *item)
 MB_JSON_PUBLIC(char *)
 MB_JSON_PrintBuffered(const MB_JSON *item, int prebuffer, MB_JSON_bool fmt)
 {
-    MB_JSON_printbuffer p = {0, 0, 0, 0, 0, 0, {0, 0, 0}};
+    MB_JSON_printbuffer p = {0, 0, 0, 0, 0, 0, {0, 0, 0}, 0, 0};
 
     if (prebuffer < 0)
     {
@@ -1389,7 +1954,7 @@ MB_JSON_PrintBuffered(const MB_JSON *item, int prebuffer, MB_JSON_bool fmt)
 MB_JSON_PUBLIC(MB_JSON_bool)
 MB_JSON_PrintPreallocated(MB_JSON *item, char *buffer, const int length, const MB_JSON_bool format)
 {
-    MB_JSON_printbuffer p = {0, 0, 0, 0, 0, 0, {0, 0, 0}};
+    MB_JSON_printbuffer p = {0, 0, 0, 0, 0, 0, {0, 0, 0}, 0, 0};
 
     if ((length < 0) || (buffer == NULL))
     {
@@ -1406,6 +1971,50 @@ MB_JSON_PrintPreallocated(MB_JSON *item, char *buffer, const int length, const M
     return MB_JSON_print_value(item, &p);
 }
 
+MB_JSON_PUBLIC(MB_JSON_bool)
+MB_JSON_PrintStream(const MB_JSON *item, const MB_JSON_bool format, size_t window, MB_JSON_write_fn write, void *ctx)
+{
+    MB_JSON_printbuffer p = {0, 0, 0, 0, 0, 0, {0, 0, 0}, 0, 0};
+    MB_JSON_bool ret = false;
+
+    if ((item == NULL) || (write == NULL))
+    {
+        return false;
+    }
+
+    if (window < 32)
+    {
+        window = 32;
+    }
+
+    p.buffer = (unsigned char *)MB_JSON_global_hooks.allocate(window);
+    if (!p.buffer)
+    {
+        return false;
+    }
+
+    p.length = window;
+    p.format = format;
+    p.hooks = MB_JSON_global_hooks;
+    p.write = write;
+    p.write_ctx = ctx;
+
+    if (MB_JSON_print_value(item, &p))
+    {
+        MB_JSON_update_offset(&p);
+        /* the tail of text */
+        ret = p.offset == 0 || write(ctx, p.buffer, p.offset) == p.offset;
+    }
+
+    /* the buffer was freed by ensure when growing failed */
+    if (p.buffer != NULL)
+    {
+        MB_JSON_global_hooks.deallocate(p.buffer);
+    }
+
+    return ret;
+}
+
 /* Parser core - when encountering text, process appropriately. */
 static MB_JSON_bool MB_JSON_parse_value(MB_JSON *const item, MB_JSON_parse_buffer *const input_buffer)
 {
@@ -1478,6 +2087,19 @@ static MB_JSON_bool MB_JSON_get_value_buffer_length(const MB_JSON *const item, M
         buf_len->size += 4;
         return true;
 
+    case MB_JSON_Number:
+    {
+        unsigned char number_buffer[26];
+        double d = item->valuedouble;
+
+        /* NaN and Infinity are printed as null */
+        if (isnan(d) || isinf(d))
+            buf_len->size += 4;
+        else
+            buf_len->size += (size_t)MB_JSON_format_number(d, number_buffer);
+        return true;
+    }
+
     case MB_JSON_Raw:
     {
 
@@ -1859,10 +2481,49 @@ static MB_JSON_bool MB_JSON_print_array(const MB_JSON *const item, MB_JSON_print
 }
 
 /* Build an object from the text. */
+/* Take the shared copy of the plain (not escaped) key at the buffer offset from the key hook
+ * and skip it, returns NULL and keeps the offset when the key should be parsed as usual. */
+static const char *MB_JSON_parse_shared_key(MB_JSON_parse_buffer *const input_buffer)
+{
+    const unsigned char *start = NULL;
+    const unsigned char *end = NULL;
+    const unsigned char *limit = NULL;
+    const char *key = NULL;
+
+    if ((MB_JSON_key_hook == NULL) || MB_JSON_cannot_access_at_index(input_buffer, 0) || (MB_JSON_buffer_at_offset(input_buffer)[0] != '\"'))
+    {
+        return NULL;
+    }
+
+    start = MB_JSON_buffer_at_offset(input_buffer) + 1;
+    limit = input_buffer->content + input_buffer->length;
+    for (end = start; (end < limit) && (*end != '\"'); end++)
+    {
+        if (*end == '\\')
+        {
+            return NULL;
+        }
+    }
+
+    if (end >= limit)
+    {
+        return NULL;
+    }
+
+    key = MB_JSON_key_hook((const char *)start, (size_t)(end - start));
+    if (key != NULL)
+    {
+        input_buffer->offset = (size_t)(end + 1 - input_buffer->content);
+    }
+
+    return key;
+}
+
 static MB_JSON_bool MB_JSON_parse_object(MB_JSON *const item, MB_JSON_parse_buffer *const input_buffer)
 {
     MB_JSON *head = NULL; /* linked list head */
     MB_JSON *current_item = NULL;
+    const char *shared_key = NULL;
 
     if (input_buffer->depth >= MB_JSON_NESTING_LIMIT)
     {
@@ -1918,16 +2579,20 @@ static MB_JSON_bool MB_JSON_parse_object(MB_JSON *const item, MB_JSON_parse_buff
         /* parse the name of the child */
         input_buffer->offset++;
         MB_JSON_buffer_skip_whitespace(input_buffer);
-        if (!MB_JSON_parse_string(current_item, input_buffer))
+        shared_key = MB_JSON_parse_shared_key(input_buffer);
+        if (shared_key == NULL)
         {
-            goto fail; /* failed to parse name */
+            if (!MB_JSON_parse_string(current_item, input_buffer))
+            {
+                goto fail; /* failed to parse name */
+            }
+
+            /* swap valuestring and string, because we parsed the name */
+            current_item->string = current_item->valuestring;
+            current_item->valuestring = NULL;
         }
         MB_JSON_buffer_skip_whitespace(input_buffer);
 
-        /* swap valuestring and string, because we parsed the name */
-        current_item->string = current_item->valuestring;
-        current_item->valuestring = NULL;
-
         if (MB_JSON_cannot_access_at_index(input_buffer, 0) || (MB_JSON_buffer_at_offset(input_buffer)[0] != ':'))
         {
             goto fail; /* invalid object */
@@ -1941,6 +2606,13 @@ static MB_JSON_bool MB_JSON_parse_object(MB_JSON *const item, MB_JSON_parse_buff
             goto fail; /* failed to parse value */
         }
         MB_JSON_buffer_skip_whitespace(input_buffer);
+
+        /* the value sets the type, mark the shared key after it */
+        if (shared_key != NULL)
+        {
+            current_item->string = (char *)shared_key;
+            current_item->type |= MB_JSON_StringIsConst;
+        }
     } while (MB_JSON_can_access_at_index(input_buffer, 0) && (MB_JSON_buffer_at_offset(input_buffer)[0] == ','));
 
     if (MB_JSON_cannot_access_at_index(input_buffer, 0) || (MB_JSON_buffer_at_offset(input_buffer)[0] != '}'))
@@ -1979,13 +2651,13 @@ static MB_JSON_bool MB_JSON_get_object_buffer_length(const MB_JSON *const item,
     //'{' or "{\n"
     length = (size_t)(buf_len->format && current_item != NULL ? 2 : 1); 
 
+    buf_len->size += length;
+
     //do nothing for empty object
     if (current_item != NULL)
     {
         buf_len->depth++;
 
-        buf_len->size += length;
-
         while (current_item)
         {
             //'\t'
@@ -2213,7 +2885,8 @@ static MB_JSON *MB_JSON_get_object_item(const MB_JSON *const object, const char
     current_element = object->child;
     if (case_sensitive)
     {
-        while ((current_element != NULL) && (current_element->string != NULL) && (strcmp(name, current_element->string) != 0))
+        /* the shared keys are compared by address first */
+        while ((current_element != NULL) && (current_element->string != NULL) && (current_element->string != name) && (strcmp(name, current_element->string) != 0))
         {
             current_element = current_element->next;
         }
@@ -2336,7 +3009,7 @@ static void *cast_away_const(const void *string)
 #pragma GCC diagnostic pop
 #endif
 
-static MB_JSON_bool MB_JSON_add_item_to_object(MB_JSON *const object, const char *const string, MB_JSON *const item, const MB_JSON_internal_hooks *const hooks, const MB_JSON_bool constant_key)
+static MB_JSON_bool MB_JSON_add_item_to_object(MB_JSON *const object, const char *string, MB_JSON *const item, const MB_JSON_internal_hooks *const hooks, MB_JSON_bool constant_key)
 {
     char *new_key = NULL;
     int new_type = MB_JSON_Invalid;
@@ -2346,6 +3019,17 @@ static MB_JSON_bool MB_JSON_add_item_to_object(MB_JSON *const object, const char
         return false;
     }
 
+    if (!constant_key && (MB_JSON_key_hook != NULL))
+    {
+        /* the shared copy is used as the constant key */
+        const char *shared_key = MB_JSON_key_hook(string, strlen(string));
+        if (shared_key != NULL)
+        {
+            string = shared_key;
+            constant_key = true;
+        }
+    }
+
     if (constant_key)
     {
         new_key = (char *)cast_away_const(string);
@@ -884,6 +884,8 @@ bool FB_CM::fcm_send(FirebaseData *fbdo, firebase_fcm_msg_mode mode, const char
 
     if (!ret || !msgMode)
         fbdo->closeSession();
+    else
+        fbdo->tcpClient.release();
 
     return ret;
 }
@@ -902,7 +904,8 @@ bool FB_CM::handleResponse(FirebaseData *fbdo)
     struct firebase_tcp_response_handler_t tcpHandler;
 
     Core.hh.initTCPSession(fbdo->session);
-    Core.hh.intTCPHandler(&fbdo->tcpClient, tcpHandler, 768, fbdo->session.resp_size, nullptr, false);
+    Core.hh.intTCPHandler(&fbdo->tcpClient, tcpHandler, 768, fbdo->session.resp_size, nullptr, false,
+                          fbdo->tcpClient.rxBuffer());
 
     if (!fbdo->waitResponse(tcpHandler))
         return false;
@@ -36,6 +36,10 @@
 
 #include "FB_RTDB.h"
 
+#if defined(ESP32)
+#include <freertos/timers.h>
+#endif
+
 FB_RTDB::FB_RTDB()
 {
 }
@@ -65,6 +69,118 @@ void FB_RTDB::mSetwriteSizeLimit(FirebaseData *fbdo, MB_StringPtr size)
     fbdo->session.rtdb.write_limit = size;
 }
 
+bool FB_RTDB::beginPipeline(FirebaseData *fbdo, RTDB_PipelineResultCallback callback)
+{
+    if (!fbdo)
+        return false;
+
+    // the waiting responses belong to the previous callback
+    flushPipeline(fbdo);
+
+    fbdo->session.rtdb.pipeline.enable = true;
+    fbdo->session.rtdb.pipeline.id = 0;
+    fbdo->session.rtdb.pipeline.cb = callback;
+    return true;
+}
+
+bool FB_RTDB::endPipeline(FirebaseData *fbdo)
+{
+    if (!fbdo)
+        return false;
+
+    bool ret = flushPipeline(fbdo);
+    fbdo->session.rtdb.pipeline.enable = false;
+    fbdo->session.rtdb.pipeline.cb = NULL;
+    return ret;
+}
+
+bool FB_RTDB::beginWriteCombiner(FirebaseData *fbdo, unsigned long deadline)
+{
+    if (!fbdo)
+        return false;
+
+    fbdo->session.rtdb.combiner.enable = true;
+    fbdo->session.rtdb.combiner.deadline_ms = deadline;
+    return true;
+}
+
+bool FB_RTDB::runWriteCombiner(FirebaseData *fbdo)
+{
+    if (!fbdo)
+        return false;
+
+    firebase_rtdb_write_combiner_t &combiner = fbdo->session.rtdb.combiner;
+
+    if (combiner.writes.size() > 0 && millis() - combiner.first_ms >= combiner.deadline_ms)
+        return flushWrites(fbdo);
+
+    return true;
+}
+
+bool FB_RTDB::flushWrites(FirebaseData *fbdo)
+{
+    if (!fbdo)
+        return false;
+
+    firebase_rtdb_write_combiner_t &combiner = fbdo->session.rtdb.combiner;
+
+    if (combiner.writes.size() == 0 || combiner.flushing)
+        return true;
+
+    // the update location is the deepest common parent of all paths
+    MB_String location = parentPath(combiner.writes[0].path);
+    for (size_t i = 1; i < combiner.writes.size(); i++)
+    {
+        MB_String parent = parentPath(combiner.writes[i].path);
+        while (!isSubPath(location, parent))
+            location = parentPath(location);
+    }
+
+    size_t ofs = location.length() > 1 ? location.length() + 1 : 1;
+
+    struct firebase_rtdb_request_info_t req;
+    req.path = location;
+    req.method = rtdb_update_nocontent;
+    req.data.type = d_json;
+
+    req.payload = firebase_pgm_str_10; // "{"
+    for (size_t i = 0; i < combiner.writes.size(); i++)
+    {
+        if (i > 0)
+            req.payload += firebase_pgm_str_3; // ","
+        req.payload += firebase_pgm_str_4;     // "\""
+        req.payload += combiner.writes[i].path.substr(ofs);
+        req.payload += firebase_pgm_str_4; // "\""
+        req.payload += firebase_pgm_str_2; // ":"
+        req.payload += combiner.writes[i].value;
+    }
+    req.payload += firebase_pgm_str_11; // "}"
+
+    fbdo->session.rtdb.queue_ID = 0;
+
+    combiner.flushing = true;
+    bool ret = processRequest(fbdo, &req);
+    combiner.flushing = false;
+
+    // the writes are kept for the next flush until they were sent or taken by the error queue
+    if (ret || fbdo->session.rtdb.queue_ID > 0)
+        MB_VECTOR<firebase_rtdb_combined_write_t>().swap(combiner.writes);
+    else
+        combiner.first_ms = millis();
+
+    return ret;
+}
+
+bool FB_RTDB::endWriteCombiner(FirebaseData *fbdo)
+{
+    if (!fbdo)
+        return false;
+
+    bool ret = flushWrites(fbdo);
+    fbdo->session.rtdb.combiner.enable = false;
+    return ret;
+}
+
 bool FB_RTDB::mGetRules(FirebaseData *fbdo, firebase_mem_storage_type storageType, MB_StringPtr filename,
                         RTDB_DownloadProgressCallback callback)
 {
@@ -463,6 +579,10 @@ bool FB_RTDB::buildRequest(FirebaseData *fbdo, firebase_request_method method, M
     if (type == d_file_ota)
         fbdo->closeSession();
 
+    int combined = combineWrite(fbdo, &req);
+    if (combined > -1)
+        return combined > 0;
+
     int rx_size = fbdo->session.bssl_rx_size;
     if (type == d_file_ota)
         fbdo->session.bssl_rx_size = 16384;
@@ -610,6 +730,16 @@ bool FB_RTDB::endStream(FirebaseData *fbdo)
     return true;
 }
 
+void FB_RTDB::beginStreamMirror(FirebaseData *fbdo, size_t maxSize)
+{
+    fbdo->_mirror.begin(maxSize);
+}
+
+void FB_RTDB::endStreamMirror(FirebaseData *fbdo)
+{
+    fbdo->_mirror.end();
+}
+
 bool FB_RTDB::handleStreamRead(FirebaseData *fbdo)
 {
 
@@ -796,12 +926,7 @@ void FB_RTDB::removeMultiPathStreamCallback(FirebaseData *fbdo)
 
 #if defined(ESP32)
     if (Core.internal.sessions.size() == 0)
-    {
-        if (Core.internal.stream_task_handle)
-            vTaskDelete(Core.internal.stream_task_handle);
-
-        Core.internal.stream_task_handle = NULL;
-    }
+        stopStreamTask();
 #endif
 }
 
@@ -814,21 +939,35 @@ void FB_RTDB::runStreamTask()
 
     static FB_RTDB *_this = this;
 
+    // the running task picks up the new session
+    if (Core.internal.stream_task_handle)
+    {
+        notifyStream();
+        return;
+    }
+
+    streamWakeInit();
+
     MB_String taskName = "Stream_";
     taskName += random(1, 100);
 
     TaskFunction_t taskCode = [](void *param)
     {
-        FirebaseConfig *config = (FirebaseConfig *)param;
-        const TickType_t xDelay = Core.internal.stream_task_delay_ms / portTICK_PERIOD_MS;
         for (;;)
         {
             if (!Core.internal.stream_loop_task_enable)
                 break;
             _this->mRunStream();
-            vTaskDelay(xDelay);
+            _this->waitStream();
         }
 
+        // the task owns the wake socket, the handle is cleared last so that
+        // runStreamTask creates the new socket only after this one was closed
+        int wakeFd = Core.internal.stream_wake_fd;
+        Core.internal.stream_wake_fd = -1;
+        if (wakeFd >= 0)
+            lwip_close(wakeFd);
+
         Core.internal.stream_task_handle = NULL;
 
         vTaskDelete(NULL);
@@ -852,7 +991,155 @@ void FB_RTDB::runStreamTask()
 void FB_RTDB::mStopStreamLoopTask()
 {
     Core.internal.stream_loop_task_enable = false;
+#if defined(ESP32)
+    notifyStream();
+#endif
+}
+
+#if defined(ESP32)
+void FB_RTDB::stopStreamTask()
+{
+    // the task may be blocked in select, deleting it from here leaves its select
+    // callback linked in lwIP, let it leave the loop and delete itself
+    Core.internal.stream_loop_task_enable = false;
+    notifyStream();
+}
+#endif
+
+void FB_RTDB::notifyStream()
+{
+#if defined(ESP32)
+    if (Core.internal.stream_wake_fd >= 0)
+    {
+        uint8_t b = 1;
+        lwip_send(Core.internal.stream_wake_fd, &b, 1, MSG_DONTWAIT);
+    }
+
+    if (Core.internal.stream_task_handle)
+        xTaskNotifyGive(Core.internal.stream_task_handle);
+#endif
+}
+
+#if defined(ESP32)
+void IRAM_ATTR FB_RTDB::notifyStreamFromISR()
+#else
+void FB_RTDB::notifyStreamFromISR()
+#endif
+{
+#if defined(ESP32)
+    BaseType_t woken = pdFALSE;
+    if (Core.internal.stream_task_handle)
+    {
+        vTaskNotifyGiveFromISR(Core.internal.stream_task_handle, &woken);
+        // the notification does not end the select, the wake socket is written
+        // from the timer task as sockets can't be used in the ISR
+        if (Core.internal.stream_wake_fd >= 0)
+            xTimerPendFunctionCallFromISR(streamWakeDeferred, NULL, 0, &woken);
+    }
+    if (woken)
+        portYIELD_FROM_ISR();
+#endif
+}
+
+#if defined(ESP32)
+void FB_RTDB::streamWakeDeferred(void *param, uint32_t value)
+{
+    int fd = Core.internal.stream_wake_fd;
+    if (fd >= 0)
+    {
+        uint8_t b = 1;
+        lwip_send(fd, &b, 1, MSG_DONTWAIT);
+    }
+}
+#endif
+
+#if defined(ESP32)
+void FB_RTDB::streamWakeInit()
+{
+    if (Core.internal.stream_wake_fd >= 0)
+        return;
+
+    // the UDP socket connected to itself, notifyStream sends one byte to wake the select
+    int fd = lwip_socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0)
+        return;
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+
+    if (lwip_bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        lwip_getsockname(fd, (struct sockaddr *)&addr, &len) < 0 ||
+        lwip_connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        lwip_close(fd);
+        return;
+    }
+
+    Core.internal.stream_wake_fd = fd;
+}
+
+void FB_RTDB::waitStream()
+{
+    int wakeFd = Core.internal.stream_wake_fd;
+    // without the wake socket, wait for the delay as before
+    bool polled = wakeFd < 0;
+    int maxFd = wakeFd;
+
+    fd_set rfds;
+    FD_ZERO(&rfds);
+    if (wakeFd >= 0)
+        FD_SET(wakeFd, &rfds);
+
+    for (size_t id = 0; id < Core.internal.sessions.size() && !polled; id++)
+    {
+        FirebaseData *fbdo = addrTo<FirebaseData *>(Core.internal.sessions[id].ptr);
+
+        if (!fbdo || !(fbdo->_dataAvailableCallback || fbdo->_multiPathDataCallback || fbdo->_timeoutCallback))
+            continue;
+
+        // the data that was already received by the client (SSL record and rx buffers) is not seen by select
+        if (fbdo->tcpClient.available() > 0)
+        {
+            taskYIELD();
+            return;
+        }
+
+        // not connected (reconnecting) or the external client
+        int fd = fbdo->session.con_mode == firebase_con_mode_rtdb_stream ? fbdo->tcpClient.socket() : -1;
+        if (fd < 0)
+        {
+            polled = true;
+            break;
+        }
+
+        FD_SET(fd, &rfds);
+        if (fd > maxFd)
+            maxFd = fd;
+    }
+
+    if (polled)
+    {
+        ulTaskNotifyTake(pdTRUE, Core.internal.stream_task_delay_ms / portTICK_PERIOD_MS);
+        return;
+    }
+
+    struct timeval tv;
+    tv.tv_sec = FIREBASE_STREAM_IDLE_WAKE_MS / 1000;
+    tv.tv_usec = (FIREBASE_STREAM_IDLE_WAKE_MS % 1000) * 1000;
+
+    if (lwip_select(maxFd + 1, &rfds, NULL, NULL, &tv) > 0 && FD_ISSET(wakeFd, &rfds))
+    {
+        uint8_t buf[16];
+        while (lwip_recv(wakeFd, buf, sizeof(buf), MSG_DONTWAIT) > 0)
+            ;
+    }
+
+    ulTaskNotifyTake(pdTRUE, 0);
 }
+#endif
 
 void FB_RTDB::mRunStream()
 {
@@ -908,11 +1195,13 @@ void FB_RTDB::setBlobRef(FirebaseData *fbdo, int addr)
 
 void FB_RTDB::addQueueData(FirebaseData *fbdo, struct firebase_rtdb_request_info_t *req)
 {
-    if (req->method == http_get || (!req->queue && (req->method == http_put ||
-                                                    req->method == rtdb_set_nocontent ||
-                                                    req->method == http_post ||
-                                                    req->method == http_patch ||
-                                                    req->method == rtdb_update_nocontent)))
+    // the replayed item (req->queue) stays where it is
+    if (!req->queue && (req->method == http_get ||
+                        req->method == http_put ||
+                        req->method == rtdb_set_nocontent ||
+                        req->method == http_post ||
+                        req->method == http_patch ||
+                        req->method == rtdb_update_nocontent))
     {
         QueueItem qItem;
         qItem.method = req->method;
@@ -926,7 +1215,20 @@ void FB_RTDB::addQueueData(FirebaseData *fbdo, struct firebase_rtdb_request_info
         qItem.etag = req->data.etag;
         qItem.async = req->async;
         qItem.blobSize = req->data.blobSize;
-        fbdo->addQueue(&qItem);
+
+        // the writes go to the queue file when it was opened
+        if (fbdo->_qMan._logEnable && req->method != http_get)
+        {
+            uint32_t qID = random(100000, 200000);
+            qItem.qID = qID;
+            if (appendQueueRecord(fbdo, qItem))
+            {
+                fbdo->session.rtdb.queue_ID = qID;
+                return;
+            }
+        }
+
+        fbdo->addQueue(std::move(qItem));
     }
 }
 
@@ -965,49 +1267,127 @@ void FB_RTDB::processErrorQueue(FirebaseData *fbdo, FirebaseData::QueueInfoCallb
     if (!fbdo->reconnect())
         return;
 
-    if (fbdo->_qMan.size() > 0)
+    // the items that fail again are appended by addQueueData, only visit the current ones
+    size_t n = fbdo->_qMan.size();
+    size_t i = 0;
+
+    while (i < n && i < fbdo->_qMan.size())
     {
+        // take the item out instead of copying it, it is put back when the request failed
+        QueueItem item = std::move((*fbdo->_qMan._queueCollection)[i]);
 
-        for (uint8_t i = 0; i < fbdo->_qMan.size(); i++)
+        if (item.qID == 0)
         {
-            if (!fbdo->_qMan._queueCollection)
-                return;
+            fbdo->_qMan.remove(i);
+            n--;
+            continue;
+        }
 
-            QueueItem item = fbdo->_qMan._queueCollection->at(i);
+        if (callback)
+        {
+            QueueInfo qinfo;
+            qinfo._isQueue = true;
+            qinfo._dataType = fbdo->getDataType(item.dataType);
+            qinfo._path = item.path;
+            qinfo._currentQueueID = item.qID;
+            qinfo._method = fbdo->getMethod(item.method);
+            qinfo._totalQueue = fbdo->_qMan.size();
+            qinfo._isQueueFull = fbdo->_qMan.size() == fbdo->_qMan._maxQueue;
+            callback(qinfo);
+        }
 
-            if (item.qID == 0)
-            {
-                fbdo->clearQueueItem(&item);
-                fbdo->_qMan.remove(i);
-                continue;
-            }
+        FBUtils::idle();
+        if (replayQueueItem(fbdo, item))
+        {
+            fbdo->_qMan.remove(i);
+            n--;
+        }
+        else
+        {
+            (*fbdo->_qMan._queueCollection)[i] = std::move(item);
+            i++;
+        }
+    }
 
-            if (callback)
-            {
-                QueueInfo qinfo;
-                qinfo._isQueue = true;
-                qinfo._dataType = fbdo->getDataType(item.dataType);
-                qinfo._path = item.path;
-                qinfo._currentQueueID = item.qID;
-                qinfo._method = fbdo->getMethod(item.method);
-                qinfo._totalQueue = fbdo->_qMan.size();
-                qinfo._isQueueFull = fbdo->_qMan.size() == fbdo->_qMan._maxQueue;
-                callback(qinfo);
-            }
+    processQueueFile(fbdo, callback);
+}
 
-            FBUtils::idle();
-            if (buildRequest(fbdo, item.method, MB_StringPtr(toAddr(item.path), mb_string_sub_type_mb_string),
-                             MB_StringPtr(toAddr(item.payload), mb_string_sub_type_mb_string), item.dataType,
-                             item.subType, item.method == http_get ? item.address.dout : item.address.din, item.address.query,
-                             item.address.priority, MB_StringPtr(toAddr(item.etag), mb_string_sub_type_mb_string),
-                             item.async, _NO_QUEUE, item.blobSize,
-                             MB_StringPtr(toAddr(item.filename), mb_string_sub_type_mb_string),
-                             (firebase_mem_storage_type)item.storageType))
+bool FB_RTDB::replayQueueItem(FirebaseData *fbdo, QueueItem &item)
+{
+    return buildRequest(fbdo, item.method, MB_StringPtr(toAddr(item.path), mb_string_sub_type_mb_string),
+                        MB_StringPtr(toAddr(item.payload), mb_string_sub_type_mb_string), item.dataType,
+                        item.subType, item.method == http_get ? item.address.dout : item.address.din, item.address.query,
+                        item.address.priority, MB_StringPtr(toAddr(item.etag), mb_string_sub_type_mb_string),
+                        item.async, true /* from queue, not queued again */, item.blobSize,
+                        MB_StringPtr(toAddr(item.filename), mb_string_sub_type_mb_string),
+                        (firebase_mem_storage_type)item.storageType);
+}
+
+void FB_RTDB::processQueueFile(FirebaseData *fbdo, FirebaseData::QueueInfoCallback callback)
+{
+    QueueManager &q = fbdo->_qMan;
+    firebase_mem_storage_type storageType = (firebase_mem_storage_type)q._logStorage;
+    MB_VECTOR<uint8_t> buf;
+    QueueItem item;
+
+    // in order, stop at the first failure
+    for (uint16_t i = 0; i < FIREBASE_ERROR_QUEUE_REPLAY_BATCH && q._logEnable && q._logCount > 0; i++)
+    {
+        // the file is closed before the request, the request may use the same storage
+        int ret = Core.mbfs.open(q._logFile, mbfs_type storageType, mb_fs_open_mode_read);
+        if (ret < 0)
+        {
+            fbdo->session.response.code = ret;
+            return;
+        }
+
+        int size = Core.mbfs.seek(mbfs_type storageType, q._logHead) ? readQueueRecord(storageType, &item, buf) : -1;
+        Core.mbfs.close(mbfs_type storageType);
+
+        if (size <= 0)
+        {
+            // the records were verified when the file was opened, retry the read error with
+            // the next call and rescan the file only when it keeps failing at the same record
+            fbdo->session.response.code = MB_FS_ERROR_FILE_IO_ERROR;
+            if (++q._logReadFail >= FIREBASE_ERROR_QUEUE_READ_RETRY)
             {
-                fbdo->clearQueueItem(&item);
-                fbdo->_qMan.remove(i);
+                q._logReadFail = 0;
+                if (recoverQueueFile(fbdo))
+                    scanQueueFile(fbdo);
             }
+            return;
+        }
+
+        q._logReadFail = 0;
+
+        if (callback)
+        {
+            QueueInfo qinfo;
+            qinfo._isQueue = true;
+            qinfo._dataType = fbdo->getDataType(item.dataType);
+            qinfo._path = item.path;
+            qinfo._currentQueueID = item.qID;
+            qinfo._method = fbdo->getMethod(item.method);
+            qinfo._totalQueue = q._logCount > 255 ? 255 : q._logCount;
+            qinfo._isQueueFull = false;
+            callback(qinfo);
         }
+
+        FBUtils::idle();
+        if (!replayQueueItem(fbdo, item))
+            return;
+
+        q._logHead += size;
+        q._logCount--;
+
+        // the queue that is fed while it is replayed may never be empty, drop the replayed
+        // records when they take more than half of the file
+        if (q._logCount == 0)
+            resetQueueFile(fbdo);
+        else if (q._logHead >= FIREBASE_ERROR_QUEUE_COMPACT_SIZE && q._logHead >= q._logTail - q._logHead)
+            compactQueueFile(fbdo);
+        else
+            writeQueueHead(fbdo);
     }
 }
 
@@ -1018,11 +1398,11 @@ bool FB_RTDB::isErrorQueueExisted(FirebaseData *fbdo, uint32_t errorQueueID)
         if (!fbdo->_qMan._queueCollection)
             return false;
 
-        QueueItem q = fbdo->_qMan._queueCollection->at(i);
-        if (q.qID == errorQueueID)
+        if ((*fbdo->_qMan._queueCollection)[i].qID == errorQueueID)
             return true;
     }
-    return false;
+
+    return findQueueRecord(fbdo, errorQueueID);
 }
 
 #if defined(ESP32) || defined(ESP8266)
@@ -1113,31 +1493,18 @@ void FB_RTDB::endAutoRunErrorQueue(FirebaseData *fbdo)
 
 void FB_RTDB::clearErrorQueue(FirebaseData *fbdo)
 {
-    for (uint8_t i = 0; i < fbdo->_qMan.size(); i++)
-    {
-        if (!fbdo->_qMan._queueCollection)
-            return;
+    fbdo->_qMan.clear();
 
-        QueueItem item = fbdo->_qMan._queueCollection->at(i);
-        fbdo->clearQueueItem(&item);
-    }
+    if (fbdo->_qMan._logEnable)
+        resetQueueFile(fbdo);
 }
 
 void FB_RTDB::setMaxErrorQueue(FirebaseData *fbdo, uint8_t num)
 {
     fbdo->_qMan._maxQueue = num;
 
-    if (fbdo->_qMan.size() > num)
-    {
-        for (uint8_t i = fbdo->_qMan.size() - 1; i >= num; i--)
-        {
-            if (!fbdo->_qMan._queueCollection)
-                return;
-
-            QueueItem item = fbdo->_qMan._queueCollection->at(i);
-            fbdo->clearQueueItem(&item);
-        }
-    }
+    while (fbdo->_qMan.size() > num)
+        fbdo->_qMan.remove(fbdo->_qMan.size() - 1);
 }
 
 bool FB_RTDB::mSaveErrorQueue(FirebaseData *fbdo, MB_StringPtr filename, firebase_mem_storage_type storageType)
@@ -1160,24 +1527,22 @@ bool FB_RTDB::mSaveErrorQueue(FirebaseData *fbdo, MB_StringPtr filename, firebas
         !Core.mbfs.ready(mbfs_type storageType))
         return false;
 
-    FirebaseJsonArray arr;
-
     // required for ESP32 core 2.0.x
     Core.mbfs.open(_filename, mbfs_type storageType, mb_fs_open_mode_write);
 
+    MB_VECTOR<uint8_t> buf;
+    MB_String payload;
+
     for (uint8_t i = 0; i < fbdo->_qMan.size(); i++)
     {
-        if (!fbdo->_qMan._queueCollection)
+        const QueueItem &item = (*fbdo->_qMan._queueCollection)[i];
+
+        if (!queueRecordPayload(item, payload))
             continue;
 
-        QueueItem item = fbdo->_qMan._queueCollection->at(i);
-        arr.clear();
-        arr.add((uint8_t)item.dataType, (uint8_t)item.subType, (uint8_t)item.method,
-                (uint8_t)item.storageType, (uint8_t)item.async);
-        arr.add(item.address.din, item.address.dout, item.address.query,
-                item.address.priority, item.blobSize);
-        arr.add(item.path, item.payload, item.etag, item.filename);
-        Core.mbfs.write(mbfs_type storageType, (uint8_t *)arr.raw(), strlen(arr.raw()));
+        buf.clear();
+        QueueManager::encode(item, payload, buf);
+        Core.mbfs.write(mbfs_type storageType, buf.data(), buf.size());
     }
 
     Core.mbfs.close(mbfs_type storageType);
@@ -1213,218 +1578,414 @@ uint8_t FB_RTDB::openErrorQueue(FirebaseData *fbdo, MB_StringPtr filename,
         return 0;
     }
 
-    if (!Core.mbfs.available(mbfs_type storageType) || Core.mbfs.size(mbfs_type storageType) < 4)
-    {
-        Core.mbfs.close(mbfs_type storageType);
-        return 0;
-    }
-
+    MB_VECTOR<uint8_t> buf;
     QueueItem item;
 
-#if defined(MBFS_ESP32_SDFAT_ENABLED)
-
-    if (storageType == mem_storage_type_flash)
-    {
-#if defined(MBFS_FLASH_FS)
-        fs::File file = Core.mbfs.getFlashFile();
-        count = readQueueFile(fbdo, file, item, mode);
-#endif
-    }
-    else if (storageType == mem_storage_type_sd)
+    while (count < 255)
     {
-#if defined(MBFS_SD_FS) && defined(CARD_TYPE_SD)
-        MBFS_SD_FILE file = Core.mbfs.getSDFile();
-        count = readQueueFileSdFat(fbdo, file, item, mode);
-#endif
-    }
+        FBUtils::idle();
 
-#else
+        if (readQueueRecord(storageType, mode == 1 ? &item : nullptr, buf) <= 0)
+            break;
 
-    if (storageType == mem_storage_type_flash)
-    {
-#if defined(MBFS_FLASH_FS)
-        fs::File file = Core.mbfs.getFlashFile();
-        count = readQueueFile(fbdo, file, item, mode);
-#endif
-    }
-    else if (storageType == mem_storage_type_sd)
-    {
-#if defined(MBFS_SD_FS) && defined(CARD_TYPE_SD)
-        MBFS_SD_FILE file = Core.mbfs.getSDFile();
-        count = readQueueFile(fbdo, file, item, mode);
-#endif
+        if (mode == 1)
+        {
+            if (!fbdo->_qMan._queueCollection)
+                fbdo->_qMan._queueCollection = new MB_VECTOR<struct QueueItem>();
+
+            fbdo->_qMan._queueCollection->push_back(std::move(item));
+        }
+
+        count++;
     }
 
-#endif
+    Core.mbfs.close(mbfs_type storageType);
 
     return count;
 }
 
-#if (defined(MBFS_FLASH_FS) || defined(MBFS_SD_FS)) && (defined(ESP32) || defined(ESP8266) || defined(MB_ARDUINO_PICO))
-uint8_t FB_RTDB::readQueueFile(FirebaseData *fbdo, fs::File &file, QueueItem &item, uint8_t mode)
+int FB_RTDB::readQueueRecord(firebase_mem_storage_type storageType, QueueItem *item, MB_VECTOR<uint8_t> &buf)
 {
+    uint8_t hdr[FIREBASE_QUEUE_RECORD_HEADER_SIZE];
+    int n = Core.mbfs.read(mbfs_type storageType, hdr, sizeof(hdr));
 
-    uint8_t count = 0;
-    FirebaseJsonArray arr;
-    FirebaseJsonData result;
+    if (n <= 0)
+        return 0;
+
+    uint16_t sum = 0;
+    int32_t len = n == (int)sizeof(hdr) ? QueueManager::header(hdr, sum) : -1;
+    if (len < 0)
+        return -1;
+
+    // one spare byte for decode
+    buf.resize(len + 1);
+
+    if (Core.mbfs.read(mbfs_type storageType, buf.data(), len) != len ||
+        QueueManager::checksum(buf.data(), len) != sum)
+        return -1;
+
+    if (item && !QueueManager::decode(buf.data(), len, *item))
+        return -1;
+
+    return len + FIREBASE_QUEUE_RECORD_HEADER_SIZE;
+}
 
-    while (file.available())
+bool FB_RTDB::queueRecordPayload(const QueueItem &item, MB_String &payload)
+{
+    // the blob data and priority are only referenced by address
+    if (item.method == http_get || item.dataType == d_blob || item.address.priority > 0)
+        return false;
+
+    payload.clear();
+
+    if (item.address.din > 0 && item.dataType == d_json)
     {
-        FBUtils::idle();
-        if (arr.readFrom(file))
-        {
-            if (mode == 1)
-            {
-                for (size_t i = 0; i < arr.size(); i++)
-                {
-                    FBUtils::idle();
-                    arr.get(result, i);
-                    if (result.success)
-                    {
-                        switch (i)
-                        {
-                        case 0:
-                            item.dataType = (firebase_data_type)result.to<int>();
-                            break;
-                        case 1:
-                            item.subType = result.to<int>();
-                            break;
-                        case 2:
-                            item.method = (firebase_request_method)result.to<int>();
-                            break;
-                        case 3:
-                            item.storageType = (firebase_mem_storage_type)result.to<int>();
-                            break;
-                        case 4:
-                            item.async = (bool)result.to<int>();
-                            break;
-                        case 5:
-                            item.address.din = result.to<int>();
-                            break;
-                        case 6:
-                            item.address.dout = result.to<int>();
-                            break;
-                        case 7:
-                            item.address.query = result.to<int>();
-                            break;
-                        case 8:
-                            item.address.priority = result.to<int>();
-                            break;
-                        case 9:
-                            item.blobSize = result.to<int>();
-                            break;
-                        case 10:
-                            item.path = result.to<MB_String>();
-                            break;
-                        case 11:
-                            item.payload = result.to<MB_String>();
-                            break;
-                        case 12:
-                            item.etag = result.to<MB_String>();
-                            break;
-                        case 13:
-                            item.filename = result.to<MB_String>();
-                            break;
-                        default:
-                            break;
-                        }
-                    }
-                }
-                if (!fbdo->_qMan._queueCollection)
-                    fbdo->_qMan._queueCollection = new MB_VECTOR<struct QueueItem>();
+        FirebaseJson *json = addrTo<FirebaseJson *>(item.address.din);
+        if (json)
+            payload = json->raw();
+    }
+    else if (item.address.din > 0 && item.dataType == d_array)
+    {
+        FirebaseJsonArray *arr = addrTo<FirebaseJsonArray *>(item.address.din);
+        if (arr)
+            payload = arr->raw();
+    }
+    else
+        payload = item.payload;
 
-                fbdo->_qMan._queueCollection->push_back(item);
-            }
-            count++;
-        }
+    return true;
+}
+
+bool FB_RTDB::mBeginPersistentErrorQueue(FirebaseData *fbdo, MB_StringPtr filename, firebase_mem_storage_type storageType)
+{
+    QueueManager &q = fbdo->_qMan;
+
+    q._logEnable = false;
+    q._logFile = filename;
+    q._logStorage = storageType;
+    q._logHead = 0;
+    q._logTail = 0;
+    q._logCount = 0;
+    q._logReadFail = 0;
+
+    if (q._logFile.length() == 0 || !Core.mbfs.checkStorageReady(mbfs_type storageType))
+    {
+        fbdo->session.response.code = storageType == mem_storage_type_sd ? MB_FS_ERROR_SD_STORAGE_IS_NOT_READY
+                                                                          : MB_FS_ERROR_FLASH_STORAGE_IS_NOT_READY;
+        return false;
     }
 
-    return count;
+    // finish the compaction that was interrupted by a power loss, the log is not usable until then
+    if (!recoverQueueFile(fbdo))
+    {
+        fbdo->session.response.code = MB_FS_ERROR_FILE_IO_ERROR;
+        return false;
+    }
+
+    q._logEnable = true;
+
+    int size = scanQueueFile(fbdo);
+    if (size < 0)
+    {
+        q._logEnable = false;
+        fbdo->session.response.code = size;
+        return false;
+    }
+
+    return true;
 }
-#endif
 
-#if defined(MBFS_ESP32_SDFAT_ENABLED)
-uint8_t FB_RTDB::readQueueFileSdFat(FirebaseData *fbdo, MBFS_SD_FILE &file, QueueItem &item, uint8_t mode)
+int FB_RTDB::scanQueueFile(FirebaseData *fbdo)
 {
-    uint8_t count = 0;
-    FirebaseJsonArray arr;
-    FirebaseJsonData result;
+    QueueManager &q = fbdo->_qMan;
+    firebase_mem_storage_type storageType = (firebase_mem_storage_type)q._logStorage;
+
+    // the offsets are kept when the file can't be opened
+    int size = Core.mbfs.open(q._logFile, mbfs_type storageType, mb_fs_open_mode_read);
 
-    while (file.available())
+    // nothing was queued yet
+    if (size == MB_FS_ERROR_FILE_NOT_FOUND)
     {
-        FBUtils::idle();
-        if (arr.readFrom(file))
-        {
-            if (mode == 1)
-            {
-                for (size_t i = 0; i < arr.size(); i++)
-                {
-                    FBUtils::idle();
-                    arr.get(result, i);
-                    if (result.success)
-                    {
-                        switch (i)
-                        {
-                        case 0:
-                            item.dataType = (firebase_data_type)result.to<int>();
-                            break;
-                        case 1:
-                            item.subType = result.to<int>();
-                            break;
-                        case 2:
-                            item.method = (firebase_request_method)result.to<int>();
-                            break;
-                        case 3:
-                            item.storageType = (firebase_mem_storage_type)result.to<int>();
-                            break;
-                        case 4:
-                            item.async = (bool)result.to<int>();
-                            break;
-                        case 5:
-                            item.address.din = result.to<int>();
-                            break;
-                        case 6:
-                            item.address.dout = result.to<int>();
-                            break;
-                        case 7:
-                            item.address.query = result.to<int>();
-                            break;
-                        case 8:
-                            item.address.priority = result.to<int>();
-                            break;
-                        case 9:
-                            item.blobSize = result.to<int>();
-                            break;
-                        case 10:
-                            item.path = result.to<MB_String>();
-                            break;
-                        case 11:
-                            item.payload = result.to<MB_String>();
-                            break;
-                        case 12:
-                            item.etag = result.to<MB_String>();
-                            break;
-                        case 13:
-                            item.filename = result.to<MB_String>();
-                            break;
-                        default:
-                            break;
-                        }
-                    }
-                }
-                if (!fbdo->_qMan._queueCollection)
-                    fbdo->_qMan._queueCollection = new MB_VECTOR<struct QueueItem>();
+        q._logHead = 0;
+        q._logTail = 0;
+        q._logCount = 0;
+        return 0;
+    }
 
-                fbdo->_qMan._queueCollection->push_back(item);
-            }
+    if (size < 0)
+        return size;
+
+    Core.mbfs.close(mbfs_type storageType);
+
+    uint32_t head = readQueueHead(fbdo);
+    if (head > (uint32_t)size)
+        head = 0;
+
+    // count the pending records, the scan ends at the first incomplete one (power loss while appending)
+    Core.mbfs.open(q._logFile, mbfs_type storageType, mb_fs_open_mode_read);
+
+    uint32_t tail = head;
+    uint32_t count = 0;
+
+    if (Core.mbfs.seek(mbfs_type storageType, head))
+    {
+        MB_VECTOR<uint8_t> buf;
+        int n = 0;
+        while ((n = readQueueRecord(storageType, nullptr, buf)) > 0)
+        {
+            FBUtils::idle();
+            tail += n;
             count++;
         }
     }
 
-    return count;
+    Core.mbfs.close(mbfs_type storageType);
+
+    q._logHead = head;
+    q._logTail = tail;
+    q._logCount = count;
+
+    if (count == 0)
+        resetQueueFile(fbdo);
+    else if (tail < (uint32_t)size || head > 0)
+        compactQueueFile(fbdo);
+
+    return size;
 }
 
-#endif
+void FB_RTDB::endPersistentErrorQueue(FirebaseData *fbdo)
+{
+    // the file is kept and resumed by the next beginPersistentErrorQueue
+    fbdo->_qMan._logEnable = false;
+    fbdo->_qMan._logCount = 0;
+}
+
+uint32_t FB_RTDB::persistentErrorQueueCount(FirebaseData *fbdo)
+{
+    return fbdo->_qMan._logEnable ? fbdo->_qMan._logCount : 0;
+}
+
+bool FB_RTDB::appendQueueRecord(FirebaseData *fbdo, const QueueItem &item)
+{
+    QueueManager &q = fbdo->_qMan;
+    firebase_mem_storage_type storageType = (firebase_mem_storage_type)q._logStorage;
+
+    MB_String payload;
+    if (!queueRecordPayload(item, payload))
+        return false;
+
+    MB_VECTOR<uint8_t> buf;
+    // the fixed fields (13) and four string lengths (16)
+    buf.reserve(FIREBASE_QUEUE_RECORD_HEADER_SIZE + 29 + item.path.length() + payload.length() +
+                item.etag.length() + item.filename.length());
+    QueueManager::encode(item, payload, buf);
+
+    int ret = Core.mbfs.open(q._logFile, mbfs_type storageType, mb_fs_open_mode_append);
+    if (ret < 0)
+        return false;
+
+    int n = Core.mbfs.write(mbfs_type storageType, buf.data(), buf.size());
+    Core.mbfs.close(mbfs_type storageType);
+
+    if (n != (int)buf.size())
+    {
+        // drop the partial record before the next append
+        compactQueueFile(fbdo);
+        return false;
+    }
+
+    q._logTail += buf.size();
+    q._logCount++;
+    return true;
+}
+
+bool FB_RTDB::findQueueRecord(FirebaseData *fbdo, uint32_t qID)
+{
+    QueueManager &q = fbdo->_qMan;
+    firebase_mem_storage_type storageType = (firebase_mem_storage_type)q._logStorage;
+
+    if (!q._logEnable || q._logCount == 0 ||
+        Core.mbfs.open(q._logFile, mbfs_type storageType, mb_fs_open_mode_read) < 0)
+        return false;
+
+    // only the header and the qID of each record are read
+    uint8_t hdr[FIREBASE_QUEUE_RECORD_HEADER_SIZE + 4];
+    uint32_t pos = q._logHead;
+    bool found = false;
+
+    while (!found && pos < q._logTail && Core.mbfs.seek(mbfs_type storageType, pos) &&
+           Core.mbfs.read(mbfs_type storageType, hdr, sizeof(hdr)) == (int)sizeof(hdr))
+    {
+        uint16_t sum = 0;
+        int32_t len = QueueManager::header(hdr, sum);
+        if (len < 0)
+            break;
+
+        uint32_t id = hdr[8] | hdr[9] << 8 | (uint32_t)hdr[10] << 16 | (uint32_t)hdr[11] << 24;
+        found = id == qID;
+        pos += FIREBASE_QUEUE_RECORD_HEADER_SIZE + len;
+    }
+
+    Core.mbfs.close(mbfs_type storageType);
+    return found;
+}
+
+void FB_RTDB::queueHeadFile(FirebaseData *fbdo, MB_String &name, bool tmp)
+{
+    name = fbdo->_qMan._logFile;
+    name += tmp ? firebase_rtdb_pgm_str_42 /* ".tmp" */ : firebase_rtdb_pgm_str_41 /* ".hd" */;
+}
+
+uint32_t FB_RTDB::readQueueHead(FirebaseData *fbdo)
+{
+    firebase_mem_storage_type storageType = (firebase_mem_storage_type)fbdo->_qMan._logStorage;
+    MB_String name;
+    queueHeadFile(fbdo, name, false);
+
+    uint32_t head = 0;
+
+    if (Core.mbfs.open(name, mbfs_type storageType, mb_fs_open_mode_read) == 8)
+    {
+        // a torn checkpoint restarts from the first record
+        if (!readQueueMark(storageType, head))
+            head = 0;
+        Core.mbfs.close(mbfs_type storageType);
+    }
+
+    return head;
+}
+
+bool FB_RTDB::writeQueueHead(FirebaseData *fbdo)
+{
+    MB_String name;
+    queueHeadFile(fbdo, name, false);
+    return writeQueueMark((firebase_mem_storage_type)fbdo->_qMan._logStorage, name, mb_fs_open_mode_write, fbdo->_qMan._logHead);
+}
+
+void FB_RTDB::resetQueueFile(FirebaseData *fbdo)
+{
+    QueueManager &q = fbdo->_qMan;
+    MB_String name;
+
+    Core.mbfs.remove(q._logFile, mbfs_type q._logStorage);
+    queueHeadFile(fbdo, name, false);
+    Core.mbfs.remove(name, mbfs_type q._logStorage);
+
+    q._logHead = 0;
+    q._logTail = 0;
+    q._logCount = 0;
+}
+
+bool FB_RTDB::copyQueueFile(firebase_mem_storage_type storageType, const MB_String &src, uint32_t ofs,
+                            uint32_t len, const MB_String &dst)
+{
+    return Core.mbfs.copy(src, ofs, len, dst, mbfs_type storageType) == (int)len;
+}
+
+bool FB_RTDB::writeQueueMark(firebase_mem_storage_type storageType, const MB_String &name, mb_fs_open_mode mode, uint32_t v)
+{
+    // the value and its complement, a torn write is detected by the reader
+    uint8_t buf[8];
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        buf[i] = (v >> (8 * i)) & 0xff;
+        buf[4 + i] = (~v >> (8 * i)) & 0xff;
+    }
+
+    if (Core.mbfs.open(name, mbfs_type storageType, mode) < 0)
+        return false;
+
+    int n = Core.mbfs.write(mbfs_type storageType, buf, sizeof(buf));
+    Core.mbfs.close(mbfs_type storageType);
+    return n == (int)sizeof(buf);
+}
+
+bool FB_RTDB::readQueueMark(firebase_mem_storage_type storageType, uint32_t &v)
+{
+    uint8_t buf[8];
+    if (Core.mbfs.read(mbfs_type storageType, buf, sizeof(buf)) != (int)sizeof(buf))
+        return false;
+
+    v = buf[0] | buf[1] << 8 | (uint32_t)buf[2] << 16 | (uint32_t)buf[3] << 24;
+    uint32_t c = buf[4] | buf[5] << 8 | (uint32_t)buf[6] << 16 | (uint32_t)buf[7] << 24;
+    return v == ~c;
+}
+
+bool FB_RTDB::recoverQueueFile(FirebaseData *fbdo)
+{
+    QueueManager &q = fbdo->_qMan;
+    firebase_mem_storage_type storageType = (firebase_mem_storage_type)q._logStorage;
+    MB_String tmp;
+    queueHeadFile(fbdo, tmp, true);
+
+    int size = Core.mbfs.open(tmp, mbfs_type storageType, mb_fs_open_mode_read);
+    if (size == MB_FS_ERROR_FILE_NOT_FOUND)
+        return true;
+
+    // the temp file is complete when its trailer holds the length of pending records
+    uint32_t len = 0;
+    bool done = size >= 8 && Core.mbfs.seek(mbfs_type storageType, size - 8) &&
+                readQueueMark(storageType, len) && len == (uint32_t)size - 8;
+    Core.mbfs.close(mbfs_type storageType);
+
+    if (done)
+    {
+        // the log was being rewritten, finish it, the temp file is kept until the head is saved
+        if (!copyQueueFile(storageType, tmp, 0, len, q._logFile))
+            return false;
+
+        q._logHead = 0;
+        if (!writeQueueHead(fbdo))
+            return false;
+    }
+
+    // an incomplete temp file means the log was not touched yet
+    Core.mbfs.remove(tmp, mbfs_type storageType);
+    return true;
+}
+
+bool FB_RTDB::compactQueueFile(FirebaseData *fbdo)
+{
+    QueueManager &q = fbdo->_qMan;
+    firebase_mem_storage_type storageType = (firebase_mem_storage_type)q._logStorage;
+    MB_String tmp;
+    queueHeadFile(fbdo, tmp, true);
+
+    uint32_t len = q._logTail - q._logHead;
+
+    if (len == 0)
+    {
+        resetQueueFile(fbdo);
+        return true;
+    }
+
+    // there is no rename in all file systems, the pending records are copied to the temp file
+    // which is committed by its trailer before the log is rewritten. A power loss at any step
+    // leaves either the untouched log or the complete temp file that beginPersistentErrorQueue
+    // copies back.
+    if (!copyQueueFile(storageType, q._logFile, q._logHead, len, tmp) ||
+        !writeQueueMark(storageType, tmp, mb_fs_open_mode_append, len))
+    {
+        Core.mbfs.remove(tmp, mbfs_type storageType);
+        return false;
+    }
+
+    // the old offsets are not valid once the log is being rewritten
+    bool ok = copyQueueFile(storageType, tmp, 0, len, q._logFile);
+    q._logHead = 0;
+    q._logTail = len;
+
+    if (!ok || !writeQueueHead(fbdo))
+    {
+        // retry from the committed temp file, the log is not used until it was recovered
+        if (!recoverQueueFile(fbdo))
+            q._logEnable = false;
+        return false;
+    }
+
+    Core.mbfs.remove(tmp, mbfs_type storageType);
+    return true;
+}
 
 bool FB_RTDB::isErrorQueueFull(FirebaseData *fbdo)
 {
@@ -1512,6 +2073,11 @@ bool FB_RTDB::processRequest(FirebaseData *fbdo, struct firebase_rtdb_request_in
 
     FBUtils::idle();
 
+    // the pending combined writes go first, the request behind them fails when they cannot be sent
+    if (fbdo->session.rtdb.combiner.writes.size() > 0 && !fbdo->session.rtdb.combiner.flushing &&
+        !flushWrites(fbdo))
+        return false;
+
     if (preRequestCheck(fbdo, req) <= 0)
         return false;
 
@@ -1569,7 +2135,7 @@ bool FB_RTDB::processRequest(FirebaseData *fbdo, struct firebase_rtdb_request_in
                 errCount++;
     }
 
-    if (!ret && errCount == maxRetry && fbdo->_qMan._maxQueue > 0)
+    if (!ret && errCount == maxRetry && (fbdo->_qMan._maxQueue > 0 || fbdo->_qMan._logEnable))
     {
 #if defined(ENABLE_ERROR_QUEUE) || defined(FIREBASE_ENABLE_ERROR_QUEUE)
         addQueueData(fbdo, req);
@@ -1606,9 +2172,14 @@ void FB_RTDB::rescon(FirebaseData *fbdo, const char *host, firebase_rtdb_request
     fbdo->_responseCallback = NULL;
 
     if (req->method == rtdb_stream)
+    {
         fbdo->session.rtdb.stream_path_changed = strcmp(req->path.c_str(), fbdo->session.rtdb.stream_path.c_str()) != 0
                                                      ? true
                                                      : false;
+        // the mirrored data belongs to the previous stream path
+        if (fbdo->session.rtdb.stream_path_changed)
+            fbdo->_mirror.clear();
+    }
 
     if (fbdo->session.cert_updated || millis() - fbdo->session.last_conn_ms > fbdo->session.conn_timeout ||
         fbdo->session.rtdb.stream_path_changed ||
@@ -1632,128 +2203,534 @@ bool FB_RTDB::handleRequest(FirebaseData *fbdo, struct firebase_rtdb_request_inf
 {
     FBUtils::idle();
 
-    if (preRequestCheck(fbdo, req) <= 0)
-        return false;
+    if (preRequestCheck(fbdo, req) <= 0)
+        return false;
+
+#if defined(MB_ARDUINO_PICO)
+    if (!Core.waitIdle(fbdo->session.response.code))
+        return false;
+#endif
+
+    bool pipelined = pipelinable(fbdo, req);
+
+    // read the waiting pipelined responses before the request that cannot be pipelined
+    // and before the session is closed by rescon
+    if (fbdo->session.rtdb.pipeline.inflight.size() > 0 &&
+        (!pipelined || fbdo->session.rtdb.pipeline.inflight.size() >= FIREBASE_RTDB_PIPELINE_MAX_INFLIGHT ||
+         fbdo->session.cert_updated || millis() - fbdo->session.last_conn_ms > fbdo->session.conn_timeout))
+        flushPipeline(fbdo);
+
+    if (!fbdo->tcpClient.connected())
+    {
+        fbdo->session.rtdb.async_count = 0;
+        // the connection will be re-established by this request, the waiting responses are lost with the old one
+        failPipeline(fbdo, FIREBASE_ERROR_TCP_ERROR_CONNECTION_LOST);
+    }
+
+    if ((fbdo->session.rtdb.async && !req->async) ||
+        fbdo->session.rtdb.async_count > Core.config->async_close_session_max_request)
+    {
+        fbdo->session.rtdb.async_count = 0;
+        fbdo->closeSession();
+    }
+
+    fbdo->session.rtdb.queue_ID = 0;
+    if (req->data.etag.length() > 0)
+        fbdo->session.rtdb.req_etag = req->data.etag;
+    if (req->data.address.priority > 0)
+    {
+        float *pri = addrTo<float *>(req->data.address.priority);
+        fbdo->session.rtdb.priority = *pri;
+    }
+
+    fbdo->session.rtdb.storage_type = req->storageType;
+
+    fbdo->session.rtdb.redirect_url.clear();
+    fbdo->session.rtdb.req_method = req->method;
+    fbdo->session.rtdb.req_data_type = req->data.type;
+    fbdo->session.rtdb.data_mismatch = false;
+    fbdo->session.rtdb.async = req->async;
+    if (req->async)
+        fbdo->session.rtdb.async_count++;
+
+    uint32_t connects = fbdo->tcpClient.stats().connects;
+
+    bool sent = sendRequest(fbdo, req);
+
+    // the client reconnected while sending, the waiting responses were on the old connection
+    if (fbdo->tcpClient.stats().connects != connects)
+        failPipeline(fbdo, FIREBASE_ERROR_TCP_ERROR_CONNECTION_LOST);
+
+    if (sent)
+    {
+
+        if (req->method == rtdb_stream)
+        {
+            if (!waitResponse(fbdo, req))
+            {
+                fbdo->closeSession();
+                return false;
+            }
+        }
+        else if (req->method == rtdb_get_rules ||
+                 req->method == rtdb_backup ||
+                 ((req->data.type == d_file || req->data.type == d_file_ota) && req->method == http_get))
+        {
+            if (!waitResponse(fbdo, req))
+            {
+                fbdo->closeSession();
+                if (req->downloadCallback)
+                {
+                    RTDB_DownloadStatusInfo in;
+                    makeDownloadStatus(in, req->filename, req->path, firebase_rtdb_download_status_error,
+                                       0, 0, 0, fbdo->errorReason());
+                    sendDownloadCallback(fbdo, in, req->downloadCallback, req->downloadStatusInfo);
+                }
+
+                return false;
+            }
+            else if (req->downloadCallback)
+            {
+                RTDB_DownloadStatusInfo in;
+                makeDownloadStatus(in, req->filename, req->path, firebase_rtdb_download_status_complete,
+                                   100, req->fileSize, 0, "");
+                sendDownloadCallback(fbdo, in, req->downloadCallback, req->downloadStatusInfo);
+            }
+        }
+        else if (req->method == rtdb_set_rules ||
+                 req->method == rtdb_restore ||
+                 (req->data.type == d_file && req->method == rtdb_set_nocontent))
+        {
+            if (!waitResponse(fbdo, req))
+            {
+                fbdo->closeSession();
+
+                if (req->uploadCallback)
+                {
+                    RTDB_UploadStatusInfo in;
+                    makeUploadStatus(in, req->filename, req->path, firebase_rtdb_upload_status_error,
+                                     0, 0, 0, fbdo->errorReason());
+                    sendUploadCallback(fbdo, in, req->uploadCallback, req->uploadStatusInfo);
+                }
+
+                return false;
+            }
+            else if (req->uploadCallback)
+            {
+                RTDB_UploadStatusInfo in;
+                makeUploadStatus(in,
+                                 req->filename,
+                                 req->path,
+                                 firebase_rtdb_upload_status_complete,
+                                 100,
+                                 req->fileSize,
+                                 0,
+                                 "");
+                sendUploadCallback(fbdo, in, req->uploadCallback, req->uploadStatusInfo);
+            }
+        }
+        else if (pipelined)
+        {
+            // the response will be read in request order by flushPipeline
+            fbdo->session.rtdb.path = req->path;
+            addPipelineRequest(fbdo, req);
+        }
+        else
+        {
+            fbdo->session.rtdb.path = req->path;
+            if (!waitResponse(fbdo, req))
+            {
+                fbdo->closeSession();
+                return false;
+            }
+            fbdo->session.rtdb.data_available = fbdo->session.rtdb.raw.length() > 0;
+            if (fbdo->session.rtdb.blob)
+                fbdo->session.rtdb.data_available |= fbdo->session.rtdb.blob->size() > 0;
+
+            // share the idle connection with the other sessions (no-op when the pool is disabled)
+            if (!req->async && fbdo->session.rtdb.async_count == 0 && fbdo->session.rtdb.pipeline.inflight.size() == 0)
+                fbdo->tcpClient.release();
+        }
+    }
+    else
+        return false;
+
+    return true;
+}
+
+bool FB_RTDB::pipelinable(FirebaseData *fbdo, struct firebase_rtdb_request_info_t *req)
+{
+    if (!fbdo->session.rtdb.pipeline.enable || req->async || req->task_type != firebase_rtdb_task_undefined ||
+        req->data.type == d_blob || req->data.type == d_file || req->data.type == d_file_ota)
+        return false;
+
+    return req->method == http_put ||
+           req->method == http_post ||
+           req->method == http_patch ||
+           req->method == http_delete ||
+           req->method == rtdb_set_nocontent ||
+           req->method == rtdb_update_nocontent;
+}
+
+void FB_RTDB::addPipelineRequest(FirebaseData *fbdo, struct firebase_rtdb_request_info_t *req)
+{
+    firebase_rtdb_pipeline_info_t &pipeline = fbdo->session.rtdb.pipeline;
+    FirebaseConnectionStats &stats = fbdo->tcpClient.stats();
+
+    if (pipeline.inflight.size() > 0)
+        stats.pipelined++;
+
+    firebase_rtdb_pipeline_request_t item;
+    item.id = ++pipeline.id;
+    item.method = req->method;
+    item.type = req->data.type;
+    item.path = req->path;
+    pipeline.inflight.push_back(item);
+
+    if (pipeline.inflight.size() > stats.maxInflight)
+        stats.maxInflight = pipeline.inflight.size();
+}
+
+bool FB_RTDB::flushPipeline(FirebaseData *fbdo)
+{
+    firebase_rtdb_pipeline_info_t &pipeline = fbdo->session.rtdb.pipeline;
+
+    if (pipeline.inflight.size() == 0)
+        return true;
+
+    // the connection was closed after the requests were sent
+    if (!fbdo->tcpClient.connected())
+    {
+        failPipeline(fbdo, FIREBASE_ERROR_TCP_ERROR_CONNECTION_LOST);
+        return false;
+    }
+
+    // take the list, the responses read after the connection error are not waited
+    MB_VECTOR<firebase_rtdb_pipeline_request_t> inflight;
+    inflight.swap(pipeline.inflight);
+
+    bool ret = true;
+    bool connected = true;
+
+    pipeline.reading = true;
+
+    for (size_t i = 0; i < inflight.size(); i++)
+    {
+        struct firebase_rtdb_request_info_t req;
+        req.method = inflight[i].method;
+        req.data.type = inflight[i].type;
+        req.path = inflight[i].path;
+
+        fbdo->session.rtdb.req_method = req.method;
+        fbdo->session.rtdb.req_data_type = req.data.type;
+        fbdo->session.rtdb.path = req.path;
+        fbdo->session.rtdb.async = false;
+
+        bool success = false;
+
+        if (connected)
+        {
+            success = waitResponse(fbdo, &req);
+
+            // the http error response keeps the next responses in order,
+            // the connection error loses all of them
+            if (!success && fbdo->session.response.code < 0)
+            {
+                connected = false;
+                fbdo->closeSession();
+            }
+        }
+        else
+            fbdo->session.response.code = FIREBASE_ERROR_TCP_ERROR_NOT_CONNECTED;
+
+        if (!success)
+            ret = false;
+
+        if (pipeline.cb)
+        {
+            RTDB_PipelineResult result;
+            result.id = inflight[i].id;
+            result.method = req.method;
+            result.path = req.path;
+            result.httpCode = fbdo->session.response.code;
+            result.success = success;
+            if (!success)
+                result.errorMsg = fbdo->errorReason().c_str();
+            pipeline.cb(result);
+        }
+    }
+
+    pipeline.reading = false;
+
+    return ret;
+}
+
+void FB_RTDB::failPipeline(FirebaseData *fbdo, int code)
+{
+    firebase_rtdb_pipeline_info_t &pipeline = fbdo->session.rtdb.pipeline;
+
+    if (pipeline.inflight.size() == 0)
+        return;
+
+    MB_VECTOR<firebase_rtdb_pipeline_request_t> inflight;
+    inflight.swap(pipeline.inflight);
+
+    fbdo->session.response.code = code;
+
+    if (!pipeline.cb)
+        return;
+
+    for (size_t i = 0; i < inflight.size(); i++)
+    {
+        RTDB_PipelineResult result;
+        result.id = inflight[i].id;
+        result.method = inflight[i].method;
+        result.path = inflight[i].path;
+        result.httpCode = code;
+        result.success = false;
+        result.errorMsg = fbdo->errorReason().c_str();
+        pipeline.cb(result);
+    }
+}
+
+int FB_RTDB::combineWrite(FirebaseData *fbdo, struct firebase_rtdb_request_info_t *req)
+{
+    firebase_rtdb_write_combiner_t &combiner = fbdo->session.rtdb.combiner;
+
+    if (!combiner.enable || combiner.flushing || req->async || req->queue || req->data.etag.length() > 0 ||
+        req->data.type == d_blob || req->data.type == d_file || req->data.type == d_file_ota)
+        return -1;
+
+    bool update = req->method == http_patch || req->method == rtdb_update_nocontent;
+    if (!update && req->method != http_put && req->method != rtdb_set_nocontent)
+        return -1;
+
+    MB_String path = req->path;
+    while (path.length() > 1 && path[path.length() - 1] == '/')
+        path.erase(path.length() - 1, 1);
+
+    // the root cannot be the key of multi-location update
+    if (path.length() < 2 && !update)
+        return -1;
+
+    // the request body
+    MB_String body = req->pre_payload;
+    if (req->data.address.din > 0 && req->data.type == d_json)
+    {
+        FirebaseJson *json = addrTo<FirebaseJson *>(req->data.address.din);
+        if (json)
+            body += json->raw();
+    }
+    else if (req->data.address.din > 0 && req->data.type == d_array)
+    {
+        FirebaseJsonArray *arr = addrTo<FirebaseJsonArray *>(req->data.address.din);
+        if (arr)
+            body += arr->raw();
+    }
+    else
+        body += req->payload;
+    body += req->post_payload;
+
+    if (body.length() == 0)
+        return -1;
+
+    // the update is the set of each of its children
+    MB_VECTOR<size_t> spans;
+    if (update && !splitObject(body.c_str(), spans))
+        return -1;
+
+    if (!update)
+    {
+        if (!putCombinedWrite(fbdo, path, body.c_str(), body.length()))
+            return 0;
+    }
+    else
+    {
+        for (size_t i = 0; i + 3 < spans.size(); i += 4)
+        {
+            const char *key = body.c_str() + spans[i];
+            size_t keyLen = spans[i + 1];
+            if (keyLen > 0 && key[0] == '/')
+            {
+                key++;
+                keyLen--;
+            }
+
+            MB_String child = path;
+            if (child.length() > 1)
+                child += firebase_pgm_str_1; // "/"
+            child.append(key, keyLen);
+
+            if (!putCombinedWrite(fbdo, child, body.c_str() + spans[i + 2], spans[i + 3]))
+                return 0;
+        }
+    }
+
+    if (combiner.writes.size() >= FIREBASE_RTDB_COMBINER_MAX_WRITES ||
+        millis() - combiner.first_ms >= combiner.deadline_ms)
+        return flushWrites(fbdo) ? 1 : 0;
+
+    return 1;
+}
+
+bool FB_RTDB::putCombinedWrite(FirebaseData *fbdo, const MB_String &path, const char *value, size_t len)
+{
+    if (addCombinedWrite(fbdo, path, value, len))
+        return true;
+
+    // the server merges the write under the pending path, send the pending writes first
+    return flushWrites(fbdo) && addCombinedWrite(fbdo, path, value, len);
+}
+
+bool FB_RTDB::addCombinedWrite(FirebaseData *fbdo, const MB_String &path, const char *value, size_t len)
+{
+    firebase_rtdb_write_combiner_t &combiner = fbdo->session.rtdb.combiner;
 
-#if defined(MB_ARDUINO_PICO)
-    if (!Core.waitIdle(fbdo->session.response.code))
-        return false;
-#endif
+    // the pending paths have no parent/child between them
+    for (size_t i = 0; i < combiner.writes.size(); i++)
+    {
+        if (combiner.writes[i].path.length() < path.length() && isSubPath(combiner.writes[i].path, path))
+            return false;
+    }
 
-    if (!fbdo->tcpClient.connected())
-        fbdo->session.rtdb.async_count = 0;
+    bool replaced = false;
 
-    if ((fbdo->session.rtdb.async && !req->async) ||
-        fbdo->session.rtdb.async_count > Core.config->async_close_session_max_request)
+    for (size_t i = 0; i < combiner.writes.size();)
     {
-        fbdo->session.rtdb.async_count = 0;
-        fbdo->closeSession();
+        if (isSubPath(path, combiner.writes[i].path))
+        {
+            // the latest value of the same path, keep the order
+            if (!replaced && combiner.writes[i].path.length() == path.length())
+            {
+                combiner.writes[i].value.clear();
+                combiner.writes[i].value.append(value, len);
+                replaced = true;
+                i++;
+            }
+            // the write to the parent replaces the pending writes under it
+            else
+                combiner.writes.erase(combiner.writes.begin() + i);
+        }
+        else
+            i++;
     }
 
-    fbdo->session.rtdb.queue_ID = 0;
-    if (req->data.etag.length() > 0)
-        fbdo->session.rtdb.req_etag = req->data.etag;
-    if (req->data.address.priority > 0)
+    if (!replaced)
     {
-        float *pri = addrTo<float *>(req->data.address.priority);
-        fbdo->session.rtdb.priority = *pri;
+        if (combiner.writes.size() == 0)
+            combiner.first_ms = millis();
+
+        firebase_rtdb_combined_write_t write;
+        write.path = path;
+        write.value.append(value, len);
+        combiner.writes.push_back(write);
     }
 
-    fbdo->session.rtdb.storage_type = req->storageType;
+    return true;
+}
 
-    fbdo->session.rtdb.redirect_url.clear();
-    fbdo->session.rtdb.req_method = req->method;
-    fbdo->session.rtdb.req_data_type = req->data.type;
-    fbdo->session.rtdb.data_mismatch = false;
-    fbdo->session.rtdb.async = req->async;
-    if (req->async)
-        fbdo->session.rtdb.async_count++;
+bool FB_RTDB::splitObject(const char *s, MB_VECTOR<size_t> &spans)
+{
+    // The key offset, key length, value offset and value length of the top level members.
+    size_t i = 0;
+
+    while (isspace(s[i]))
+        i++;
+
+    if (s[i++] != '{')
+        return false;
 
-    if (sendRequest(fbdo, req))
+    for (;;)
     {
+        while (isspace(s[i]))
+            i++;
 
-        if (req->method == rtdb_stream)
+        if (s[i] != '"')
+            return false;
+
+        size_t key = ++i;
+        while (s[i] && s[i] != '"')
         {
-            if (!waitResponse(fbdo, req))
-            {
-                fbdo->closeSession();
-                return false;
-            }
+            if (s[i] == '\\' && s[i + 1])
+                i++;
+            i++;
         }
-        else if (req->method == rtdb_get_rules ||
-                 req->method == rtdb_backup ||
-                 ((req->data.type == d_file || req->data.type == d_file_ota) && req->method == http_get))
-        {
-            if (!waitResponse(fbdo, req))
-            {
-                fbdo->closeSession();
-                if (req->downloadCallback)
-                {
-                    RTDB_DownloadStatusInfo in;
-                    makeDownloadStatus(in, req->filename, req->path, firebase_rtdb_download_status_error,
-                                       0, 0, 0, fbdo->errorReason());
-                    sendDownloadCallback(fbdo, in, req->downloadCallback, req->downloadStatusInfo);
-                }
 
-                return false;
-            }
-            else if (req->downloadCallback)
-            {
-                RTDB_DownloadStatusInfo in;
-                makeDownloadStatus(in, req->filename, req->path, firebase_rtdb_download_status_complete,
-                                   100, req->fileSize, 0, "");
-                sendDownloadCallback(fbdo, in, req->downloadCallback, req->downloadStatusInfo);
-            }
-        }
-        else if (req->method == rtdb_set_rules ||
-                 req->method == rtdb_restore ||
-                 (req->data.type == d_file && req->method == rtdb_set_nocontent))
-        {
-            if (!waitResponse(fbdo, req))
-            {
-                fbdo->closeSession();
+        if (!s[i] || i == key)
+            return false;
 
-                if (req->uploadCallback)
-                {
-                    RTDB_UploadStatusInfo in;
-                    makeUploadStatus(in, req->filename, req->path, firebase_rtdb_upload_status_error,
-                                     0, 0, 0, fbdo->errorReason());
-                    sendUploadCallback(fbdo, in, req->uploadCallback, req->uploadStatusInfo);
-                }
+        size_t keyLen = i++ - key;
 
-                return false;
-            }
-            else if (req->uploadCallback)
+        while (isspace(s[i]))
+            i++;
+
+        if (s[i++] != ':')
+            return false;
+
+        while (isspace(s[i]))
+            i++;
+
+        size_t val = i;
+        int depth = 0;
+        bool str = false;
+
+        for (; s[i]; i++)
+        {
+            if (str)
             {
-                RTDB_UploadStatusInfo in;
-                makeUploadStatus(in,
-                                 req->filename,
-                                 req->path,
-                                 firebase_rtdb_upload_status_complete,
-                                 100,
-                                 req->fileSize,
-                                 0,
-                                 "");
-                sendUploadCallback(fbdo, in, req->uploadCallback, req->uploadStatusInfo);
+                if (s[i] == '\\' && s[i + 1])
+                    i++;
+                else if (s[i] == '"')
+                    str = false;
             }
-        }
-        else
-        {
-            fbdo->session.rtdb.path = req->path;
-            if (!waitResponse(fbdo, req))
+            else if (s[i] == '"')
+                str = true;
+            else if (s[i] == '{' || s[i] == '[')
+                depth++;
+            else if (s[i] == '}' || s[i] == ']')
             {
-                fbdo->closeSession();
-                return false;
+                if (depth == 0)
+                    break;
+                depth--;
             }
-            fbdo->session.rtdb.data_available = fbdo->session.rtdb.raw.length() > 0;
-            if (fbdo->session.rtdb.blob)
-                fbdo->session.rtdb.data_available |= fbdo->session.rtdb.blob->size() > 0;
+            else if (s[i] == ',' && depth == 0)
+                break;
         }
+
+        size_t end = i;
+        while (end > val && isspace(s[end - 1]))
+            end--;
+
+        if (!s[i] || end == val)
+            return false;
+
+        spans.push_back(key);
+        spans.push_back(keyLen);
+        spans.push_back(val);
+        spans.push_back(end - val);
+
+        if (s[i++] == '}')
+            return true;
     }
-    else
-        return false;
+}
 
-    return true;
+bool FB_RTDB::isSubPath(const MB_String &parent, const MB_String &path)
+{
+    size_t len = parent.length();
+
+    if (len <= 1)
+        return true;
+
+    return path.length() >= len && strncmp(path.c_str(), parent.c_str(), len) == 0 &&
+           (path.length() == len || path[len] == '/');
+}
+
+MB_String FB_RTDB::parentPath(const MB_String &path)
+{
+    size_t p = path.find_last_of(firebase_pgm_str_1 /* "/" */);
+    if (p == MB_String::npos || p == 0)
+        return firebase_pgm_str_1; // "/"
+    return path.substr(0, p);
 }
 
 void FB_RTDB::reportUploadProgress(FirebaseData *fbdo, struct firebase_rtdb_request_info_t *req, size_t readBytes)
@@ -1942,6 +2919,11 @@ bool FB_RTDB::sendRequest(FirebaseData *fbdo, struct firebase_rtdb_request_info_
     fbdo->tcpClient.setSession(&fbdo->bsslSession);
     fbdo->tcpClient.begin(Core.config->database_url.c_str(), FIREBASE_PORT, &fbdo->session.response.code);
 
+    FirebaseConnectionStats &stats = fbdo->tcpClient.stats();
+    stats.requests++;
+    if (fbdo->tcpClient.connected())
+        stats.reused++;
+
     if (req->task_type == firebase_rtdb_task_upload_rules)
     {
         int sz = openFile(fbdo, req, mb_fs_open_mode_read);
@@ -2018,9 +3000,10 @@ bool FB_RTDB::sendRequest(FirebaseData *fbdo, struct firebase_rtdb_request_info_
     // Send payload
     if (req->data.address.din > 0 && req->data.type == d_json)
     {
+        // the serialized JSON is written through the small window, never as a whole string
         FirebaseJson *json = addrTo<FirebaseJson *>(req->data.address.din);
         if (json)
-            fbdo->tcpSend(json->raw());
+            json->writeTo(tcpWriteJson, fbdo);
     }
     else if (req->payload.length() > 0 || (req->data.type == d_array && req->data.address.din > 0))
     {
@@ -2035,7 +3018,7 @@ bool FB_RTDB::sendRequest(FirebaseData *fbdo, struct firebase_rtdb_request_info_
         {
             FirebaseJsonArray *arr = addrTo<FirebaseJsonArray *>(req->data.address.din);
             if (arr)
-                fbdo->tcpSend(arr->raw());
+                arr->writeTo(tcpWriteJson, fbdo);
 
             if (fbdo->session.response.code < 0)
                 return false;
@@ -2273,7 +3256,10 @@ bool FB_RTDB::handleResponse(FirebaseData *fbdo, firebase_rtdb_request_info_t *r
 
     Core.hh.initTCPSession(fbdo->session);
     Core.hh.intTCPHandler(&fbdo->tcpClient, tcpHandler, 2048 + strlen_P(firebase_rtdb_pgm_str_8 /* "\"file,base64," */),
-                          fbdo->session.resp_size, &payload, req->data.type == d_file_ota);
+                          fbdo->session.resp_size, &payload, req->data.type == d_file_ota, fbdo->tcpClient.rxBuffer());
+
+    // the next pipelined response may already be in the receive window
+    tcpHandler.keepRx = fbdo->session.rtdb.pipeline.reading;
 
 waits:
 
@@ -2345,6 +3331,10 @@ waits:
             }
 
             fbdo->session.rtdb.resp_etag = response.etag;
+
+            // no body, the remaining data is the next pipelined response
+            if (tcpHandler.keepRx && Core.ut.isNoContent(&response))
+                break;
         }
         // not http header received, stream payload received?
         else if (!tcpHandler.isHeader && tcpHandler.header.length() > 0)
@@ -2510,7 +3500,7 @@ skip:
 
     // To make sure all chunks read and
     // ready to send next request
-    if (response.isChunkedEnc)
+    if (response.isChunkedEnc && !tcpHandler.keepRx)
         fbdo->tcpClient.flush();
 
     endDownload(fbdo, req, tcpHandler, response);
@@ -2763,17 +3753,9 @@ void FB_RTDB::sendCB(FirebaseData *fbdo)
 
         fbdo->initJson();
 
-        if (fbdo->session.rtdb.resp_data_type == d_json)
-        {
-            fbdo->session.jsonPtr->setJsonData(fbdo->session.rtdb.raw.c_str());
-            fbdo->session.arrPtr->clear();
-        }
-
-        if (fbdo->session.rtdb.resp_data_type == d_array)
-        {
-            fbdo->session.arrPtr->setJsonArrayData(fbdo->session.rtdb.raw.c_str());
-            fbdo->session.jsonPtr->clear();
-        }
+        // JSON object and array are parsed on demand by FIREBASE_STREAM_CLASS::to()
+        fbdo->session.jsonPtr->clear();
+        fbdo->session.arrPtr->clear();
 
         s.jsonPtr = fbdo->session.jsonPtr;
         s.arrPtr = fbdo->session.arrPtr;
@@ -2818,16 +3800,13 @@ void FB_RTDB::sendCB(FirebaseData *fbdo)
         if (!fbdo->session.jsonPtr)
             fbdo->session.jsonPtr = new FirebaseJson();
 
-        if (fbdo->session.rtdb.resp_data_type == d_json)
-            fbdo->session.jsonPtr->setJsonData(fbdo->session.rtdb.raw.c_str());
+        // The child values are extracted from the raw JSON in get(), the JSON object
+        // is only parsed on demand when the whole data is requested.
+        fbdo->session.jsonPtr->clear();
+        s.sif->data = fbdo->session.rtdb.raw.c_str();
 
         if (s.sif->data_type == d_json)
             s.sif->m_json = fbdo->session.jsonPtr;
-        else
-        {
-            fbdo->session.jsonPtr->clear();
-            s.sif->data = fbdo->session.rtdb.raw.c_str();
-        }
 
         fbdo->_multiPathDataCallback(s);
         fbdo->session.rtdb.data_available = false;
@@ -2835,35 +3814,96 @@ void FB_RTDB::sendCB(FirebaseData *fbdo)
     }
 }
 
-void FB_RTDB::splitStreamPayload(const MB_String &payloads, MB_VECTOR<MB_String> &payload)
+void FB_RTDB::setStreamDataType(const firebase_sse_event_t &ev, struct server_response_data_t &response)
 {
-    int ofs = 0;
-    int pos1 = 0, pos2 = 0, pos3 = 0;
+    const char *d = ev.data;
+    size_t len = ev.dataLen;
+    // "\"blob,base64," and "\"file,base64," have the same length
+    size_t bl = strlen_P(firebase_rtdb_pgm_str_7);
 
-    while (pos1 > -1)
+    if (len == 0)
+        return;
+
+    if (len > bl && strncmp_P(d, firebase_rtdb_pgm_str_7 /* "\"blob,base64," */, bl) == 0)
+    {
+        response.dataType = firebase_data_type::d_blob;
+        response.payloadLen = len - bl - 1;
+    }
+    else if (len > bl && strncmp_P(d, firebase_rtdb_pgm_str_8 /* "\"file,base64," */, bl) == 0)
+    {
+        response.dataType = firebase_data_type::d_file;
+        response.payloadLen = len - bl - 1;
+    }
+    else if (d[0] == '"')
+        response.dataType = firebase_data_type::d_string;
+    else if (d[0] == '{')
+        response.dataType = firebase_data_type::d_json;
+    else if (d[0] == '[')
+        response.dataType = firebase_data_type::d_array;
+    else if (len >= 4 && strncmp_P(d, firebase_pgm_str_20 /* "true" */, 4) == 0)
+    {
+        response.dataType = firebase_data_type::d_boolean;
+        response.boolData = true;
+    }
+    else if (len >= 5 && strncmp_P(d, firebase_pgm_str_19 /* "false" */, 5) == 0)
     {
-        if (Core.sh.find(payloads, firebase_rtdb_pgm_str_12 /* "event: " */, false, ofs, pos1))
+        response.dataType = firebase_data_type::d_boolean;
+        response.boolData = false;
+    }
+    else if (len >= 4 && strncmp_P(d, firebase_pgm_str_59 /* "null" */, 4) == 0)
+        response.dataType = firebase_data_type::d_null;
+    else if (ev.path && len < 32)
+    {
+        char num[32];
+        memcpy(num, d, len);
+        num[len] = 0;
+        double v = atof(num);
+
+        if (memchr(d, '.', len))
         {
-            ofs = pos1 + 1;
-            if (Core.sh.find(payloads, firebase_rtdb_pgm_str_13 /* "data: " */, false, ofs, pos2))
+            if (len <= 7)
             {
-                ofs = pos2 + 1;
-                if (Core.sh.find(payloads, firebase_pgm_str_12 /* "\n" */, false, ofs, pos3))
-                    ofs = pos3 + 1;
-                else
-                    pos3 = payloads.length();
-
-                payload.push_back(payloads.substr(pos1, pos3 - pos1));
+                response.floatData = v;
+                response.dataType = firebase_data_type::d_float;
             }
+            else
+            {
+                response.doubleData = v;
+                response.dataType = firebase_data_type::d_double;
+            }
+        }
+        else if (v > 0x7fffffff)
+        {
+            response.doubleData = v;
+            response.dataType = firebase_data_type::d_double;
+        }
+        else
+        {
+            response.intData = (int)v;
+            response.dataType = firebase_data_type::d_integer;
         }
     }
 }
 
-void FB_RTDB::parseStreamPayload(FirebaseData *fbdo, const MB_String &payload)
+void FB_RTDB::parseStreamPayload(FirebaseData *fbdo, const firebase_sse_event_t &ev)
 {
     struct server_response_data_t response;
 
-    Core.hh.parseRespPayload(&Core.sh, payload, response, false);
+    response.isEvent = true;
+    response.hasEventData = true;
+    response.eventType.append(ev.event, ev.eventLen);
+
+    if (ev.path)
+        response.eventPath.append(ev.path, ev.pathLen);
+
+    setStreamDataType(ev, response);
+
+    // blob data is decoded from the event span, no copy needed
+    if (ev.path && response.dataType != d_blob && response.dataType != d_file)
+    {
+        response.eventData.append(ev.data, ev.dataLen);
+        response.payloadLen = ev.dataLen;
+    }
 
     fbdo->session.rtdb.resp_data_type = response.dataType;
     fbdo->session.content_length = response.payloadLen;
@@ -2881,7 +3921,8 @@ void FB_RTDB::parseStreamPayload(FirebaseData *fbdo, const MB_String &payload)
         }
 
         fbdo->session.rtdb.raw.clear();
-        Core.bh.decodeToArray<uint8_t>(&Core.mbfs, payload.c_str() + response.payloadOfs, *fbdo->session.rtdb.blob);
+        Core.bh.decodeToArray<uint8_t>(&Core.mbfs, ev.data + strlen_P(firebase_rtdb_pgm_str_7 /* "\"blob,base64," */),
+                                       response.payloadLen, *fbdo->session.rtdb.blob);
     }
     else if (fbdo->session.rtdb.resp_data_type == d_file)
     {
@@ -2892,8 +3933,12 @@ void FB_RTDB::parseStreamPayload(FirebaseData *fbdo, const MB_String &payload)
     if (Core.sh.compare(response.eventType, 0, firebase_pgm_str_16 /* "put" */) ||
         Core.sh.compare(response.eventType, 0, firebase_pgm_str_17 /* "patch" */))
     {
+        // apply the event at its path to the local copy
+        if (ev.path && fbdo->_mirror.enabled())
+            fbdo->_mirror.apply(Core.sh.compare(response.eventType, 0, firebase_pgm_str_17 /* "patch" */),
+                                ev.path, ev.pathLen, ev.data, ev.dataLen);
 
-        handlePayload(fbdo, response, payload);
+        handlePayload(fbdo, response, response.eventData);
 
         // Any stream update?
         // based on BLOB or file event data changes (no old data available for comparision or inconvenient for large data)
@@ -2946,42 +3991,25 @@ void FB_RTDB::parsePayload(FirebaseData *fbdo, firebase_rtdb_request_info_t *req
         // stream data?
         if (response.isEvent)
         {
-            int pos = 0, ofs = 0, jsonCount = 0;
-            bool validJson = false;
-
-            // counting the occurences of JSON sets
-            while (pos > -1)
-            {
-                if (Core.sh.find(payload, firebase_rtdb_pgm_str_12 /* "event: " */, false, ofs, pos))
-                {
-                    ofs = pos + 1;
-                    jsonCount++;
-                }
-            }
+            // Stream data may contain multiple events in case simultaneously children data changes,
+            // the parser passes each complete event to callback function as it is tokenized.
+            // The partial event at the end is kept in parser until the rest is arrived.
+            size_t events = fbdo->_sse.feed(payload.c_str(), payload.length(),
+                                            [this, fbdo](const firebase_sse_event_t &ev)
+                                            {
+                                                parseStreamPayload(fbdo, ev);
+                                                sendCB(fbdo);
+                                            });
+            payload.clear();
 
-            // we need to spit the tream data if stream data contains multiple sets of JSON
-            // that happens in case simultaneously children data changes.
-            // {json1}{json..}{json n}
-            // Then we pase each JSON and send to callback function.
-            MB_VECTOR<MB_String> payloadList;
-            splitStreamPayload(payload, payloadList);
-            for (size_t i = 0; i < payloadList.size(); i++)
+            if (events > 0 || fbdo->_sse.pending())
             {
-                if (Core.ut.validJS(payloadList[i].c_str()))
+                if (events > 0)
                 {
-                    validJson = true;
-                    parseStreamPayload(fbdo, payloadList[i].c_str());
-                    sendCB(fbdo);
+                    fbdo->session.rtdb.data_millis = millis();
+                    fbdo->session.rtdb.data_tmo = false;
                 }
             }
-            payloadList.clear(); // clear payload after splitting
-            payload.clear();
-
-            if (validJson)
-            {
-                fbdo->session.rtdb.data_millis = millis();
-                fbdo->session.rtdb.data_tmo = false;
-            }
             else
             {
                 fbdo->session.rtdb.data_millis = 0;
@@ -3089,6 +4117,12 @@ void FB_RTDB::handlePayload(FirebaseData *fbdo, struct server_response_data_t &r
     }
 }
 
+size_t FB_RTDB::tcpWriteJson(void *ctx, const unsigned char *data, size_t len)
+{
+    int r = reinterpret_cast<FirebaseData *>(ctx)->tcpWrite(data, len);
+    return r == (int)len ? len : 0;
+}
+
 int FB_RTDB::getPayloadLen(firebase_rtdb_request_info_t *req)
 {
     size_t len = 0;
@@ -3101,12 +4135,12 @@ int FB_RTDB::getPayloadLen(firebase_rtdb_request_info_t *req)
             else if (req->data.type == d_json)
             {
                 FirebaseJson *json = addrTo<FirebaseJson *>(req->data.address.din);
-                len = strlen(json->raw());
+                len = json->serializedBufferLength();
             }
             else if (req->data.type == d_array)
             {
                 FirebaseJsonArray *arr = addrTo<FirebaseJsonArray *>(req->data.address.din);
-                len = req->pre_payload.length() + strlen(arr->raw()) + req->post_payload.length();
+                len = req->pre_payload.length() + arr->serializedBufferLength() + req->post_payload.length();
             }
         }
         else if (req->payload.length() > 0)
@@ -3155,6 +4189,90 @@ bool FB_RTDB::hasPayload(struct firebase_rtdb_request_info_t *req)
     return getHTTPMethod(req) == http_put || getHTTPMethod(req) == http_post || getHTTPMethod(req) == http_patch;
 }
 
+bool FB_RTDB::headerTemplateValid(FirebaseData *fbdo)
+{
+    firebase_rtdb_header_template_t &tpl = fbdo->session.rtdb.header_tpl;
+
+    if (tpl.headers.length() == 0 ||
+        tpl.token_type != Core.getTokenType() ||
+        tpl.test_mode != Core.config->signer.test_mode ||
+        tpl.read_tmo != fbdo->session.rtdb.read_tmo)
+        return false;
+
+    // the token is compared in place, no other copy of it is kept
+    if ((tpl.token_in_headers || !tpl.test_mode) && tpl.token_len != Core.internal.auth_token.length())
+        return false;
+
+    if (tpl.token_len > 0)
+    {
+        const MB_String &src = tpl.token_in_headers ? tpl.headers : tpl.query;
+        if (memcmp(src.c_str() + tpl.token_ofs, Core.internal.auth_token.c_str(), tpl.token_len) != 0)
+            return false;
+    }
+
+    return strcmp(tpl.write_limit.c_str(), fbdo->session.rtdb.write_limit.c_str()) == 0 &&
+           strcmp(tpl.host.c_str(), Core.config->database_url.c_str()) == 0 &&
+           strcmp(tpl.custom_headers.c_str(), Core.config->signer.customHeaders.c_str()) == 0 &&
+           strcmp(tpl.auth_type.c_str(), Core.config->signer.tokens.auth_type.c_str()) == 0;
+}
+
+void FB_RTDB::buildHeaderTemplate(FirebaseData *fbdo)
+{
+    firebase_rtdb_header_template_t &tpl = fbdo->session.rtdb.header_tpl;
+
+    tpl.token_type = Core.getTokenType();
+    tpl.test_mode = Core.config->signer.test_mode;
+    tpl.read_tmo = fbdo->session.rtdb.read_tmo;
+    tpl.write_limit = fbdo->session.rtdb.write_limit;
+    tpl.host = Core.config->database_url;
+    tpl.custom_headers = Core.config->signer.customHeaders;
+    tpl.auth_type = Core.config->signer.tokens.auth_type;
+
+    tpl.token_in_headers = tpl.token_type == token_type_oauth2_access_token;
+    tpl.token_ofs = 0;
+    tpl.token_len = 0;
+
+    bool hasQueryParams = false;
+
+    tpl.query.clear();
+    tpl.query += firebase_rtdb_pgm_str_18; // ".json"
+
+    if (!tpl.token_in_headers && !tpl.test_mode)
+    {
+        Core.uh.addParam(tpl.query, firebase_rtdb_pgm_str_19 /* "auth=" */, "", hasQueryParams, true);
+        tpl.token_ofs = tpl.query.length();
+        tpl.token_len = Core.internal.auth_token.length();
+        tpl.query += Core.internal.auth_token;
+    }
+
+    if (tpl.read_tmo > 0)
+        Core.uh.addParam(tpl.query, firebase_rtdb_pgm_str_20 /* "timeout=" */,
+                         MB_String(tpl.read_tmo) + firebase_rtdb_pgm_str_21 /* "ms" */, hasQueryParams);
+
+    Core.uh.addParam(tpl.query, firebase_rtdb_pgm_str_22 /* "writeSizeLimit=" */, tpl.write_limit, hasQueryParams);
+
+    tpl.has_query_params = hasQueryParams;
+
+    tpl.headers.clear();
+    Core.hh.addRequestHeaderLast(tpl.headers);
+    Core.hh.addHostHeader(tpl.headers, tpl.host.c_str());
+    Core.hh.addUAHeader(tpl.headers);
+    Core.hh.getCustomHeaders(&Core.sh, tpl.headers, tpl.custom_headers);
+
+    if (tpl.token_in_headers)
+    {
+        Core.hh.addAuthHeaderFirst(tpl.headers, token_type_oauth2_access_token);
+
+        if (tpl.auth_type.length() > 0 && tpl.auth_type[tpl.auth_type.length() - 1] != ' ')
+            tpl.headers += firebase_pgm_str_9; // " "
+
+        tpl.token_ofs = tpl.headers.length();
+        tpl.token_len = Core.internal.auth_token.length();
+        tpl.headers += Core.internal.auth_token;
+        Core.hh.addNewLine(tpl.headers);
+    }
+}
+
 bool FB_RTDB::sendRequestHeader(FirebaseData *fbdo, struct firebase_rtdb_request_info_t *req)
 {
     firebase_request_method http_method = getHTTPMethod(req);
@@ -3167,24 +4285,32 @@ bool FB_RTDB::sendRequestHeader(FirebaseData *fbdo, struct firebase_rtdb_request
     {
         int p;
         if (req->data.address.din > 0 && req->data.type == d_json)
-            hasServerValue = Core.sh.find(addrTo<FirebaseJson *>(req->data.address.din)->raw(),
-                                          firebase_rtdb_pgm_str_17 /* "\".sv\"" */, false, 0, p);
+            hasServerValue = addrTo<FirebaseJson *>(req->data.address.din)->hasKey(".sv");
         else
             hasServerValue = Core.sh.find(req->payload, firebase_rtdb_pgm_str_17 /* "\".sv\"" */, false, 0, p);
     }
 
-    MB_String header;
+    // The request is gathered from the request line, the prebuilt query and headers (token,
+    // host, options) and the per request parts, and sent in one write.
+    if (!headerTemplateValid(fbdo))
+        buildHeaderTemplate(fbdo);
 
-    Core.hh.addRequestHeaderFirst(header, fbdo->session.classic_request &&
-                                                  (http_method == http_put || http_method == http_delete)
-                                              ? http_post
-                                              : http_method);
+    firebase_rtdb_header_template_t &tpl = fbdo->session.rtdb.header_tpl;
+
+    // request line and the per request query parameters
+    MB_String line;
+
+    Core.hh.addRequestHeaderFirst(line, fbdo->session.classic_request &&
+                                                (http_method == http_put || http_method == http_delete)
+                                            ? http_post
+                                            : http_method);
 
     Core.ut.makePath(req->path);
-    header += req->path;
+    line += req->path;
 
-    if (req->method == http_patch || req->method == rtdb_update_nocontent)
-        header += firebase_pgm_str_1; // "/"
+    if ((req->method == http_patch || req->method == rtdb_update_nocontent) &&
+        (req->path.length() == 0 || req->path[req->path.length() - 1] != '/'))
+        line += firebase_pgm_str_1; // "/"
 
     bool appendAuth = false;
     bool hasQueryParams = false;
@@ -3199,35 +4325,23 @@ bool FB_RTDB::sendRequestHeader(FirebaseData *fbdo, struct firebase_rtdb_request
     else
         appendAuth = true;
 
+    MB_String params;
+
     if (appendAuth)
+        hasQueryParams = tpl.has_query_params;
+    else
     {
-        header += firebase_rtdb_pgm_str_18; // ".json"
-        if (Core.getTokenType() != token_type_oauth2_access_token && !Core.config->signer.test_mode)
-            Core.uh.addParam(header, firebase_rtdb_pgm_str_19 /* "auth=" */, "", hasQueryParams, true);
-
-        fbdo->tcpSend(header.c_str());
-        header.clear();
-
-        if (fbdo->session.response.code < 0)
-            return false;
-
-        if (Core.getTokenType() != token_type_oauth2_access_token && !Core.config->signer.test_mode)
-            fbdo->tcpSend(Core.internal.auth_token.c_str());
+        if (fbdo->session.rtdb.read_tmo > 0)
+            Core.uh.addParam(params, firebase_rtdb_pgm_str_20 /* "timeout=" */,
+                             MB_String(fbdo->session.rtdb.read_tmo) + firebase_rtdb_pgm_str_21 /* "ms" */, hasQueryParams);
 
-        if (fbdo->session.response.code < 0)
-            return false;
+        Core.uh.addParam(params, firebase_rtdb_pgm_str_22 /* "writeSizeLimit=" */,
+                         fbdo->session.rtdb.write_limit, hasQueryParams);
     }
 
-    if (fbdo->session.rtdb.read_tmo > 0)
-        Core.uh.addParam(header, firebase_rtdb_pgm_str_20 /* "timeout=" */,
-                         MB_String(fbdo->session.rtdb.read_tmo) + firebase_rtdb_pgm_str_21 /* "ms" */, hasQueryParams);
-
-    Core.uh.addParam(header, firebase_rtdb_pgm_str_22 /* "writeSizeLimit=" */,
-                     fbdo->session.rtdb.write_limit, hasQueryParams);
-
     if (req->method == rtdb_get_shallow)
     {
-        Core.uh.addParam(header, firebase_rtdb_pgm_str_23 /* "shallow=true" */, "", hasQueryParams, true);
+        Core.uh.addParam(params, firebase_rtdb_pgm_str_23 /* "shallow=true" */, "", hasQueryParams, true);
         fbdo->session.rtdb.shallow_flag = true;
     }
 
@@ -3236,54 +4350,30 @@ bool FB_RTDB::sendRequestHeader(FirebaseData *fbdo, struct firebase_rtdb_request
     if (req->method == http_get && query && query->_orderBy.length() > 0)
     {
         hasQuery = true;
-        Core.uh.addParam(header, firebase_rtdb_pgm_str_24 /* "orderBy=" */, query->_orderBy, hasQueryParams);
-        Core.uh.addParam(header, firebase_rtdb_pgm_str_25 /* "&limitToFirst=" */, query->_limitToFirst, hasQueryParams);
-        Core.uh.addParam(header, firebase_rtdb_pgm_str_26 /* "&limitToLast=" */, query->_limitToLast, hasQueryParams);
-        Core.uh.addParam(header, firebase_rtdb_pgm_str_27 /* "&startAt=" */, query->_startAt, hasQueryParams);
-        Core.uh.addParam(header, firebase_rtdb_pgm_str_30 /* "&endAt=" */, query->_endAt, hasQueryParams);
-        Core.uh.addParam(header, firebase_rtdb_pgm_str_31 /* "&equalTo=" */, query->_equalTo, hasQueryParams);
+        Core.uh.addParam(params, firebase_rtdb_pgm_str_24 /* "orderBy=" */, query->_orderBy, hasQueryParams);
+        Core.uh.addParam(params, firebase_rtdb_pgm_str_25 /* "&limitToFirst=" */, query->_limitToFirst, hasQueryParams);
+        Core.uh.addParam(params, firebase_rtdb_pgm_str_26 /* "&limitToLast=" */, query->_limitToLast, hasQueryParams);
+        Core.uh.addParam(params, firebase_rtdb_pgm_str_27 /* "&startAt=" */, query->_startAt, hasQueryParams);
+        Core.uh.addParam(params, firebase_rtdb_pgm_str_30 /* "&endAt=" */, query->_endAt, hasQueryParams);
+        Core.uh.addParam(params, firebase_rtdb_pgm_str_31 /* "&equalTo=" */, query->_equalTo, hasQueryParams);
     }
 
     if (req->method == rtdb_backup)
     {
-        Core.uh.addParam(header, firebase_rtdb_pgm_str_32 /* "format=export" */, "", hasQueryParams, true);
-        Core.uh.addParam(header, firebase_rtdb_pgm_str_28 /* "download=" */, fbdo->session.rtdb.filename, hasQueryParams);
+        Core.uh.addParam(params, firebase_rtdb_pgm_str_32 /* "format=export" */, "", hasQueryParams, true);
+        Core.uh.addParam(params, firebase_rtdb_pgm_str_28 /* "download=" */, fbdo->session.rtdb.filename, hasQueryParams);
     }
 
     if (req->method == http_get && req->filename.length() > 0)
-        Core.uh.addParam(header, firebase_rtdb_pgm_str_28 /* "download=" */, fbdo->session.rtdb.filename, hasQueryParams);
+        Core.uh.addParam(params, firebase_rtdb_pgm_str_28 /* "download=" */, fbdo->session.rtdb.filename, hasQueryParams);
 
     if (req->async || req->method == rtdb_get_nocontent ||
         req->method == rtdb_restore || req->method == rtdb_set_nocontent ||
         req->method == rtdb_update_nocontent)
-        Core.uh.addParam(header, firebase_rtdb_pgm_str_29 /* "print=silent" */, "", hasQueryParams, true);
-
-    Core.hh.addRequestHeaderLast(header);
-    Core.hh.addHostHeader(header, Core.config->database_url.c_str());
-    Core.hh.addUAHeader(header);
-    Core.hh.getCustomHeaders(&Core.sh, header, Core.config->signer.customHeaders);
-
-    if (Core.getTokenType() == token_type_oauth2_access_token)
-    {
-        Core.hh.addAuthHeaderFirst(header, token_type_oauth2_access_token);
-
-        if (Core.config->signer.tokens.auth_type.length() > 0 &&
-            Core.config->signer.tokens.auth_type[Core.config->signer.tokens.auth_type.length() - 1] != ' ')
-            header += firebase_pgm_str_9; // " "
-
-        fbdo->tcpSend(header.c_str());
-        header.clear();
+        Core.uh.addParam(params, firebase_rtdb_pgm_str_29 /* "print=silent" */, "", hasQueryParams, true);
 
-        if (fbdo->session.response.code < 0)
-            return false;
-
-        fbdo->tcpSend(Core.internal.auth_token.c_str());
-
-        if (fbdo->session.response.code < 0)
-            return false;
-
-        Core.hh.addNewLine(header);
-    }
+    // the per request headers
+    MB_String header;
 
     // Timestamp cannot use with ETag header, due to internal server error
     if (!hasServerValue && !hasQuery && req->data.type != d_timestamp &&
@@ -3337,8 +4427,18 @@ bool FB_RTDB::sendRequestHeader(FirebaseData *fbdo, struct firebase_rtdb_request
 
     Core.hh.addNewLine(header);
 
-    fbdo->tcpSend(header.c_str());
-    header.clear();
+    // gather
+    MB_String out;
+    out.reserve(line.length() + (appendAuth ? tpl.query.length() : 0) + params.length() +
+                tpl.headers.length() + header.length());
+    out += line;
+    if (appendAuth)
+        out += tpl.query;
+    out += params;
+    out += tpl.headers;
+    out += header;
+
+    fbdo->tcpSend(out.c_str());
 
     if (fbdo->session.response.code < 0)
         return false;
@@ -3353,15 +4453,10 @@ void FB_RTDB::removeStreamCallback(FirebaseData *fbdo)
     fbdo->_dataAvailableCallback = NULL;
     fbdo->_timeoutCallback = NULL;
 
-    if (Core.internal.sessions.size() == 0)
-    {
 #if defined(ESP32)
-        if (Core.internal.stream_task_handle)
-            vTaskDelete(Core.internal.stream_task_handle);
-
-        Core.internal.stream_task_handle = NULL;
+    if (Core.internal.sessions.size() == 0)
+        stopStreamTask();
 #endif
-    }
 }
 
 void FB_RTDB::clearDataStatus(FirebaseData *fbdo)
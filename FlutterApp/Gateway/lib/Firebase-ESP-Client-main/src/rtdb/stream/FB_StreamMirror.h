@@ -0,0 +1,786 @@
+
+/**
+ * Google's Firebase Realtime Database stream mirror cache, FB_StreamMirror.h version 1.0.0
+ *
+ * Created October 18, 2026
+ *
+ * The MIT License (MIT)
+ * Copyright (c) 2023 K. Suwatchai (Mobizt)
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person returning a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "./FirebaseFS.h"
+
+#if defined(ENABLE_RTDB) || defined(FIREBASE_ENABLE_RTDB)
+
+#ifndef FIREBASE_STREAM_MIRROR_H
+#define FIREBASE_STREAM_MIRROR_H
+#include <Arduino.h>
+#include "./FB_Const.h"
+
+/* Local copy of the streamed subtree.
+ * The put and patch events are applied at their path, only the nodes whose value
+ * was changed get the new version. The paths are relative to the stream path
+ * e.g. "/N01/controls/pump".
+ * The children of the mirror root are kept in the LRU order, when the memory
+ * limit is reached the least recently used child is evicted and the root becomes
+ * incomplete (stub), the reads of the evicted child miss until the next put event
+ * brings it back.
+ */
+class FB_StreamMirror
+{
+public:
+    FB_StreamMirror() {}
+
+    ~FB_StreamMirror() { end(); }
+
+    /**
+     * Enable the mirror.
+     * @param maxSize The memory limit in bytes, 0 for no limit.
+     */
+    void begin(size_t maxSize)
+    {
+#if defined(ESP32)
+        if (!_lock)
+            _lock = xSemaphoreCreateMutex();
+#endif
+        lock();
+        _max = maxSize;
+        if (!_root)
+            _root = newNode(nullptr, nullptr, 0);
+        // nothing is known until the first put event
+        _root->stub = true;
+        unlock();
+    }
+
+    // Disable the mirror and free all nodes.
+    void end()
+    {
+        lock();
+        freeNode(_root);
+        _root = nullptr;
+        _head = _tail = nullptr;
+        _bytes = 0;
+        unlock();
+    }
+
+    bool enabled() const { return _root != nullptr; }
+
+    // Drop the data (e.g. the stream path was changed).
+    void clear()
+    {
+        if (!enabled())
+            return;
+        size_t max = _max;
+        end();
+        begin(max);
+    }
+
+    /**
+     * Apply the stream event data.
+     * @param patch true for patch event, false for put event.
+     * @param path The event path.
+     * @param pathLen The length of path.
+     * @param data The event data (JSON).
+     * @param dataLen The length of data.
+     * @return true when any value was changed.
+     */
+    bool apply(bool patch, const char *path, size_t pathLen, const char *data, size_t dataLen)
+    {
+        if (!enabled())
+            return false;
+
+        lock();
+        // the mirror may be ended by other task before the lock was taken
+        if (!_root)
+        {
+            unlock();
+            return false;
+        }
+
+        // the nodes changed by this event get the next version
+        _next = _version + 1;
+
+        data = skipWS(data, data + dataLen);
+        const char *end = data + dataLen;
+        while (end > data && isWS(end[-1]))
+            end--;
+
+        firebase_mirror_node_t *node = walk(path, pathLen, true);
+        bool changed = false;
+
+        if (isNull(data, end))
+        {
+            changed = remove(node);
+            // the empty parents were removed too
+            node = walk(path, pathLen, false);
+        }
+        else if (patch && end > data && *data == '{')
+        {
+            _keep = node;
+            changed = patchObject(node, data, end);
+            _keep = nullptr;
+            // the patch that deleted all children deletes the node too
+            if (node != _root && !node->stub && node->children.size() == 0 && node->value.length() == 0)
+            {
+                remove(node);
+                node = walk(path, pathLen, false);
+            }
+        }
+        else
+            changed = assign(node, data, end);
+
+        if (changed)
+        {
+            _version = _next;
+            for (; node; node = node->parent)
+                node->version = _version;
+        }
+
+        evict();
+        unlock();
+        return changed;
+    }
+
+    /**
+     * Get the raw JSON of the node.
+     * @param path The path relative to the stream path.
+     * @param out The JSON result, "null" when the node does not exist.
+     * @return false when the node is not known locally (not received yet or evicted).
+     */
+    bool get(const char *path, MB_String &out)
+    {
+        out.clear();
+        if (!enabled())
+            return false;
+
+        lock();
+        firebase_mirror_node_t *node = nullptr;
+        bool ret = _root && find(path, node);
+        if (ret)
+        {
+            if (node)
+                ret = toJson(node, out);
+            else
+                out = "null";
+        }
+        if (!ret)
+            out.clear();
+        unlock();
+        return ret;
+    }
+
+    bool get(const char *path, String &out)
+    {
+        MB_String s;
+        bool ret = get(path, s);
+        out = s.c_str();
+        return ret;
+    }
+
+    /**
+     * Get the string value of the node.
+     * @param path The path relative to the stream path.
+     * @param out The string without the double quotes.
+     * @return true when the node is known and is the string.
+     */
+    bool getString(const char *path, String &out)
+    {
+        MB_String s;
+        if (!get(path, s) || s.length() < 2 || s[0] != '"')
+            return false;
+        out = s.substr(1, s.length() - 2).c_str();
+        return true;
+    }
+
+    bool getInt(const char *path, int &out)
+    {
+        MB_String s;
+        if (!get(path, s) || !isNumber(s))
+            return false;
+        out = atoi(s.c_str());
+        return true;
+    }
+
+    bool getDouble(const char *path, double &out)
+    {
+        MB_String s;
+        if (!get(path, s) || !isNumber(s))
+            return false;
+        out = atof(s.c_str());
+        return true;
+    }
+
+    bool getBool(const char *path, bool &out)
+    {
+        MB_String s;
+        if (!get(path, s) || (strcmp(s.c_str(), "true") != 0 && strcmp(s.c_str(), "false") != 0))
+            return false;
+        out = s[0] == 't';
+        return true;
+    }
+
+    // The version of the last applied change.
+    uint32_t version() const { return _version; }
+
+    /**
+     * Get the version of the node.
+     * @param path The path relative to the stream path.
+     * @return The version of the last change in this subtree, 0 when it is unknown.
+     */
+    uint32_t version(const char *path)
+    {
+        uint32_t ret = 0;
+        if (!enabled())
+            return ret;
+
+        lock();
+        firebase_mirror_node_t *node = nullptr;
+        if (_root && find(path, node) && node)
+            ret = node->version;
+        unlock();
+        return ret;
+    }
+
+    // The memory used by the mirror nodes in bytes.
+    size_t size() const { return _bytes; }
+
+private:
+    struct firebase_mirror_node_t
+    {
+        MB_String key;
+        // the raw JSON of the leaf node, empty for object
+        MB_String value;
+        MB_VECTOR<firebase_mirror_node_t *> children;
+        firebase_mirror_node_t *parent = nullptr;
+        // LRU list links, the children of the root only
+        firebase_mirror_node_t *prev = nullptr;
+        firebase_mirror_node_t *next = nullptr;
+        uint32_t version = 0;
+        uint32_t mark = 0;
+        bool stub = false;
+        bool listed = false;
+    };
+
+    void lock()
+    {
+#if defined(ESP32)
+        if (_lock)
+            xSemaphoreTake(_lock, portMAX_DELAY);
+#endif
+    }
+
+    void unlock()
+    {
+#if defined(ESP32)
+        if (_lock)
+            xSemaphoreGive(_lock);
+#endif
+    }
+
+    static bool isWS(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+    static const char *skipWS(const char *p, const char *end)
+    {
+        while (p < end && isWS(*p))
+            p++;
+        return p;
+    }
+
+    static bool isNull(const char *p, const char *end)
+    {
+        return end - p == 4 && strncmp(p, "null", 4) == 0;
+    }
+
+    static bool isNumber(const MB_String &s)
+    {
+        return s.length() > 0 && (s[0] == '-' || (s[0] >= '0' && s[0] <= '9'));
+    }
+
+    // The end of the JSON value that starts at p.
+    static const char *valueEnd(const char *p, const char *end)
+    {
+        if (p >= end)
+            return end;
+
+        if (*p == '"')
+        {
+            for (p++; p < end; p++)
+            {
+                if (*p == '\\')
+                    p++;
+                else if (*p == '"')
+                    return p + 1;
+            }
+            return end;
+        }
+
+        if (*p == '{' || *p == '[')
+        {
+            int depth = 0;
+            for (; p < end; p++)
+            {
+                if (*p == '"')
+                {
+                    p = valueEnd(p, end) - 1;
+                    continue;
+                }
+                if (*p == '{' || *p == '[')
+                    depth++;
+                else if ((*p == '}' || *p == ']') && --depth == 0)
+                    return p + 1;
+            }
+            return end;
+        }
+
+        while (p < end && *p != ',' && *p != '}' && *p != ']' && !isWS(*p))
+            p++;
+        return p;
+    }
+
+    /**
+     * Iterate the members of object or the elements of array (keyed by index).
+     * @param p The start of object or array.
+     * @param end The end of object or array.
+     * @param fn The callable that receives key, key length, value and value end.
+     */
+    template <typename Fn>
+    static void members(const char *p, const char *end, Fn &&fn)
+    {
+        bool arr = *p == '[';
+        char close = arr ? ']' : '}';
+        size_t index = 0;
+        char buf[12];
+        p++;
+
+        while (p < end)
+        {
+            p = skipWS(p, end);
+            if (p >= end || *p == close)
+                break;
+
+            const char *key = buf;
+            size_t keyLen = 0;
+
+            if (arr)
+                keyLen = snprintf(buf, sizeof(buf), "%u", (unsigned)index++);
+            else
+            {
+                const char *ke = valueEnd(p, end);
+                if (ke - p < 2)
+                    break;
+                key = p + 1;
+                keyLen = ke - p - 2;
+                p = skipWS(ke, end);
+                if (p >= end || *p != ':')
+                    break;
+                p = skipWS(p + 1, end);
+            }
+
+            const char *ve = valueEnd(p, end);
+            fn(key, keyLen, p, ve);
+
+            p = skipWS(ve, end);
+            if (p < end && *p == ',')
+                p++;
+        }
+    }
+
+    size_t nodeSize(const firebase_mirror_node_t *node) const
+    {
+        return sizeof(firebase_mirror_node_t) + node->key.length();
+    }
+
+    void sub(size_t n) { _bytes = _bytes > n ? _bytes - n : 0; }
+
+    firebase_mirror_node_t *newNode(firebase_mirror_node_t *parent, const char *key, size_t keyLen)
+    {
+        firebase_mirror_node_t *node = new firebase_mirror_node_t();
+        if (key)
+            node->key.append(key, keyLen);
+        node->parent = parent;
+        _bytes += nodeSize(node);
+        return node;
+    }
+
+    void freeNode(firebase_mirror_node_t *node)
+    {
+        if (!node)
+            return;
+        clearChildren(node);
+        unlink(node);
+        sub(nodeSize(node) + node->value.length());
+        delete node;
+    }
+
+    void clearChildren(firebase_mirror_node_t *node)
+    {
+        for (size_t i = 0; i < node->children.size(); i++)
+            freeNode(node->children[i]);
+        MB_VECTOR<firebase_mirror_node_t *>().swap(node->children);
+    }
+
+    // Binary search of the child key, returns the insert position when not found.
+    size_t lowerBound(firebase_mirror_node_t *node, const char *key, size_t keyLen, bool &found)
+    {
+        size_t lo = 0, hi = node->children.size();
+        found = false;
+        while (lo < hi)
+        {
+            size_t mid = (lo + hi) / 2;
+            const MB_String &k = node->children[mid]->key;
+            size_t n = k.length() < keyLen ? k.length() : keyLen;
+            int c = strncmp(k.c_str(), key, n);
+            if (c == 0)
+                c = k.length() < keyLen ? -1 : (k.length() > keyLen ? 1 : 0);
+            if (c == 0)
+            {
+                found = true;
+                return mid;
+            }
+            if (c < 0)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        return lo;
+    }
+
+    firebase_mirror_node_t *child(firebase_mirror_node_t *node, const char *key, size_t keyLen, bool create)
+    {
+        bool found = false;
+        size_t pos = lowerBound(node, key, keyLen, found);
+        if (found)
+            return node->children[pos];
+        if (!create)
+            return nullptr;
+
+        // the leaf becomes the object
+        if (node->value.length() > 0)
+        {
+            sub(node->value.length());
+            node->value.clear();
+        }
+
+        firebase_mirror_node_t *c = newNode(node, key, keyLen);
+        node->children.insert(node->children.begin() + pos, c);
+        return c;
+    }
+
+    // The node at path, or its deepest existing ancestor when create is false.
+    firebase_mirror_node_t *walk(const char *path, size_t len, bool create)
+    {
+        firebase_mirror_node_t *node = _root;
+        const char *p = path, *end = path + len;
+
+        while (node && p < end)
+        {
+            while (p < end && *p == '/')
+                p++;
+            if (p >= end)
+                break;
+            const char *q = reinterpret_cast<const char *>(memchr(p, '/', end - p));
+            if (!q)
+                q = end;
+            firebase_mirror_node_t *c = child(node, p, q - p, create);
+            if (!c)
+                break;
+            if (node == _root)
+                touch(c);
+            node = c;
+            p = q;
+        }
+        return node;
+    }
+
+    // The node at the relative path (e.g. "a/b" of patch key) under node, null when it does not exist and create is false.
+    firebase_mirror_node_t *descend(firebase_mirror_node_t *node, const char *path, size_t len, bool create)
+    {
+        const char *p = path, *end = path + len;
+
+        while (node && p < end)
+        {
+            while (p < end && *p == '/')
+                p++;
+            if (p >= end)
+                break;
+            const char *q = reinterpret_cast<const char *>(memchr(p, '/', end - p));
+            if (!q)
+                q = end;
+            node = child(node, p, q - p, create);
+            if (node && node->parent == _root)
+                touch(node);
+            p = q;
+        }
+        return node;
+    }
+
+    // Locate the node for read, node is null when it is known to be absent.
+    bool find(const char *path, firebase_mirror_node_t *&node)
+    {
+        const char *p = path, *end = path + strlen(path);
+        node = _root;
+
+        while (p < end)
+        {
+            while (p < end && *p == '/')
+                p++;
+            if (p >= end)
+                break;
+            const char *q = reinterpret_cast<const char *>(memchr(p, '/', end - p));
+            if (!q)
+                q = end;
+            firebase_mirror_node_t *c = child(node, p, q - p, false);
+            if (!c)
+            {
+                // the absent child of the unknown (or evicted) node is unknown too
+                bool known = !isUnknown(node);
+                node = nullptr;
+                return known;
+            }
+            if (c->parent == _root)
+                touch(c);
+            node = c;
+            p = q;
+        }
+        return true;
+    }
+
+    // true when this node or any of its ancestors was not received completely.
+    bool isUnknown(firebase_mirror_node_t *node)
+    {
+        for (; node; node = node->parent)
+        {
+            if (node->stub)
+                return true;
+        }
+        return false;
+    }
+
+    bool toJson(firebase_mirror_node_t *node, MB_String &out)
+    {
+        if (node->stub)
+            return false;
+
+        if (node->children.size() == 0)
+        {
+            out += node->value.length() > 0 ? node->value.c_str() : "null";
+            return true;
+        }
+
+        out += '{';
+        for (size_t i = 0; i < node->children.size(); i++)
+        {
+            if (i > 0)
+                out += ',';
+            out += '"';
+            out += node->children[i]->key;
+            out += '"';
+            out += ':';
+            if (!toJson(node->children[i], out))
+                return false;
+        }
+        out += '}';
+        return true;
+    }
+
+    // Replace the node value (put), the unchanged nodes keep their version.
+    bool assign(firebase_mirror_node_t *node, const char *p, const char *end)
+    {
+        bool changed = node->stub;
+        node->stub = false;
+
+        if (end > p && (*p == '{' || *p == '['))
+        {
+            if (node->value.length() > 0)
+            {
+                sub(node->value.length());
+                node->value.clear();
+                changed = true;
+            }
+
+            uint32_t mark = ++_mark;
+            members(p, end, [this, node, mark, &changed](const char *key, size_t keyLen, const char *v, const char *ve)
+                    {
+                        if (isNull(v, ve))
+                            return;
+                        firebase_mirror_node_t *c = child(node, key, keyLen, true);
+                        c->mark = mark;
+                        if (assign(c, v, ve))
+                            changed = true; });
+
+            // the children that are not in the new value were deleted
+            for (size_t i = node->children.size(); i > 0; i--)
+            {
+                firebase_mirror_node_t *c = node->children[i - 1];
+                if (c->mark != mark)
+                {
+                    node->children.erase(node->children.begin() + (i - 1));
+                    freeNode(c);
+                    changed = true;
+                }
+            }
+        }
+        else
+        {
+            if (node->children.size() > 0)
+            {
+                clearChildren(node);
+                changed = true;
+            }
+
+            if (node->value.length() != (size_t)(end - p) || strncmp(node->value.c_str(), p, end - p) != 0)
+            {
+                sub(node->value.length());
+                node->value.clear();
+                node->value.append(p, end - p);
+                _bytes += node->value.length();
+                changed = true;
+            }
+        }
+
+        if (changed)
+            node->version = _next;
+
+        if (node->parent == _root)
+            touch(node);
+
+        return changed;
+    }
+
+    // Update the children of node, the other children are kept.
+    bool patchObject(firebase_mirror_node_t *node, const char *p, const char *end)
+    {
+        bool changed = false;
+
+        if (node->value.length() > 0)
+        {
+            sub(node->value.length());
+            node->value.clear();
+            changed = true;
+        }
+
+        members(p, end, [this, node, &changed](const char *key, size_t keyLen, const char *v, const char *ve)
+                {
+                    // the key can be the path of multi-location update e.g. "a/b"
+                    bool null = isNull(v, ve);
+                    firebase_mirror_node_t *c = descend(node, key, keyLen, !null);
+                    if (!c || c == node)
+                        return;
+                    if (null ? remove(c) : assign(c, v, ve))
+                        changed = true; });
+
+        if (changed)
+            node->version = _next;
+
+        return changed;
+    }
+
+    // Delete the node, the empty parent objects are deleted too (as the database does).
+    bool remove(firebase_mirror_node_t *node)
+    {
+        if (node == _root)
+        {
+            bool changed = node->stub || node->children.size() > 0 || node->value.length() > 0;
+            clearChildren(node);
+            sub(node->value.length());
+            node->value.clear();
+            node->stub = false;
+            return changed;
+        }
+
+        firebase_mirror_node_t *parent = node->parent;
+        bool found = false;
+        size_t pos = lowerBound(parent, node->key.c_str(), node->key.length(), found);
+        if (found)
+            parent->children.erase(parent->children.begin() + pos);
+        freeNode(node);
+        parent->version = _next;
+
+        // the target node of patch is kept until all members were applied
+        if (parent != _root && parent != _keep && !parent->stub && parent->children.size() == 0)
+            remove(parent);
+
+        return true;
+    }
+
+    // Move the child of root to the front of LRU list.
+    void touch(firebase_mirror_node_t *node)
+    {
+        if (_head == node)
+            return;
+        unlink(node);
+        node->next = _head;
+        if (_head)
+            _head->prev = node;
+        _head = node;
+        if (!_tail)
+            _tail = node;
+        node->listed = true;
+    }
+
+    void unlink(firebase_mirror_node_t *node)
+    {
+        if (!node->listed)
+            return;
+        if (node->prev)
+            node->prev->next = node->next;
+        if (node->next)
+            node->next->prev = node->prev;
+        if (_head == node)
+            _head = node->next;
+        if (_tail == node)
+            _tail = node->prev;
+        node->prev = node->next = nullptr;
+        node->listed = false;
+    }
+
+    void evict()
+    {
+        while (_max > 0 && _bytes > _max && _tail)
+        {
+            firebase_mirror_node_t *node = _tail;
+            bool found = false;
+            size_t pos = lowerBound(_root, node->key.c_str(), node->key.length(), found);
+            if (found)
+                _root->children.erase(_root->children.begin() + pos);
+            freeNode(node);
+            // the root is incomplete, its absent children are unknown
+            _root->stub = true;
+        }
+    }
+
+    firebase_mirror_node_t *_root = nullptr;
+    firebase_mirror_node_t *_head = nullptr;
+    firebase_mirror_node_t *_tail = nullptr;
+    firebase_mirror_node_t *_keep = nullptr;
+    size_t _max = 0;
+    size_t _bytes = 0;
+    uint32_t _version = 0;
+    uint32_t _next = 0;
+    uint32_t _mark = 0;
+#if defined(ESP32)
+    SemaphoreHandle_t _lock = NULL;
+#endif
+};
+
+#endif
+
+#endif
@@ -37,6 +37,8 @@
 
 #include "./rtdb/stream/FB_Stream.h"
 #include "./rtdb/stream/FB_MP_Stream.h"
+#include "./rtdb/stream/FB_SSE.h"
+#include "./rtdb/stream/FB_StreamMirror.h"
 #include "./rtdb/QueueInfo.h"
 #include "./rtdb/QueueManager.h"
 
@@ -749,6 +751,27 @@ public:
    */
   bool isKeepAlive();
 
+  /** Get the connection reuse statistics of this session.
+   *
+   * @return FirebaseConnectionStats i.e. the new connections, the requests sent,
+   * the requests sent on the opened connection and the pipelined requests.
+   */
+  FirebaseConnectionStats connectionStats();
+
+  /** Reset the connection reuse statistics.
+   */
+  void resetConnectionStats();
+
+#if defined(ENABLE_RTDB) || defined(FIREBASE_ENABLE_RTDB)
+  /** Get the local copy of the subscribed node.
+   *
+   * @return FB_StreamMirror reference.
+   *
+   * @note The mirror is enabled by Firebase.RTDB.beginStreamMirror.
+   */
+  FB_StreamMirror &streamMirror() { return _mirror; }
+#endif
+
   Firebase_TCP_Client tcpClient;
 
 #if defined(FIREBASE_ESP32_CLIENT) || defined(FIREBASE_ESP8266_CLIENT)
@@ -770,6 +793,8 @@ private:
   MultiPathStreamEventCallback _multiPathDataCallback = NULL;
   StreamTimeoutCallback _timeoutCallback = NULL;
   QueueInfoCallback _queueInfoCallback = NULL;
+  FB_SSEParser _sse;
+  FB_StreamMirror _mirror;
 #endif
 #if defined(FIREBASE_ESP_CLIENT)
 #if defined(ENABLE_FB_FUNCTIONS) || defined(FIREBASE_ENABLE_FB_FUNCTIONS)
@@ -859,7 +884,7 @@ private:
   void setTimeout();
   void setSecure();
 #if defined(ENABLE_ERROR_QUEUE) || defined(FIREBASE_ENABLE_ERROR_QUEUE) && (defined(ENABLE_RTDB) || defined(FIREBASE_ENABLE_RTDB))
-  void addQueue(QueueItem *qItem);
+  void addQueue(QueueItem &&qItem);
 #endif
 #if defined(ENABLE_RTDB) || defined(FIREBASE_ENABLE_RTDB)
   void clearQueueItem(QueueItem *item);
@@ -14,6 +14,7 @@
 #include <LoRa_E32.h>
 #include <EthernetUdp.h>
 #include <Dns.h>
+#include "RecordWriter.h"
 
 // ================== CONFIG ==================
 #define DEBUG 1
@@ -45,6 +46,7 @@ static const char* USER_EMAIL   = "p@gmail.com";
 static const char* USER_PASS    = "123456";
 
 LoRa_E32 lora(&Serial2, 9600);
+#define LORA_AUX_PIN 4   // AUX E32: LOW = module đang bận (đang phát/đang xuất gói nhận)
 
 // ================== GLOBALS ==================
 static bool g_stream_N01 = false;
@@ -75,10 +77,12 @@ ESP_SSLClient ssl_stream_N01, ssl_stream_N02;
 AsyncClient   aStreamN01(ssl_stream_N01), aStreamN02(ssl_stream_N02);
 
 // Node LoRa fixed addressing
-struct NodeLoraCfg { const char* nodeId; uint8_t addh, addl, ch; };
+// sensorNode: số n của node cảm biến (gói uplink [n,...]) cấp số đo cho luật ngưỡng
+// của node điều khiển này, 0 = không chuyển số đo
+struct NodeLoraCfg { const char* nodeId; uint8_t addh, addl, ch; uint8_t sensorNode; };
 static NodeLoraCfg NODES[] = {
-  {"N01", 0x00, 0x03, 0x17},
-  {"N02", 0x00, 0x04, 0x17},
+  {"N01", 0x00, 0x03, 0x17, 1},
+  {"N02", 0x00, 0x04, 0x17, 2},
 };
 static const size_t NODES_N = sizeof(NODES)/sizeof(NODES[0]);
 
@@ -91,11 +95,80 @@ struct DeviceScheduleCfg {
   int  onMinutes;   // phút trong ngày 0..1439, -1 = không cấu hình
   int  offMinutes;  // phút trong ngày 0..1439, -1 = không cấu hình
   int  lastApplied; // -1 = chưa từng gửi, 0 = OFF, 1 = ON (do lịch)
+  int  thrSensor;   // chỉ số SENSOR_KEYS, -1 = không có ngưỡng
+  float thrOn;      // ngưỡng bật  (đơn vị app, vd. % độ ẩm đất)
+  float thrOff;     // ngưỡng tắt
 };
 
 static DeviceScheduleCfg g_schedules[NODES_N][DEV_COUNT];
 static bool g_schedLoaded[NODES_N];
+static String g_devModes[NODES_N][DEV_COUNT];   // cache <dev>Mode từ /controls
+static int8_t g_ctrlState[NODES_N][DEV_COUNT];  // cache <dev> từ /controls, -1 = chưa biết
+static uint32_t g_beaconUptime[NODES_N];        // "up" của beacon trước, phát hiện node reset
+
+// ====== LUẬT CỤC BỘ TRÊN NODE ĐIỀU KHIỂN ======
+// Khung nhị phân, khớp với Node1_Control.ino
+#define CMD_BIN_MAGIC   0xC1
+#define CMD_OP_SET      0x01
+#define CMD_OP_TIME     0x02
+#define CMD_OP_RULES    0x03
+#define CMD_OP_SENSOR   0x04
+#define CMD_ID_MAX      16
+#define CMD_SET_F_SCHED 0x80    // bit trong byte value: lệnh từ lịch, node không coi là lệnh tay
+#define RULE_F_ENABLED  0x01
+#define RULE_F_SCHED    0x02
+#define RULE_F_THRESH   0x04
+
+// Cùng thứ tự với gói uplink [n,t10,h10,s10,lux,eco2,tvoc,aqi,ts5]
+static const uint8_t SENSOR_COUNT = 7;
+static const char *SENSOR_KEYS[SENSOR_COUNT]  = {"t", "h", "s", "l", "ec", "tv", "aq"};
+static const float SENSOR_SCALE[SENSOR_COUNT] = {10, 10, 10, 1, 1, 1, 1};
+
+struct __attribute__((packed)) LocalRuleWire {
+  uint8_t  flags;
+  uint8_t  sensor;
+  uint16_t onMin, offMin;
+  int16_t  thrOn, thrOff;
+};
 
+static const uint32_t NODE_TIME_SYNC_MS = 10UL * 60UL * 1000UL;  // đồng bộ giờ + gửi lại luật
+static LocalRuleWire g_rulesSent[NODES_N][DEV_COUNT];
+static bool          g_rulesSentOk[NODES_N];
+static uint32_t      g_timeSentMs[NODES_N];
+static uint8_t       g_sensorFwd[NODES_N][2 + SENSOR_COUNT * sizeof(int16_t)];
+static bool          g_sensorFwdPending[NODES_N];
+
+// ====== LORA TX SCHEDULER (nghe trước khi phát + khe thời gian) ======
+// Chu kỳ SLOT_CYCLE_MS neo theo giây RTC, chia khe SLOT_LEN_MS: khe 0 cho
+// gateway, khe k cho node cảm biến k. Gateway phát broadcast CMD_OP_SLOT để
+// node cảm biến canh khe; node chưa nhận được thì chỉ dùng jitter ngẫu nhiên.
+#define CMD_OP_SLOT         0x06
+#define SLOT_CYCLE_MS       20000UL   // = SEND_INTERVAL_MS của node cảm biến
+#define SLOT_LEN_MS         2000UL
+#define SLOT_GUARD_MS       1500UL    // không phát downlink trong đầu khe của node đang hoạt động
+#define SLOT_BEACON_MS      (5UL * 60UL * 1000UL)
+#define SENSOR_ACTIVE_MS    (3UL * SLOT_CYCLE_MS)
+#define LBT_HOLDOFF_MIN_MS  30        // sau khi nhận gói, chờ ngẫu nhiên rồi mới phát
+#define LBT_HOLDOFF_MAX_MS  150
+static const uint8_t SLOT_COUNT = SLOT_CYCLE_MS / SLOT_LEN_MS;
+
+static uint32_t g_slotBaseMs  = 0;    // millis() tại đầu chu kỳ
+static uint32_t g_slotBeaconMs = 0;
+static uint32_t g_lastRxMs    = 0;
+static uint32_t g_txHoldoffMs = 0;
+static uint32_t g_sensorSeenMs[SLOT_COUNT];
+
+
+// "1" / "N1" / "N01" -> chỉ số trong NODES, -1 nếu không có
+static int nodeIndexById(const String& nodeId) {
+  String nid = nodeId;
+  if (nid.length() > 0 && (nid[0] == 'N' || nid[0] == 'n')) nid.remove(0, 1);
+  int num = nid.toInt();
+  for (size_t i = 0; i < NODES_N; i++) {
+    if (atoi(NODES[i].nodeId + 1) == num) return (int)i;
+  }
+  return -1;
+}
 
 static bool getLoraAddr(const String& nodeId, uint8_t& addh, uint8_t& addl, uint8_t& ch) {
   for (size_t i=0;i<NODES_N;i++) {
@@ -111,6 +184,7 @@ struct PendingCmd {
   String   nodeId;
   String   device;
   int      value;       // 0/1
+  bool     sched;       // lệnh do lịch sinh ra, không đè luật cục bộ
   String   cmdId;       // ví dụ N01-1a2b (ngắn, dễ debug)
   uint8_t  retryCount;  // đã gửi bao nhiêu lần
   uint32_t lastSentMs;  // millis() lần gửi gần nhất
@@ -139,7 +213,7 @@ static int findCmdById(const String& cmdId) {
 static inline String nodePathFromId(const String &nodeId, const String &tail);
 static inline String downlinkPath(const String& nodeId); //Xử lý đường dẫn downlink của các Node tới RTDB
 static void markDownlink(const String& nodeId, const String& cmdId, const char* status, const char* err = nullptr); //Xử lý ghi lệnh lên RTDB
-static bool sendDeviceCmd_LoRa(const String& nodeId, const String& device, int value);
+static bool sendDeviceCmd_LoRa(const String& nodeId, const String& device, int value, bool sched = false);
 static void handleDownlinkPayload(const String& nodeId, const String& childPath, const String& payload); //Xử lý 1 child của /nodes/<id>/downlink
 static void processDownlinkStream(AsyncResult &aResult);
 
@@ -286,29 +360,87 @@ static bool syncRtcViaNTP(uint16_t localPort = 2390, uint16_t timeoutMs = 1500)
   ntpUDP.stop();
   return false;
 }
+// ================== LORA TX SCHEDULER ==================
+static void slotClockSync() {
+  g_slotBaseMs = millis() - (uint32_t)(nowUnix() % (SLOT_CYCLE_MS / 1000UL)) * 1000UL;
+}
+static inline uint32_t slotPosMs() {
+  return (millis() - g_slotBaseMs) % SLOT_CYCLE_MS;
+}
+static inline void loraNoteRx() {
+  g_lastRxMs    = millis();
+  g_txHoldoffMs = random(LBT_HOLDOFF_MIN_MS, LBT_HOLDOFF_MAX_MS);
+}
+static inline void noteSensorSlot(int n) {
+  if (n > 0 && n < SLOT_COUNT) g_sensorSeenMs[n] = millis() | 1;
+}
+
+// true = được phát ngay: E32 rảnh, không có gói đang chờ đọc, đã qua holdoff
+// sau gói nhận gần nhất, và không rơi vào đầu khe của node cảm biến đang chạy.
+// Không chặn: nơi gọi để dành lần sau.
+static bool loraTxGate() {
+  if (digitalRead(LORA_AUX_PIN) == LOW) return false;
+  if (lora.available() > 0) return false;
+  if (millis() - g_lastRxMs < g_txHoldoffMs) return false;
+
+  uint32_t pos  = slotPosMs();
+  uint32_t slot = pos / SLOT_LEN_MS;
+  if (slot > 0 && g_sensorSeenMs[slot] && millis() - g_sensorSeenMs[slot] < SENSOR_ACTIVE_MS &&
+      (pos % SLOT_LEN_MS) < SLOT_GUARD_MS) {
+    return false;
+  }
+  return true;
+}
+
+// Broadcast vị trí hiện tại trong chu kỳ khe cho mọi node trên kênh
+static void sendSlotBeacon() {
+  slotClockSync();
+  uint16_t pos   = (uint16_t)slotPosMs();
+  uint16_t cycle = (uint16_t)SLOT_CYCLE_MS;
+  uint8_t frame[7];
+  frame[0] = CMD_BIN_MAGIC;
+  frame[1] = CMD_OP_SLOT;
+  memcpy(frame + 2, &pos, sizeof(pos));
+  memcpy(frame + 4, &cycle, sizeof(cycle));
+  frame[6] = (uint8_t)(SLOT_LEN_MS / 100UL);
+  lora.sendFixedMessage(0xFF, 0xFF, NODES[0].ch, frame, sizeof(frame));
+  g_slotBeaconMs = millis() | 1;
+}
+
 // ================== RTDB WRAPPERS ==================
+// Bản ghi status/telemetry có hình dạng cố định: khai báo khóa + kiểu một lần,
+// ghi thẳng vào buffer trên stack thay cho JsonWriter + object_t tạm
+namespace rec_key {
+  REC_FIELD(n,  rec::Int);
+  REC_FIELD(t,  rec::Fixed2);
+  REC_FIELD(h,  rec::Fixed2);
+  REC_FIELD(s,  rec::Fixed2);
+  REC_FIELD(l,  rec::Fixed2);
+  REC_FIELD(ts, rec::U64);
+  REC_FIELD(ec, rec::Int);
+  REC_FIELD(tv, rec::Int);
+  REC_FIELD(aq, rec::Int);
+}
+typedef rec::Record<rec_key::t, rec_key::h, rec_key::s, rec_key::l, rec_key::ts,
+                    rec_key::ec, rec_key::tv, rec_key::aq> StatusRecord;
+typedef rec::Record<rec_key::n, rec_key::t, rec_key::h, rec_key::s, rec_key::l, rec_key::ts,
+                    rec_key::ec, rec_key::tv, rec_key::aq> TelemetryRecord;
+static_assert(TelemetryRecord::maxLen < 192, "ban ghi telemetry qua lon cho stack");
+
 static bool writeStatus(const String &nodeId, float t, float h, float s, float l, uint64_t ts,
                         int eco2, int tvoc, int aqi) {
-  JsonWriter w; object_t json, o1,o2,o3,o4,o5,o6,o7,o8;
-  w.create(o1, "t",  t);  w.create(o2, "h", h);
-  w.create(o3, "s",  s);  w.create(o4, "l", l);
-  w.create(o5, "ts", (double)ts);
-  w.create(o6, "ec", eco2); w.create(o7, "tv", tvoc); w.create(o8, "aq", aqi);
-  w.join(json, 8, o1,o2,o3,o4,o5,o6,o7,o8);
+  StatusRecord::Buffer buf;
+  StatusRecord::write(buf, t, h, s, l, ts, eco2, tvoc, aqi);
   String path = nodePathFromId(nodeId, "/status");
-  return Database.set<object_t>(aClient, path, json);
+  return Database.set<object_t>(aClient, path, object_t(String(buf)));
 }
 static bool pushTelemetryFromDoc(const String &nodeId,
                                  float t, float h, float s, float l, uint64_t ts, const String &nStr,
                                  int eco2, int tvoc, int aqi) {
-  JsonWriter w; object_t json, o1,o2,o3,o4,o5,o6,o7,o8,o9;
-  int nInt = nStr.toInt();
-  w.create(o1, "n",  nInt);  w.create(o2, "t",  t);  w.create(o3, "h",  h);
-  w.create(o4, "s",  s);     w.create(o5, "l",  l);  w.create(o6, "ts", (double)ts);
-  w.create(o7, "ec", eco2);  w.create(o8, "tv", tvoc); w.create(o9, "aq", aqi);
-  w.join(json, 9, o1,o2,o3,o4,o5,o6,o7,o8,o9);
+  TelemetryRecord::Buffer buf;
+  TelemetryRecord::write(buf, nStr.toInt(), t, h, s, l, ts, eco2, tvoc, aqi);
   String path = nodePathFromId(nStr, "/telemetry");
-  return Database.push<object_t>(aClient, path, json);
+  return Database.push<object_t>(aClient, path, object_t(String(buf)));
 }
 
 // ================== UPLINK (LoRa -> Firebase) ==================
@@ -319,6 +451,83 @@ static inline void printSensorLine(const String& nid, float t, float h, float s,
                 nid.c_str(), t, h, s, l, eco2, tvoc, aqi, (unsigned long long)ts);
 #endif
 }
+// Chuyển số đo của node cảm biến sensorNode sang các node điều khiển gắn với nó
+// (NODES[].sensorNode) khi node đó có luật ngưỡng
+static void forwardSensorToControl(int sensorNode, JsonArray a) {
+  if (sensorNode <= 0) return;
+  int16_t vals[SENSOR_COUNT];
+  for (uint8_t k = 0; k < SENSOR_COUNT; ++k) {
+    long v = a[k + 1] | 0L;
+    vals[k] = (int16_t)constrain(v, -32768L, 32767L);
+  }
+
+  for (size_t idx = 0; idx < NODES_N; ++idx) {
+    if (NODES[idx].sensorNode != sensorNode || !g_schedLoaded[idx]) continue;
+    bool need = false;
+    for (int d = 0; d < DEV_COUNT; ++d) need |= (g_schedules[idx][d].thrSensor >= 0);
+    if (!need) continue;
+
+    // Gói uplink vừa tới -> đang trong khe node cảm biến, để syncNodeRules phát sau
+    uint8_t *frame = g_sensorFwd[idx];
+    frame[0] = CMD_BIN_MAGIC;
+    frame[1] = CMD_OP_SENSOR;
+    memcpy(frame + 2, vals, sizeof(vals));
+    g_sensorFwdPending[idx] = true;
+  }
+}
+
+static bool hasPendingCmd(const String &nodeId, const char *device) {
+  for (uint8_t i = 0; i < MAX_PENDING_CMDS; ++i) {
+    const PendingCmd &c = g_cmdQueue[i];
+    if (c.used && !c.done && c.nodeId.equalsIgnoreCase(nodeId) && c.device.equalsIgnoreCase(device)) return true;
+  }
+  return false;
+}
+
+static bool refreshControlsCache(size_t idx);
+
+// Đối chiếu trạng thái relay thực tế với /controls, chỉ ghi RTDB khi khác
+static void handleStateBeacon(const String &nodeId, uint8_t mask, uint32_t up, const char *lastCmd) {
+  int idx = nodeIndexById(nodeId);
+  if (idx < 0) return;
+  const String nid = String(NODES[idx].nodeId);
+
+#if DEBUG
+  Serial.printf("[BEACON][%s] mask=0x%02x up=%lus last=%s\n",
+                nid.c_str(), mask, (unsigned long)up, lastCmd);
+#endif
+
+  // uptime lùi -> node vừa reset/brown-out: gửi lại giờ + luật ngay
+  if (up < g_beaconUptime[idx]) {
+#if DEBUG
+    Serial.printf("[BEACON][%s] node restarted\n", nid.c_str());
+#endif
+    g_rulesSentOk[idx] = false;
+    g_timeSentMs[idx]  = 0;
+  }
+  g_beaconUptime[idx] = up;
+
+  bool known = true;
+  for (int d = 0; d < DEV_COUNT; ++d) known &= (g_ctrlState[idx][d] >= 0);
+  if (!known && !refreshControlsCache(idx)) return;
+
+  for (int d = 0; d < DEV_COUNT; ++d) {
+    int actual = (mask >> d) & 1;
+    if (g_ctrlState[idx][d] == actual) continue;
+    if (hasPendingCmd(nid, DEVICE_KEYS[d])) continue;   // lệnh đang bay -> chưa đối chiếu
+
+#if DEBUG
+    Serial.printf("[BEACON][%s] %s cloud=%d actual=%d -> sync\n",
+                  nid.c_str(), DEVICE_KEYS[d], g_ctrlState[idx][d], actual);
+#endif
+    String ctrlPath = nodePathFromId(nid, "/controls");
+    JsonWriter w; object_t root, f1;
+    w.create(f1, DEVICE_KEYS[d], actual != 0);
+    w.join(root, 1, f1);
+    if (Database.update<object_t>(aClient, ctrlPath, root)) g_ctrlState[idx][d] = actual;
+  }
+}
+
 static void handleUplinkPacket(const String &pkt) {
   String s = pkt; s.trim();
   if (s.length() == 0) return;
@@ -336,6 +545,8 @@ static void handleUplinkPacket(const String &pkt) {
     int   aqi  = a[7] | 0;
     uint64_t ts= a[8] | 0;
     String nodeId = String(n);
+    noteSensorSlot(n);
+    forwardSensorToControl(n, a);
     printSensorLine(nodeId, t, h, so, l, eco2, tvoc, aqi, ts);
     printRtcTimeLine();
     bool ok1 = writeStatus(nodeId, t, h, so, l, ts, eco2, tvoc, aqi);
@@ -372,6 +583,13 @@ static void handleUplinkPacket(const String &pkt) {
       return; // không xử lý như gói cảm biến
     }
 
+    // ===== Beacon trạng thái relay từ node điều khiển =====
+    // Dạng: {"n":"N01","b":5,"up":1234,"lc":"N01-1a2b"}
+    if (doc.containsKey("b") && doc.containsKey("n")) {
+      handleStateBeacon(doc["n"].as<String>(), doc["b"] | 0, doc["up"] | 0UL, doc["lc"] | "");
+      return;
+    }
+
     if (!doc.containsKey("n") || !doc.containsKey("t") || !doc.containsKey("h") ||
         !doc.containsKey("s") || !doc.containsKey("l")) return;
 
@@ -409,7 +627,7 @@ static void markDownlink(const String& nodeId, const String& cmdId,
 }
 
 
-bool sendDeviceCmd_LoRa(const String& nodeId, const String& device, int value) {
+bool sendDeviceCmd_LoRa(const String& nodeId, const String& device, int value, bool sched) {
   int idx = findFreeCmdSlot();
   if (idx < 0) {
 #if DEBUG
@@ -423,12 +641,13 @@ bool sendDeviceCmd_LoRa(const String& nodeId, const String& device, int value) {
   c.nodeId     = nodeId;
   c.device     = device;
   c.value      = value ? 1 : 0;
+  c.sched      = sched;
   c.retryCount = 0;
   c.lastSentMs = 0;
   c.done       = false;
 
   g_cmdCounter++;
-  // cmdId dạng: N01-1a2b (ngắn, dễ debug, vẫn < 58 byte khi serialize)
+  // cmdId dạng: N01-1a2b (ngắn, dễ debug, <= CMD_ID_MAX byte trong khung SET)
   c.cmdId = nodeId + "-" + String((uint16_t)(g_cmdCounter & 0xFFFF), HEX);
 
 #if DEBUG
@@ -519,8 +738,8 @@ static void handleDownlinkPayload(const String& nodeId,
     Serial.printf("[DL][%s] -> LoRa: device=%s, value=%d\n",
                   nodeId.c_str(), dev, on);
 
-    // GỬI LỆNH ĐƠN DẠNG {"cmd":"set","device":"pump","value":1}
-    // Hàm này bên dưới đã build JSON nhỏ (<58 byte) và gửi qua LoRa E32
+    // GỬI LỆNH ĐƠN "set" (device + value)
+    // Hàng đợi lệnh gửi qua LoRa E32 dạng khung nhị phân CMD_OP_SET
     bool ok = sendDeviceCmd_LoRa(nodeId, String(dev), on);
     if (ok) {
       okCnt++;
@@ -553,6 +772,7 @@ static void processCommandQueue() {
   const uint32_t RETRY_INTERVAL_MS  = 2000;
 
   uint32_t now = millis();
+  const bool txOk = loraTxGate();   // kênh bận -> giữ lệnh, không tính lượt retry
 
   for (uint8_t i = 0; i < MAX_PENDING_CMDS; ++i) {
     PendingCmd &c = g_cmdQueue[i];
@@ -582,6 +802,7 @@ static void processCommandQueue() {
     if (c.retryCount > 0 && (now - c.lastSentMs) < RETRY_INTERVAL_MS) {
       continue;
     }
+    if (!txOk) break;
 
     uint8_t addh, addl, ch;
     if (!getLoraAddr(c.nodeId, addh, addl, ch)) {
@@ -592,25 +813,29 @@ static void processCommandQueue() {
       continue;
     }
 
-    StaticJsonDocument<96> d;
-    d["cmd"]    = "set";
-    d["device"] = c.device;
-    d["value"]  = c.value ? 1 : 0;
-    d["id"]     = c.cmdId; // để node ACK lại đúng lệnh
-    String payload;
-    serializeJson(d, payload);
-
-    // Giới hạn E32: 58 byte
-    if (payload.length() > 58) {
+    // Khung nhị phân CMD_OP_SET: [magic][op][devId][value][idLen][cmdId], khớp parseBinaryCmd của node
+    int dev = -1;
+    for (int d = 0; d < DEV_COUNT; ++d) {
+      if (c.device.equalsIgnoreCase(DEVICE_KEYS[d])) { dev = d; break; }
+    }
+    size_t idLen = c.cmdId.length();
+    if (dev < 0 || idLen > CMD_ID_MAX) {
 #if DEBUG
-      Serial.printf("[CMDQ] payload too long (%d), drop\n",
-                    payload.length());
+      Serial.printf("[CMDQ] bad cmd %s dev=%s, drop\n",
+                    c.cmdId.c_str(), c.device.c_str());
 #endif
       c.used = false;
       continue;
     }
-
-    ResponseStatus rs = lora.sendFixedMessage(addh, addl, ch, payload);
+    uint8_t frame[5 + CMD_ID_MAX];
+    frame[0] = CMD_BIN_MAGIC;
+    frame[1] = CMD_OP_SET;
+    frame[2] = (uint8_t)dev;
+    frame[3] = (c.value ? 1 : 0) | (c.sched ? CMD_SET_F_SCHED : 0);
+    frame[4] = (uint8_t)idLen;
+    memcpy(frame + 5, c.cmdId.c_str(), idLen);   // để node ACK lại đúng lệnh
+
+    ResponseStatus rs = lora.sendFixedMessage(addh, addl, ch, frame, 5 + idLen);
 #if DEBUG
     Serial.printf("[CMDQ] send cmd %s to %s dev=%s val=%d rs=%d\n",
                   c.cmdId.c_str(),
@@ -705,8 +930,13 @@ static void initSchedules() {
       g_schedules[i][d].onMinutes   = -1;
       g_schedules[i][d].offMinutes  = -1;
       g_schedules[i][d].lastApplied = -1;
+      g_schedules[i][d].thrSensor   = -1;
     }
     g_schedLoaded[i] = false;
+    g_rulesSentOk[i] = false;
+    g_timeSentMs[i]  = 0;
+    g_beaconUptime[i] = 0;
+    for (int d = 0; d < DEV_COUNT; ++d) g_ctrlState[i][d] = -1;
   }
 }
 
@@ -751,7 +981,7 @@ static bool loadSchedulesForNodeIndex(size_t idx) {
     return false;
   }
 
-  StaticJsonDocument<512> doc;
+  StaticJsonDocument<768> doc;
   DeserializationError err = deserializeJson(doc, json);
   if (err) {
 #if DEBUG
@@ -769,6 +999,7 @@ static bool loadSchedulesForNodeIndex(size_t idx) {
     cfg.onMinutes   = -1;
     cfg.offMinutes  = -1;
     cfg.lastApplied = -1;
+    cfg.thrSensor   = -1;
 
     if (!doc.containsKey(key)) continue;
     JsonVariant v = doc[key];
@@ -788,6 +1019,17 @@ static bool loadSchedulesForNodeIndex(size_t idx) {
       if (parseHHmmToMinutes(String(offStr), mins)) cfg.offMinutes = mins;
     }
 
+    // Ngưỡng cảm biến (tuỳ chọn): "rule": {"sensor":"s","on":30,"off":45}
+    JsonObject r = o["rule"].as<JsonObject>();
+    if (!r.isNull() && r.containsKey("on") && r.containsKey("off")) {
+      const char *sk = r["sensor"] | "";
+      for (uint8_t k = 0; k < SENSOR_COUNT; ++k) {
+        if (strcmp(sk, SENSOR_KEYS[k]) == 0) { cfg.thrSensor = k; break; }
+      }
+      cfg.thrOn  = r["on"]  | 0.0f;
+      cfg.thrOff = r["off"] | 0.0f;
+    }
+
 #if DEBUG
     if (cfg.enabled && cfg.onMinutes >= 0 && cfg.offMinutes >= 0) {
       Serial.printf("[SCH][%s] %s enabled: on=%d, off=%d (min)\n",
@@ -816,6 +1058,31 @@ static void pollSchedulesFromFirebase() {
   }
 }
 
+// Đọc /nodes/{id}/controls -> cache mode + trạng thái từng thiết bị
+static bool refreshControlsCache(size_t idx) {
+  const String nodeId = String(NODES[idx].nodeId);
+  String ctrlPath = nodePathFromId(nodeId, "/controls");
+#if DEBUG
+  Serial.printf("[SCH][%s] get controls (for mode): %s\n",
+                nodeId.c_str(), ctrlPath.c_str());
+#endif
+  String ctrlJson = Database.get<String>(aClient, ctrlPath);
+  if (aClient.lastError().code() != 0) return false;
+
+  StaticJsonDocument<256> cdoc;
+  if (ctrlJson.length() > 0 && ctrlJson != "null" && deserializeJson(cdoc, ctrlJson)) return false;
+
+  for (int d = 0; d < DEV_COUNT; ++d) {
+    String modeKey = String(DEVICE_KEYS[d]) + "Mode";
+    const char* mm = cdoc[modeKey.c_str()] | "";
+    g_devModes[idx][d] = (mm && mm[0]) ? String(mm) : String();
+
+    JsonVariant v = cdoc[DEVICE_KEYS[d]];
+    g_ctrlState[idx][d] = v.isNull() ? 0 : (v.as<bool>() ? 1 : 0);
+  }
+  return true;
+}
+
 // Thực thi lịch: quyết định ON/OFF và gửi lệnh xuống node
 static void evaluateSchedules() {
   if (!gatewayReady()) return;
@@ -838,35 +1105,13 @@ static void evaluateSchedules() {
     const String nodeId = String(NODES[i].nodeId);
 
     // Đọc mode hiện tại của từng thiết bị từ /controls
-    String devModes[DEV_COUNT];
-    {
-      String ctrlPath = nodePathFromId(nodeId, "/controls");
-#if DEBUG
-      Serial.printf("[SCH][%s] get controls (for mode): %s\n",
-                    nodeId.c_str(), ctrlPath.c_str());
-#endif
-      String ctrlJson = Database.get<String>(aClient, ctrlPath);
-      if (aClient.lastError().code() == 0 &&
-          ctrlJson.length() > 0 && ctrlJson != "null") {
-        StaticJsonDocument<256> cdoc;
-        DeserializationError cerr = deserializeJson(cdoc, ctrlJson);
-        if (!cerr) {
-          for (int d = 0; d < DEV_COUNT; ++d) {
-            String modeKey = String(DEVICE_KEYS[d]) + "Mode";
-            const char* mm = cdoc[modeKey.c_str()] | "";
-            if (mm && mm[0]) {
-              devModes[d] = String(mm);
-            }
-          }
-        }
-      }
-    }
+    refreshControlsCache(i);
 
     for (int d = 0; d < DEV_COUNT; ++d) {
       DeviceScheduleCfg &cfg = g_schedules[i][d];
 
       // Kiểm tra mode: chỉ chạy lịch khi mode == "schedule" (hoặc chưa set)
-      String mode = devModes[d];
+      const String &mode = g_devModes[i][d];
       if (mode.length() > 0 && mode != "schedule") {
 #if DEBUG
         Serial.printf("[SCH][%s] skip %s by mode=%s\n",
@@ -912,7 +1157,7 @@ static void evaluateSchedules() {
         JsonWriter w; object_t root, f1;
         w.create(f1, devKey, newState != 0);
         w.join(root, 1, f1);
-        Database.update<object_t>(aClient, ctrlPath, root);
+        if (Database.update<object_t>(aClient, ctrlPath, root)) g_ctrlState[i][d] = newState;
       }
 
       // 2) Cập nhật /nodes/{id}/meta (updatedBy = schedule)
@@ -926,8 +1171,9 @@ static void evaluateSchedules() {
         Database.update<object_t>(aClient, metaPath, root);
       }
 
-      // 3) Gửi lệnh LoRa (thực tế là enqueue vào hàng đợi)
-      bool ok = sendDeviceCmd_LoRa(nodeId, devKey, newState);
+      // 3) Gửi lệnh LoRa (thực tế là enqueue vào hàng đợi), đánh dấu lệnh lịch
+      //    để node không tắt luật ngưỡng cục bộ tới hết khung giờ
+      bool ok = sendDeviceCmd_LoRa(nodeId, devKey, newState, true);
 #if DEBUG
       if (!ok) {
         Serial.printf("[SCH][%s] sendDeviceCmd_LoRa FAIL for %s\n",
@@ -938,6 +1184,90 @@ static void evaluateSchedules() {
   }
 }
 
+// Bảng luật gọn cho node điều khiển: lịch + ngưỡng, chỉ bật khi mode cho phép
+static void buildLocalRules(size_t idx, LocalRuleWire out[DEV_COUNT]) {
+  memset(out, 0, sizeof(LocalRuleWire) * DEV_COUNT);
+  for (int d = 0; d < DEV_COUNT; ++d) {
+    const DeviceScheduleCfg &cfg = g_schedules[idx][d];
+    const String &mode = g_devModes[idx][d];
+    LocalRuleWire &r = out[d];
+
+    if (cfg.onMinutes >= 0 && cfg.offMinutes >= 0 && cfg.onMinutes != cfg.offMinutes) {
+      r.flags |= RULE_F_SCHED;
+      r.onMin  = cfg.onMinutes;
+      r.offMin = cfg.offMinutes;
+    }
+    if (cfg.thrSensor >= 0) {
+      r.flags |= RULE_F_THRESH;
+      r.sensor = cfg.thrSensor;
+      r.thrOn  = (int16_t)lroundf(cfg.thrOn  * SENSOR_SCALE[cfg.thrSensor]);
+      r.thrOff = (int16_t)lroundf(cfg.thrOff * SENSOR_SCALE[cfg.thrSensor]);
+    }
+    if (cfg.enabled && r.flags && (mode.length() == 0 || mode == "schedule")) {
+      r.flags |= RULE_F_ENABLED;
+    }
+  }
+}
+
+// Đẩy số đo chờ chuyển, luật (khi đổi), giờ địa phương và beacon khe (định kỳ)
+// xuống các node. Không cần cloud: luật đã cache trong RAM, giờ lấy từ RTC.
+static void syncNodeRules() {
+  static uint32_t lastSync = 0;
+  const uint32_t SYNC_GAP_MS = 2000;   // mỗi lần tối đa 1 khung để E32 kịp xả
+  uint32_t nowMs = millis();
+  if (nowMs - lastSync < SYNC_GAP_MS) return;
+  if (!loraTxGate()) return;
+  lastSync = nowMs;
+
+  if (g_slotBeaconMs == 0 || nowMs - g_slotBeaconMs >= SLOT_BEACON_MS) {
+    sendSlotBeacon();
+    return;
+  }
+
+  for (size_t i = 0; i < NODES_N; ++i) {
+    if (g_sensorFwdPending[i]) {
+      lora.sendFixedMessage(NODES[i].addh, NODES[i].addl, NODES[i].ch,
+                            g_sensorFwd[i], sizeof(g_sensorFwd[i]));
+      g_sensorFwdPending[i] = false;
+      return;
+    }
+  }
+
+  for (size_t i = 0; i < NODES_N; ++i) {
+    if (g_schedLoaded[i]) {
+      LocalRuleWire rules[DEV_COUNT];
+      buildLocalRules(i, rules);
+      if (!g_rulesSentOk[i] || memcmp(rules, g_rulesSent[i], sizeof(rules)) != 0) {
+        uint8_t frame[3 + sizeof(rules)];
+        frame[0] = CMD_BIN_MAGIC;
+        frame[1] = CMD_OP_RULES;
+        frame[2] = DEV_COUNT;
+        memcpy(frame + 3, rules, sizeof(rules));
+        ResponseStatus rs = lora.sendFixedMessage(NODES[i].addh, NODES[i].addl, NODES[i].ch,
+                                                  frame, sizeof(frame));
+        memcpy(g_rulesSent[i], rules, sizeof(rules));
+        g_rulesSentOk[i] = (rs.code == 1);
+#if DEBUG
+        Serial.printf("[RULE][%s] push rules rs=%d\n", NODES[i].nodeId, rs.code);
+#endif
+        return;
+      }
+    }
+
+    if (g_rtc_present && g_rtc_has_time &&
+        (g_timeSentMs[i] == 0 || nowMs - g_timeSentMs[i] >= NODE_TIME_SYNC_MS)) {
+      uint32_t localSec = (uint32_t)(nowUnix() + TZ_OFFSET_SECONDS);
+      uint8_t frame[6];
+      frame[0] = CMD_BIN_MAGIC;
+      frame[1] = CMD_OP_TIME;
+      memcpy(frame + 2, &localSec, sizeof(localSec));
+      lora.sendFixedMessage(NODES[i].addh, NODES[i].addl, NODES[i].ch, frame, sizeof(frame));
+      g_timeSentMs[i]  = nowMs ? nowMs : 1;
+      g_rulesSentOk[i] = false;   // lần sau gửi lại luật, phòng khi khung trước bị mất
+      return;
+    }
+  }
+}
 
 // ================== SETUP / LOOP ==================
 void setup() {
@@ -952,6 +1282,7 @@ void setup() {
   // LoRa
   Serial2.begin(9600, SERIAL_8N1, 16, 17);
   Serial2.setTimeout(50);
+  pinMode(LORA_AUX_PIN, INPUT_PULLUP);
   delay(200);
   lora.begin();
 
@@ -965,6 +1296,7 @@ void setup() {
       g_rtc_has_time = true;
     }
   }
+  slotClockSync();
 
   // Ethernet
   (void)startEthernet();
@@ -1046,10 +1378,24 @@ if (app.ready()) {
   // Uplink: Nhận từ LoRa -> parse -> đẩy Firebase
    // Uplink: Nhận từ LoRa -> parse -> đẩy Firebase
   if (!gatewayReady()) {
-    while (lora.available() > 0) { (void)lora.receiveMessage(); }
+    // Mất cloud: bỏ gói, nhưng vẫn chuyển số đo cho luật ngưỡng trên node điều khiển
+    while (lora.available() > 0) {
+      ResponseContainer rc = lora.receiveMessage();
+      loraNoteRx();
+      if (rc.status.code != 1) continue;
+      rc.data.trim();
+      if (!rc.data.startsWith("[")) continue;
+      StaticJsonDocument<192> doc;
+      if (deserializeJson(doc, rc.data)) continue;
+      JsonArray a = doc.as<JsonArray>();
+      if (a.size() < 9) continue;
+      noteSensorSlot(a[0] | 0);
+      forwardSensorToControl(a[0] | 0, a);
+    }
   } else {
     if (lora.available() > 0) {
       ResponseContainer rc = lora.receiveMessage();
+      loraNoteRx();
       if (rc.status.code == 1) {
         String data = rc.data; data.trim();
         if (data.length() > 4096) data = data.substring(0, 4096);
@@ -1060,6 +1406,7 @@ if (app.ready()) {
   processCommandQueue();
   pollSchedulesFromFirebase();
   evaluateSchedules();
+  syncNodeRules();
   // Re-init Ethernet nếu link down
   static uint32_t lastEthCheck = 0;
   if (millis() - lastEthCheck > 8000) {
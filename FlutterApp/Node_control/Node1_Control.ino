@@ -1,6 +1,8 @@
 #include <Arduino.h>
 #include <LoRa_E32.h>
-#include <ArduinoJson.h>
+#include <Preferences.h>
+
+#define NODE_ID        "N01"     // khớp /nodes/<id> và bảng NODES của gateway
 
 // ----------- cấu hình UART LoRa E32 ----------
 #define LORA_BAUD      9600
@@ -9,6 +11,16 @@
 #define LORA_AUX_PIN    4
 LoRa_E32 lora(&Serial2, LORA_BAUD);
 
+// ----------- nhận khung theo sự kiện (AUX / UART) ----------
+#define LORA_RX_FRAME_MAX   128   // > 58B gói E32, dư chỗ khi 2 gói dính nhau
+#define LORA_RX_GAP_MS      3     // UART im lặng bấy nhiêu ms sau AUX lên -> hết khung
+#define LORA_RX_SAFETY_MS   1000  // đánh thức dự phòng nếu mất sự kiện (kiêm nhịp chạy luật)
+#define LORA_RX_TASK_STACK  4096
+#define LORA_RX_TASK_PRIO   5
+
+static TaskHandle_t      g_rxTask   = nullptr;
+static SemaphoreHandle_t g_loraLock = nullptr;   // sendMessage từ task RX và loop()
+
 // ----------- map relay ----------
 #define PIN_RELAY_PUMP    25
 #define PIN_RELAY_LIGHT   26
@@ -17,10 +29,66 @@ LoRa_E32 lora(&Serial2, LORA_BAUD);
 // Relay module thường ACTIVE LOW (IN=0 -> ON, IN=1 -> OFF)
 #define ACTIVE_LOW        false
 
+// ----------- bảng thiết bị ----------
+// id nhỏ dùng chung với gateway (DeviceIndex: pump=0, light=1, fan=2)
+enum DeviceId : uint8_t { DEV_PUMP = 0, DEV_LIGHT = 1, DEV_FAN = 2, DEV_COUNT = 3 };
+
+struct DeviceDef { const char* name; uint8_t len; uint8_t pin; };
+constexpr DeviceDef DEVICES[DEV_COUNT] = {
+  {"pump",  4, PIN_RELAY_PUMP},
+  {"light", 5, PIN_RELAY_LIGHT},
+  {"fan",   3, PIN_RELAY_FAN},
+};
+
 // ----------- trạng thái thiết bị ----------
-int stPump  = 0;
-int stLight = 0;
-int stFan   = 0;
+uint8_t g_devState[DEV_COUNT] = {0, 0, 0};
+
+// ----------- luật tự động cục bộ ----------
+// Gateway đẩy bảng lịch + ngưỡng cảm biến xuống (lưu NVS), node tự chạy theo
+// đồng hồ của mình -> vẫn bật/tắt đúng giờ khi gateway/cloud mất kết nối.
+#define RULE_F_ENABLED    0x01
+#define RULE_F_SCHED      0x02    // có khung giờ onMin..offMin
+#define RULE_F_THRESH     0x04    // có ngưỡng cảm biến thrOn/thrOff
+#define SENSOR_COUNT      7       // t10,h10,s10,lux,eco2,tvoc,aqi (cùng thứ tự gói uplink)
+#define SENSOR_STALE_MS   (10UL * 60UL * 1000UL)
+#define RULE_EVAL_MS      1000
+
+// 10 byte/thiết bị, gửi nguyên dạng little-endian trong khung RULES
+struct __attribute__((packed)) LocalRule {
+  uint8_t  flags;
+  uint8_t  sensor;        // chỉ số trong g_sensor[]
+  uint16_t onMin;         // phút trong ngày 0..1439
+  uint16_t offMin;
+  int16_t  thrOn;         // thrOn < thrOff: bật khi <= thrOn (vd. độ ẩm đất)
+  int16_t  thrOff;        // thrOn > thrOff: bật khi >= thrOn (vd. nhiệt độ)
+};
+
+LocalRule g_rules[DEV_COUNT];
+Preferences g_prefs;
+
+int8_t   g_ruleLast[DEV_COUNT] = {-1, -1, -1};   // quyết định gần nhất của luật
+uint8_t  g_thrState[DEV_COUNT] = {0, 0, 0};      // trạng thái trễ của ngưỡng
+bool     g_override[DEV_COUNT] = {false, false, false}; // lệnh gateway đè tới lần chuyển kế
+
+int16_t  g_sensor[SENSOR_COUNT];
+uint32_t g_sensorMs    = 0;
+bool     g_sensorValid = false;
+
+// Đồng hồ cục bộ: giây địa phương gateway gửi + millis() trôi từ lúc nhận
+uint32_t g_clockBaseSec = 0;
+uint32_t g_clockBaseMs  = 0;
+bool     g_clockValid   = false;
+
+// ----------- beacon trạng thái relay ----------
+// {"n":"N01","b":<bitmask>,"up":<giây>,"lc":"<cmdId cuối>"} gửi khi đổi
+// trạng thái (gom các thay đổi sát nhau) và theo nhịp heartbeat dài.
+#define BEACON_SETTLE_MS     500
+#define BEACON_HEARTBEAT_MS  (5UL * 60UL * 1000UL)
+
+char     g_lastCmdId[17]   = "";   // CMD_ID_MAX + 1
+uint32_t g_beaconDirtyMs   = 0;    // 0 = không có thay đổi chờ gửi
+uint32_t g_beaconSentMs    = 0;
+uint32_t g_beaconGapMs     = BEACON_HEARTBEAT_MS;   // heartbeat + jitter, đổi mỗi lần gửi
 
 // Chuyển ON/OFF sang mức chân phù hợp ACTIVE_LOW
 inline int toLevel(int on) {
@@ -28,103 +96,398 @@ inline int toLevel(int on) {
   return on ? HIGH : LOW;
 }
 
-// Đổi tên thiết bị -> con trỏ biến trạng thái
-int* stateRefByName(const String& devName) {
-  if (devName.equalsIgnoreCase("pump"))  return &stPump;
-  if (devName.equalsIgnoreCase("light")) return &stLight;
-  if (devName.equalsIgnoreCase("fan"))   return &stFan;
-  return nullptr;
-}
-
-// Đổi tên thiết bị -> chân GPIO
-int pinByName(const String& devName) {
-  if (devName.equalsIgnoreCase("pump"))  return PIN_RELAY_PUMP;
-  if (devName.equalsIgnoreCase("light")) return PIN_RELAY_LIGHT;
-  if (devName.equalsIgnoreCase("fan"))   return PIN_RELAY_FAN;
+// Tên thiết bị (không cần kết thúc '\0') -> id, -1 nếu không có
+int deviceIdByName(const char* name, size_t len) {
+  for (uint8_t d = 0; d < DEV_COUNT; ++d) {
+    if (len == DEVICES[d].len && strncasecmp(name, DEVICES[d].name, len) == 0) return d;
+  }
   return -1;
 }
 
 // Áp lệnh cho 1 thiết bị
-bool applyDevice(const String& devName, int value) {
-  int* pState = stateRefByName(devName);
-  int pin     = pinByName(devName);
-  if (!pState || pin < 0) return false;
+bool applyDevice(int dev, int value) {
+  if (dev < 0 || dev >= DEV_COUNT) return false;
   value = (value != 0) ? 1 : 0;
 
-  *pState = value;
-  digitalWrite(pin, toLevel(value));
+  if (g_devState[dev] != value && !g_beaconDirtyMs) g_beaconDirtyMs = millis() | 1;
+  g_devState[dev] = value;
+  digitalWrite(DEVICES[dev].pin, toLevel(value));
   return true;
 }
 
-// Gửi ACK về Gateway, kèm theo cmdId + device + value
-void sendAck(const char* cmdId, const char* dev, int value) {
-  StaticJsonDocument<96> doc;
-  doc["ok"] = true;
-  if (cmdId && cmdId[0]) doc["id"] = cmdId;
-  if (dev   && dev[0])   doc["device"] = dev;
-  doc["value"] = value ? 1 : 0;
+// Nghe trước khi phát: AUX HIGH + UART không có byte tới, giữ rảnh thêm 1
+// khoảng ngẫu nhiên; bận thì lùi theo cấp số. Hết giờ vẫn phát (ACK trễ còn hơn mất).
+#define LBT_SENSE_MIN_MS   5
+#define LBT_SENSE_MAX_MS   40
+#define LBT_BACKOFF_MS     30
+#define LBT_MAX_WAIT_MS    800
+
+inline bool loraChannelClear() {
+  return digitalRead(LORA_AUX_PIN) == HIGH && Serial2.available() <= 0;
+}
+
+void loraWaitClear() {
+  uint32_t t0 = millis();
+  uint8_t busy = 0;
+  while (millis() - t0 < LBT_MAX_WAIT_MS) {
+    if (loraChannelClear()) {
+      vTaskDelay(pdMS_TO_TICKS(random(LBT_SENSE_MIN_MS, LBT_SENSE_MAX_MS)));
+      if (loraChannelClear()) return;
+    }
+    if (busy < 3) busy++;
+    vTaskDelay(pdMS_TO_TICKS(random(LBT_BACKOFF_MS, LBT_BACKOFF_MS << busy)));
+  }
+}
+
+// Gửi qua E32, khoá để task RX (ACK) và loop() (Serial test) không chen nhau
+void loraSend(const void* data, size_t len) {
+  if (g_loraLock) xSemaphoreTake(g_loraLock, portMAX_DELAY);
+  loraWaitClear();
+  lora.sendMessage(data, (uint8_t)len);
+  if (g_loraLock) xSemaphoreGive(g_loraLock);
+}
 
-  String payload;
-  serializeJson(doc, payload);
-  lora.sendMessage(payload);   // Transparent mode: gateway bắt ACK
+// Gửi ACK về Gateway, kèm theo cmdId (bỏ khoá khi lệnh không có id) + device + value
+void sendAck(const char* cmdId, int dev, int value) {
+  char payload[72];
+  int n = (cmdId && cmdId[0])
+        ? snprintf(payload, sizeof(payload), "{\"ok\":true,\"id\":\"%s\",\"device\":\"%s\",\"value\":%d}",
+                   cmdId, DEVICES[dev].name, value ? 1 : 0)
+        : snprintf(payload, sizeof(payload), "{\"ok\":true,\"device\":\"%s\",\"value\":%d}",
+                   DEVICES[dev].name, value ? 1 : 0);
+  if (n <= 0 || n >= (int)sizeof(payload)) return;
+  loraSend(payload, n);        // Transparent mode: gateway bắt ACK
 }
 
 
 
-// (Tuỳ chọn) Gửi log trạng thái hiện tại
-void sendStatusLog(const char* note = nullptr) {
-  StaticJsonDocument<160> d;
-  d["pump"]  = stPump;
-  d["light"] = stLight;
-  d["fan"]   = stFan;
-  if (note) d["note"] = note;
-  String s; serializeJson(d, s);
-  lora.sendMessage(s);
+// Beacon trạng thái relay hiện tại (bitmask bit d = DEVICES[d])
+void sendStateBeacon() {
+  uint8_t mask = 0;
+  for (uint8_t d = 0; d < DEV_COUNT; ++d) if (g_devState[d]) mask |= (1u << d);
+
+  char s[64];
+  int n = snprintf(s, sizeof(s), "{\"n\":\"%s\",\"b\":%u,\"up\":%lu,\"lc\":\"%s\"}",
+                   NODE_ID, mask, (unsigned long)(millis() / 1000UL), g_lastCmdId);
+  if (n <= 0 || n >= (int)sizeof(s)) return;
+  loraSend(s, n);
+  g_beaconSentMs  = millis();
+  g_beaconDirtyMs = 0;
+  g_beaconGapMs   = BEACON_HEARTBEAT_MS + random(0, 30000);   // các node không trùng nhịp
+}
+
+// Gọi từ loraRxTask: gửi khi có thay đổi đã ổn định hoặc tới nhịp heartbeat
+void pollStateBeacon() {
+  uint32_t now = millis();
+  if (g_beaconDirtyMs && now - g_beaconDirtyMs >= BEACON_SETTLE_MS) {
+    sendStateBeacon();
+  } else if (g_beaconSentMs == 0 || now - g_beaconSentMs >= g_beaconGapMs) {
+    sendStateBeacon();   // lần đầu sau boot -> gateway phát hiện reset/brown-out
+  }
 }
 
 // Xử lý 1 lệnh set đơn lẻ
-bool handleSetOne(const char* dev, int value) {
-  if (!dev || value < 0) return false;
-  String devName = String(dev);
-  bool ok = applyDevice(devName, value);
+bool handleSetOne(int dev, int value) {
+  if (value < 0) return false;
+  bool ok = applyDevice(dev, value);
   if (ok) {
-    Serial.printf("[NODE][APPLY] %s = %s\n", devName.c_str(), value ? "ON" : "OFF");
+    Serial.printf("[NODE][APPLY] %s = %s\n", DEVICES[dev].name, value ? "ON" : "OFF");
   } else {
-    Serial.printf("[NODE][ERROR] Unknown device: %s\n", devName.c_str());
+    Serial.printf("[NODE][ERROR] Unknown device id: %d\n", dev);
   }
   return ok;
 }
 
+// ===================== PARSER KHUNG LỆNH =====================
+// Làm việc trực tiếp trên buffer nhận, không cấp phát heap. Chuỗi trả về
+// trỏ vào buffer (được kết thúc '\0' tại chỗ).
+//
+// Khung nhị phân (gọn hơn JSON, vừa 1 gói E32):
+//   [0] CMD_BIN_MAGIC  [1] op  [2] devId  [3] value  [4] idLen  [5..] cmdId
+//       value: bit0 = trạng thái, CMD_SET_F_SCHED = lệnh từ lịch của gateway
+//   [0] CMD_BIN_MAGIC  [1] CMD_OP_TIME    [2..5] giây địa phương (u32 LE)
+//   [0] CMD_BIN_MAGIC  [1] CMD_OP_RULES   [2] n  [3..] n x LocalRule
+//   [0] CMD_BIN_MAGIC  [1] CMD_OP_SENSOR  [2..] SENSOR_COUNT x int16 LE
+#define CMD_BIN_MAGIC   0xC1
+#define CMD_OP_SET      0x01
+#define CMD_OP_TIME     0x02
+#define CMD_OP_RULES    0x03
+#define CMD_OP_SENSOR   0x04
+#define CMD_OP_SLOT     0x06    // broadcast khe thời gian, chỉ node cảm biến dùng
+#define CMD_ID_MAX      16
+#define CMD_SET_F_SCHED 0x80    // lệnh lịch: áp dụng nhưng không đè luật cục bộ
+
+struct CmdFrame {
+  uint8_t     op;       // CMD_OP_*, 0 = không hợp lệ
+  int         dev;      // DeviceId, -1 = không rõ
+  int         value;    // 0/1, -1 = thiếu
+  bool        sched;    // lệnh từ lịch, không bật g_override
+  const char* id;       // cmdId để ACK, "" nếu không có
+};
+
+bool parseBinaryCmd(char* buf, size_t len, CmdFrame& out) {
+  if (len < 5 || (uint8_t)buf[0] != CMD_BIN_MAGIC) return false;
+  uint8_t idLen = (uint8_t)buf[4];
+  if (idLen > CMD_ID_MAX || len < 5u + idLen) return false;
+
+  out.op    = (uint8_t)buf[1];
+  out.dev   = (uint8_t)buf[2] < DEV_COUNT ? (uint8_t)buf[2] : -1;
+  out.value = (uint8_t)buf[3] & 0x01;
+  out.sched = ((uint8_t)buf[3] & CMD_SET_F_SCHED) != 0;
+  // dịch cmdId lùi 1 byte để có chỗ kết thúc '\0' ngay sau nó
+  memmove(buf + 4, buf + 5, idLen);
+  buf[4 + idLen] = 0;
+  out.id = buf + 4;
+  return true;
+}
 
-void handleIncoming(const String& raw) {
-  String s = raw; 
-  s.trim();
-  if (!s.length()) return;
+static inline const char* skipWs(const char* p, const char* end) {
+  while (p < end && isspace((unsigned char)*p)) p++;
+  return p;
+}
 
-  if (s[0] != '{') return;
+// Object JSON phẳng kiểu {"cmd":"set","device":"pump","value":1,"id":"N01-1a"}.
+// Không hỗ trợ object/array lồng hay escape trong chuỗi (gateway không gửi).
+bool parseJsonCmd(char* buf, size_t len, CmdFrame& out) {
+  const char* end = buf + len;
+  char* p = buf;
+  p = (char*)skipWs(p, end);
+  if (p >= end || *p != '{') return false;
+  p++;
+
+  const char* cmd = nullptr;
+  out.op = 0; out.dev = -1; out.value = -1; out.sched = false; out.id = "";
+
+  for (;;) {
+    p = (char*)skipWs(p, end);
+    if (p < end && *p == '}') break;
+    if (p >= end || *p != '"') return false;
+    const char* key = ++p;
+    while (p < end && *p != '"') p++;
+    if (p >= end) return false;
+    size_t keyLen = p - key;
+    p = (char*)skipWs(p + 1, end);
+    if (p >= end || *p != ':') return false;
+    p = (char*)skipWs(p + 1, end);
+    if (p >= end) return false;
+
+    if (*p == '"') {                       // giá trị chuỗi
+      char* v = ++p;
+      while (p < end && *p != '"') p++;
+      if (p >= end) return false;
+      size_t vLen = p - v;
+      *p++ = 0;
+      if (keyLen == 3 && !strncmp(key, "cmd", 3))         cmd = v;
+      else if (keyLen == 6 && !strncmp(key, "device", 6)) out.dev = deviceIdByName(v, vLen);
+      else if (keyLen == 2 && !strncmp(key, "id", 2))     out.id = vLen <= CMD_ID_MAX ? v : "";
+    } else {                               // số / true / false / null
+      const char* v = p;
+      while (p < end && *p != ',' && *p != '}' && !isspace((unsigned char)*p)) p++;
+      if (keyLen == 5 && !strncmp(key, "value", 5)) {
+        if (*v == 't')                         out.value = 1;
+        else if (*v == 'f')                    out.value = 0;
+        else if (*v == '-' || isdigit((unsigned char)*v)) out.value = atoi(v);
+      }
+    }
 
-  StaticJsonDocument<512> doc;
-  DeserializationError err = deserializeJson(doc, s);
-  if (err) return;
+    p = (char*)skipWs(p, end);
+    if (p < end && *p == ',') { p++; continue; }
+    if (p < end && *p == '}') break;
+    return false;
+  }
 
-  const char* cmd = doc["cmd"] | "";
-  if (!cmd || !*cmd) return;
+  if (!cmd) return false;
+  if (strcmp(cmd, "set") == 0) out.op = CMD_OP_SET;
+  else Serial.printf("[NODE] Unknown cmd: %s\n", cmd);
+  return true;
+}
 
-  // CHỈ XỬ LÝ LỆNH ĐƠN "set"
-  if (strcmp(cmd, "set") == 0) {
-    const char* dev   = doc["device"] | "";
-    int         value = doc["value"] | -1;
-    const char* cmdId = doc["id"]     | "";   // id lệnh để ACK cho gateway
+// ===================== LUẬT CỤC BỘ =====================
+void loadLocalRules() {
+  memset(g_rules, 0, sizeof(g_rules));
+  g_prefs.begin("rules", true);
+  if (g_prefs.getBytesLength("tbl") == sizeof(g_rules)) {
+    g_prefs.getBytes("tbl", g_rules, sizeof(g_rules));
+  }
+  g_prefs.end();
+}
+
+void handleRulesFrame(const uint8_t* buf, size_t len) {
+  if (len < 3 || buf[2] != DEV_COUNT || len < 3 + sizeof(g_rules)) return;
+  if (memcmp(g_rules, buf + 3, sizeof(g_rules)) == 0) return;   // không đổi -> khỏi ghi flash
 
-    if (handleSetOne(dev, value)) {
-      sendAck(cmdId, dev, value);   // ACK có thông tin để gateway đánh dấu done
+  memcpy(g_rules, buf + 3, sizeof(g_rules));
+  for (uint8_t d = 0; d < DEV_COUNT; ++d) g_ruleLast[d] = -1;
+  g_prefs.begin("rules", false);
+  g_prefs.putBytes("tbl", g_rules, sizeof(g_rules));
+  g_prefs.end();
+  Serial.println("[NODE][RULE] updated + saved");
+}
+
+void handleTimeFrame(const uint8_t* buf, size_t len) {
+  if (len < 6) return;
+  uint32_t sec;
+  memcpy(&sec, buf + 2, sizeof(sec));
+  g_clockBaseSec = sec;
+  g_clockBaseMs  = millis();
+  g_clockValid   = true;
+}
+
+void handleSensorFrame(const uint8_t* buf, size_t len) {
+  if (len < 2 + sizeof(g_sensor)) return;
+  memcpy(g_sensor, buf + 2, sizeof(g_sensor));
+  g_sensorMs    = millis();
+  g_sensorValid = true;
+}
+
+// -1 = luật không có ý kiến (chưa có giờ / dữ liệu cảm biến cũ)
+int ruleDesired(uint8_t d, int minuteOfDay) {
+  const LocalRule& r = g_rules[d];
+  if (!(r.flags & RULE_F_ENABLED)) return -1;
+
+  if (r.flags & RULE_F_SCHED) {
+    if (minuteOfDay < 0 || r.onMin == r.offMin) return -1;
+    bool inWindow = (r.onMin < r.offMin)
+                  ? (minuteOfDay >= r.onMin && minuteOfDay < r.offMin)
+                  : (minuteOfDay >= r.onMin || minuteOfDay < r.offMin);   // qua đêm
+    if (!(r.flags & RULE_F_THRESH)) return inWindow ? 1 : 0;
+    if (!inWindow) return 0;   // có cả 2: ngưỡng chỉ có hiệu lực trong khung giờ
+  }
+
+  if (r.flags & RULE_F_THRESH) {
+    if (r.sensor >= SENSOR_COUNT || !g_sensorValid) return -1;
+    if (millis() - g_sensorMs > SENSOR_STALE_MS) return -1;
+    int v = g_sensor[r.sensor];
+    if (r.thrOn < r.thrOff) {
+      if (v <= r.thrOn)  g_thrState[d] = 1;
+      if (v >= r.thrOff) g_thrState[d] = 0;
+    } else {
+      if (v >= r.thrOn)  g_thrState[d] = 1;
+      if (v <= r.thrOff) g_thrState[d] = 0;
+    }
+    return g_thrState[d];
+  }
+  return -1;
+}
+
+// Chạy trong loraRxTask -> cùng ngữ cảnh với lệnh từ gateway, không cần khoá
+void evalLocalRules() {
+  static uint32_t lastEval = 0;
+  if (millis() - lastEval < RULE_EVAL_MS) return;
+  lastEval = millis();
+
+  int minuteOfDay = -1;
+  if (g_clockValid) {
+    uint32_t sec = g_clockBaseSec + (millis() - g_clockBaseMs) / 1000UL;
+    minuteOfDay = (sec % 86400UL) / 60;
+  }
+
+  for (uint8_t d = 0; d < DEV_COUNT; ++d) {
+    int want = ruleDesired(d, minuteOfDay);
+    if (want < 0) continue;
+    if (want != g_ruleLast[d]) {       // luật chuyển trạng thái -> hết quyền đè
+      g_ruleLast[d] = want;
+      g_override[d] = false;
     }
+    if (g_override[d] || g_devState[d] == want) continue;
+    applyDevice(d, want);
+    Serial.printf("[NODE][RULE] %s = %s\n", DEVICES[d].name, want ? "ON" : "OFF");
+  }
+}
+
+void handleIncoming(char* buf, size_t len) {
+  CmdFrame f;
+  if ((uint8_t)buf[0] == CMD_BIN_MAGIC && len >= 2) {
+    const uint8_t* u = (const uint8_t*)buf;
+    switch (u[1]) {
+      case CMD_OP_TIME:   handleTimeFrame(u, len);   return;
+      case CMD_OP_RULES:  handleRulesFrame(u, len);  return;
+      case CMD_OP_SENSOR: handleSensorFrame(u, len); return;
+      case CMD_OP_SLOT:   return;
+    }
+    if (!parseBinaryCmd(buf, len, f)) return;
+  } else if (!parseJsonCmd(buf, len, f)) {
     return;
   }
 
+  // CHỈ XỬ LÝ LỆNH ĐƠN "set"
+  if (f.op == CMD_OP_SET) {
+    if (f.dev < 0) {
+      Serial.println("[NODE][ERROR] Unknown device");
+      return;
+    }
+    if (handleSetOne(f.dev, f.value)) {
+      if (!f.sched) g_override[f.dev] = true;   // chỉ lệnh tay ưu tiên hơn luật cục bộ
+      strlcpy(g_lastCmdId, f.id, sizeof(g_lastCmdId));
+      sendAck(f.id, f.dev, f.value);   // ACK có thông tin để gateway đánh dấu done
+    }
+  }
+}
+
+// ===================== RX THEO SỰ KIỆN =====================
+// E32 kéo AUX xuống LOW trước khi đẩy dữ liệu ra UART và nhả lên HIGH khi
+// đã xuất xong -> sườn lên AUX = kết thúc khung. Khi không nối AUX, sự kiện
+// timeout RX của UART (onReceive) làm cùng việc đó.
+void IRAM_ATTR onLoraAuxRise() {
+  BaseType_t woken = pdFALSE;
+  if (g_rxTask) vTaskNotifyGiveFromISR(g_rxTask, &woken);
+  if (woken) portYIELD_FROM_ISR();
+}
 
-  // Nếu vẫn muốn an toàn, có thể log các cmd khác để debug:
-  Serial.printf("[NODE] Unknown cmd: %s\n", cmd);
+void onLoraUartRx() {
+  if (g_rxTask) xTaskNotifyGive(g_rxTask);
+}
+
+// Gom toàn bộ byte đang có trên UART2 thành 1 khung. Đọc tiếp khi AUX còn
+// LOW (module vẫn đang xuất) hoặc chưa đủ LORA_RX_GAP_MS im lặng.
+size_t readLoraFrame(char* buf, size_t cap) {
+  size_t n = 0;
+  uint32_t last = millis();
+  for (;;) {
+    int avail = Serial2.available();
+    if (avail > 0) {
+      while (avail-- > 0) {
+        int c = Serial2.read();
+        if (c < 0) break;
+        if (n < cap) buf[n++] = (char)c;   // tràn -> bỏ phần đuôi
+      }
+      last = millis();
+      continue;
+    }
+    if (digitalRead(LORA_AUX_PIN) == HIGH && millis() - last >= LORA_RX_GAP_MS) break;
+    if (millis() - last > 100) break;     // AUX kẹt LOW -> không treo task
+    vTaskDelay(1);
+  }
+  return n;
+}
+
+void loraRxTask(void*) {
+  static char frame[LORA_RX_FRAME_MAX + 1];
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(LORA_RX_SAFETY_MS));
+    evalLocalRules();
+    pollStateBeacon();
+    if (Serial2.available() <= 0) continue;
+
+    size_t n = readLoraFrame(frame, LORA_RX_FRAME_MAX);
+    if (!n) continue;
+
+    if ((uint8_t)frame[0] == CMD_BIN_MAGIC) {
+      Serial.printf("[NODE][RX] bin %u B\n", (unsigned)n);
+      handleIncoming(frame, n);
+      continue;
+    }
+
+    // JSON: bỏ khoảng trắng 2 đầu ngay trên buffer
+    size_t b = 0;
+    while (b < n && isspace((unsigned char)frame[b])) b++;
+    while (n > b && isspace((unsigned char)frame[n - 1])) n--;
+    if (n == b) continue;
+    frame[n] = 0;
+
+    Serial.print("[NODE][RX] "); Serial.println(frame + b);
+    handleIncoming(frame + b, n - b);
+  }
 }
 
 // ===================== SETUP / LOOP =====================
@@ -153,25 +516,21 @@ void setup() {
   digitalWrite(PIN_RELAY_LIGHT, toLevel(0));
   digitalWrite(PIN_RELAY_FAN,   toLevel(0));
 
+  // Luật tự động đã lưu (chạy lại được ngay cả khi chưa liên lạc gateway)
+  loadLocalRules();
+
+  // RX theo sự kiện: task nhận khung + ngắt sườn lên AUX + timeout UART
+  g_loraLock = xSemaphoreCreateMutex();
+  xTaskCreatePinnedToCore(loraRxTask, "loraRx", LORA_RX_TASK_STACK, nullptr,
+                          LORA_RX_TASK_PRIO, &g_rxTask, 1);
+  attachInterrupt(digitalPinToInterrupt(LORA_AUX_PIN), onLoraAuxRise, RISING);
+  Serial2.onReceive(onLoraUartRx, true);
+
   Serial.println("[NODE] Ready.");
 }
 
 void loop() {
-  // Nhận lệnh từ Gateway
-  if (lora.available() > 0) {
-    ResponseContainer rc = lora.receiveMessage();
-    if (rc.status.code == 1) {
-      String data = rc.data;
-      data.trim();
-      if (data.length()) {
-        Serial.print("[NODE][RX] "); Serial.println(data);
-        handleIncoming(data);
-      }
-    } else {
-      // Lỗi mức link/CRC...
-      Serial.printf("[NODE][RX_ERR] code=%d\n", rc.status.code);
-    }
-  }
+  // Nhận lệnh từ Gateway: do loraRxTask xử lý khi AUX/UART báo hết khung
 
   // (Tuỳ chọn) Cho phép gửi tay lệnh bằng Serial để test
   if (Serial.available()) {
@@ -179,9 +538,9 @@ void loop() {
     line.trim();
     if (line.length()) {
       Serial.print("[SERIAL->E32] "); Serial.println(line);
-      lora.sendMessage(line);
+      loraSend(line.c_str(), line.length());
     }
   }
 
-  delay(5);
+  delay(20);
 }
@@ -27,9 +27,28 @@ ScioSense_ENS160 ens160(ENS160_I2CADDR_1);  // 0x53
 // ===== LoRa E32 (AS32) =====
 SoftwareSerial e32Serial(4, 5);  // RX, TX
 LoRa_E32 lora(&e32Serial, 9600);
+#define LORA_AUX_PIN     6       // AUX E32 (LOW = bận), -1 nếu không nối
+
+// ===== Lịch phát: jitter + nghe trước khi phát + khe của gateway =====
+// Khung broadcast của gateway: [0xC1][0x06][pos u16][cycle u16][slotLen/100]
+#define CMD_BIN_MAGIC      0xC1
+#define CMD_OP_SLOT        0x06
+#define TX_JITTER_MS       3000UL   // ± quanh SEND_INTERVAL_MS khi chưa có khe
+#define SLOT_STALE_MS      (30UL * 60UL * 1000UL)
+#define LBT_SENSE_MIN_MS   10
+#define LBT_SENSE_MAX_MS   60
+#define LBT_BACKOFF_MS     40
+#define LBT_MAX_WAIT_MS    1500
 
 // ===== Thời gian =====
 unsigned long lastSend = 0;
+unsigned long nextGap  = SEND_INTERVAL_MS;
+String        txPayload;            // bản đo của lượt này, giữ lại khi kênh bận/lỗi gửi
+bool          txPending = false;
+unsigned long slotBase = 0;    // millis() tại đầu chu kỳ khe của gateway
+unsigned long slotSync = 0;    // 0 = chưa nhận khung khe
+uint16_t      slotCycle = 0;
+uint16_t      slotLen   = 0;
 
 // ---- ENS210 format (Kelvin*64, %RH*512) ----
 static inline uint16_t toENS210_T(float tC) { return (uint16_t)((tC + 273.15f) * 64.0f + 0.5f); }
@@ -37,11 +56,77 @@ static inline uint16_t toENS210_H(float rh) {
   if (rh < 0) rh = 0; if (rh > 100) rh = 100; return (uint16_t)(rh * 512.0f + 0.5f);
 }
 
+// Đọc khung từ gateway (chỉ quan tâm khung khe thời gian)
+void pollGatewayFrames() {
+  if (e32Serial.available() <= 0) return;
+  uint8_t buf[16]; uint8_t n = 0;
+  unsigned long t0 = millis();
+  while (millis() - t0 < 20) {
+    if (e32Serial.available() > 0) {
+      int c = e32Serial.read();
+      if (n < sizeof(buf)) buf[n++] = (uint8_t)c;
+      t0 = millis();
+    }
+  }
+  if (n < 7 || buf[0] != CMD_BIN_MAGIC || buf[1] != CMD_OP_SLOT) return;
+  uint16_t pos, cycle;
+  memcpy(&pos, buf + 2, 2);
+  memcpy(&cycle, buf + 4, 2);
+  if (cycle == 0 || buf[6] == 0) return;
+  slotCycle = cycle;
+  slotLen   = (uint16_t)buf[6] * 100U;
+  slotBase  = millis() - pos;
+  slotSync  = millis() | 1;
+}
+
+inline bool loraChannelClear() {
+  if (LORA_AUX_PIN >= 0 && digitalRead(LORA_AUX_PIN) == LOW) return false;
+  return e32Serial.available() <= 0;
+}
+
+// Nghe trước khi phát: rảnh liên tục 1 khoảng ngẫu nhiên, bận -> lùi theo cấp số
+bool loraWaitClear() {
+  unsigned long t0 = millis();
+  uint8_t busy = 0;
+  while (millis() - t0 < LBT_MAX_WAIT_MS) {
+    if (loraChannelClear()) {
+      delay(random(LBT_SENSE_MIN_MS, LBT_SENSE_MAX_MS));
+      if (loraChannelClear()) return true;
+    }
+    pollGatewayFrames();
+    if (busy < 3) busy++;
+    delay(random(LBT_BACKOFF_MS, (unsigned long)LBT_BACKOFF_MS << busy));
+  }
+  return false;
+}
+
+// Tới lượt phát? Có khe: vào đầu khe NODE_ID (jitter nhỏ trong 1/4 khe) và đã
+// gần đủ chu kỳ; chưa có khe: SEND_INTERVAL_MS ± TX_JITTER_MS.
+bool txDue(unsigned long now) {
+  if (slotSync && now - slotSync < SLOT_STALE_MS && (unsigned long)NODE_ID * slotLen < slotCycle) {
+    if (now - lastSend < slotCycle - slotLen) return false;
+    unsigned long pos   = (now - slotBase) % slotCycle;
+    unsigned long start = (unsigned long)NODE_ID * slotLen;
+    return pos >= start && pos < start + slotLen / 4;
+  }
+  return now - lastSend >= nextGap;
+}
+
+// Đã phát xong bản đo của lượt này: hẹn lượt sau
+void txDone(unsigned long now) {
+  lastSend = now;
+  nextGap  = SEND_INTERVAL_MS + random(0, 2 * TX_JITTER_MS) - TX_JITTER_MS;
+}
+
 void setup() {
   Serial.begin(9600);
 
   e32Serial.begin(9600);
   e32Serial.setTimeout(50);
+  if (LORA_AUX_PIN >= 0) pinMode(LORA_AUX_PIN, INPUT_PULLUP);
+  randomSeed(analogRead(A1) ^ (NODE_ID * 7919UL) ^ micros());
+  nextGap = SEND_INTERVAL_MS + random(0, 2 * TX_JITTER_MS) - TX_JITTER_MS;
+  txPayload.reserve(MAX_E32_PAYLOAD + 8);   // cấp 1 lần, tránh phân mảnh heap của Mega
 
   Wire.begin();
   dht.begin();
@@ -55,11 +140,8 @@ void setup() {
   Serial.println(F("Node started."));
 }
 
-void loop() {
-  const unsigned long now = millis();
-  if (now - lastSend < SEND_INTERVAL_MS) return;
-  lastSend = now;
-
+// Đo và đóng gói bản đo vào txPayload; false nếu không có gì để phát
+bool takeReading(unsigned long now) {
   // ---- DHT22 (bù ENS160) ----
   float h = dht.readHumidity();
   float t = dht.readTemperature();
@@ -98,15 +180,29 @@ void loop() {
   arr.add(ens_ok ? aqi  : 0);
   arr.add(ts5);
 
-  String payload; serializeJson(arr, payload);
+  txPayload = "";
+  serializeJson(arr, txPayload);
 
-  Serial.print(F("[LEN] ")); Serial.print(payload.length()); Serial.print(F("B  [TX] ")); Serial.println(payload);
-  if (payload.length() > MAX_E32_PAYLOAD) {
+  Serial.print(F("[LEN] ")); Serial.print(txPayload.length()); Serial.print(F("B  [TX] ")); Serial.println(txPayload);
+  if (txPayload.length() > MAX_E32_PAYLOAD) {
     Serial.println(F("[ERR][LEN] >58B -> skip"));
-    return;
+    txDone(now);  // payload quá dài thì thử lại cũng không gửi được
+    return false;
   }
+  txPending = true;
+  return true;
+}
 
-  ResponseStatus rs = lora.sendFixedMessage(0x00, 0x00, 23, payload);  // sửa địa chỉ/kênh nếu cần
-  if (rs.code == 1) Serial.println(F("[TX] OK"));
+void loop() {
+  pollGatewayFrames();
+  const unsigned long now = millis();
+  if (!txDue(now)) return;
+  // Chỉ đo lại sau khi đã phát được (txDone): kênh bận/lỗi gửi thì loop sau
+  // chỉ nghe kênh và phát lại bản đo cũ, không tốn thêm một lượt đọc cảm biến
+  if (!txPending && !takeReading(now)) return;
+
+  if (!loraWaitClear()) { Serial.println(F("[TX] busy -> retry")); return; }
+  ResponseStatus rs = lora.sendFixedMessage(0x00, 0x00, 23, txPayload);  // sửa địa chỉ/kênh nếu cần
+  if (rs.code == 1) { Serial.println(F("[TX] OK")); txPending = false; txDone(now); }
   else { Serial.print(F("[ERR][SEND] ")); Serial.println(rs.getResponseDescription()); }
 }
@@ -0,0 +1,606 @@
+// Bench cho bộ JSON đi kèm (FirebaseJson, MB_JSON, fb_json_print) chạy trên Linux.
+// Mỗi file trong corpus là một payload đã ghi lại từ gateway; với mỗi payload đo
+// thông lượng parse (cả nạp từng đoạn, bảng khoá chung, arena)/get/set/serialize/iterate
+// chuỗi MB_String của một request RTDB và đọc phản hồi chunked qua Client giả lập,
+// cùng số lần cấp phát và đỉnh heap; thêm độ phân mảnh heap khi parse/xoá lặp lại.
+// Kết quả in ra stdout dạng JSON Lines (mỗi dòng một cặp payload/thao tác) để lưu
+// lại và so sánh giữa các lần chạy.
+//
+//   ./json_bench [--time-ms 200] [--filter chuoi] corpus/*.json
+
+#include <Arduino.h>
+#include "FirebaseJson.h"
+#include "extras/print/fb_json_print.h"
+#include "FB_ReadBuffer.h"
+
+#include <malloc.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+Print Serial;
+
+unsigned long millis() {
+  static const auto t0 = std::chrono::steady_clock::now();
+  return (unsigned long)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0).count();
+}
+
+extern "C" void fb_json_putchar(char c) { (void)c; }
+
+// ================== ĐẾM CẤP PHÁT ==================
+// Thay malloc/realloc/calloc/free của glibc để đếm số lần, số byte và byte còn sống.
+extern "C" void *__libc_malloc(size_t);
+extern "C" void *__libc_realloc(void *, size_t);
+extern "C" void *__libc_calloc(size_t, size_t);
+extern "C" void __libc_free(void *);
+
+namespace heap {
+static size_t allocs = 0;
+static size_t reallocs = 0;
+static size_t bytes = 0;
+static size_t live = 0;
+static size_t peak = 0;
+
+static inline void onAlloc(void *p) {
+  if (!p) return;
+  size_t n = malloc_usable_size(p);
+  allocs++;
+  bytes += n;
+  live += n;
+  if (live > peak) peak = live;
+}
+static inline void onFree(void *p) {
+  if (p) live -= malloc_usable_size(p);
+}
+
+struct Snapshot {
+  size_t allocs, bytes, live;
+};
+static Snapshot begin() {
+  peak = live;
+  Snapshot s = {allocs, bytes, live};
+  return s;
+}
+
+// Các lỗ trống nằm giữa các khối còn sống (không tính phần đỉnh heap glibc trả lại được).
+struct Holes {
+  size_t blocks, bytes, largest;
+};
+static Holes holes() {
+  malloc_trim(0);  // gộp fastbin, trả phần đỉnh để chỉ còn các lỗ bị khối sống chặn
+  struct mallinfo2 mi = mallinfo2();
+  Holes h;
+  h.blocks = mi.ordblks + mi.smblks - 1;  // bỏ khối đỉnh
+  h.bytes = mi.fordblks + mi.fsmblks - mi.keepcost;
+  // khối lớn nhất cấp được trong các lỗ: glibc chỉ cắt từ đỉnh khi không lỗ nào vừa
+  size_t lo = 0, hi = h.bytes;
+  while (lo < hi) {
+    size_t mid = (lo + hi + 1) / 2;
+    const char *top = (const char *)sbrk(0) - mi.keepcost;
+    char *p = (char *)__libc_malloc(mid);
+    bool inHole = p && p + mid <= top;
+    __libc_free(p);
+    malloc_trim(0);
+    mi = mallinfo2();
+    if (inHole) lo = mid;
+    else hi = mid - 1;
+  }
+  h.largest = lo;
+  return h;
+}
+
+// Lấp các lỗ có sẵn (của các thao tác trước) để chỉ đếm lỗ do kịch bản tạo ra.
+static void plugHoles(std::vector<void *> &plugs) {
+  for (Holes h = holes(); h.largest > 0 && plugs.size() < 4096; h = holes())
+    plugs.push_back(__libc_malloc(h.largest));
+}
+}  // namespace heap
+
+extern "C" void *malloc(size_t n) {
+  void *p = __libc_malloc(n);
+  heap::onAlloc(p);
+  return p;
+}
+extern "C" void *calloc(size_t n, size_t m) {
+  void *p = __libc_calloc(n, m);
+  heap::onAlloc(p);
+  return p;
+}
+extern "C" void *realloc(void *p, size_t n) {
+  heap::reallocs++;
+  heap::onFree(p);
+  void *q = __libc_realloc(p, n);
+  if (q) heap::onAlloc(q);
+  else if (p && n) heap::live += malloc_usable_size(p);  // khối cũ vẫn còn
+  return q;
+}
+extern "C" void free(void *p) {
+  heap::onFree(p);
+  __libc_free(p);
+}
+
+// ================== CORPUS ==================
+struct Probe {
+  std::string path;
+  FirebaseJsonPath compiled;
+  uint8_t type;
+  double number;
+  std::string str;
+};
+
+struct Payload {
+  std::string name;
+  std::string text;
+  std::vector<Probe> probes;
+};
+
+static const size_t MAX_PROBES = 32;
+
+static bool readFile(const char *file, std::string &out) {
+  FILE *f = fopen(file, "rb");
+  if (!f) return false;
+  char buf[4096];
+  size_t n;
+  out.clear();
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) out.append(buf, n);
+  fclose(f);
+  return true;
+}
+
+static std::string baseName(const char *file) {
+  std::string s(file);
+  size_t p = s.find_last_of('/');
+  if (p != std::string::npos) s = s.substr(p + 1);
+  p = s.rfind(".json");
+  if (p != std::string::npos) s = s.substr(0, p);
+  return s;
+}
+
+// Các nút lá rải đều trong payload làm đường dẫn cho get/set
+static void collectProbes(Payload &pl) {
+  FirebaseJson json;
+  json.setJsonData(pl.text.c_str());
+
+  std::vector<Probe> leaves;
+  std::vector<std::string> segs;
+  json.visit([&](const FirebaseJsonEntry &e) {
+    segs.resize(e.depth + 1);
+    segs[e.depth] = e.key ? std::string(e.key, e.keyLen) : "[" + std::to_string(e.index) + "]";
+    if (e.isContainer() || e.type == FirebaseJson::JSON_NULL || e.type == FirebaseJson::JSON_UNDEFINED) return true;
+    Probe pr;
+    for (size_t i = 0; i < segs.size(); i++) pr.path += (i ? "/" : "") + segs[i];
+    pr.type = e.type;
+    pr.number = e.number;
+    if (e.str) pr.str.assign(e.str, e.strLen);
+    leaves.push_back(pr);
+    return true;
+  });
+
+  size_t step = leaves.size() > MAX_PROBES ? leaves.size() / MAX_PROBES : 1;
+  for (size_t i = 0; i < leaves.size() && pl.probes.size() < MAX_PROBES; i += step) {
+    pl.probes.push_back(leaves[i]);
+    pl.probes.back().compiled.compile(leaves[i].path.c_str());
+  }
+}
+
+// ================== CHUỖI CỦA MỘT REQUEST RTDB ==================
+// Giả lập phần xử lý chuỗi (MB_String) của một request RTDB vì request thật không chạy
+// được trên Linux: tách đường dẫn thành các đoạn, dựng dòng request và header có token,
+// tách và trim các header phản hồi, ghép kiểu sự kiện với dữ liệu.
+static const char *const RESPONSE_HEADERS[] = {
+    "HTTP/1.1 200 OK",
+    "Server: nginx",
+    "Date: Sat, 18 Oct 2026 10:00:00 GMT",
+    "Content-Type: application/json; charset=utf-8",
+    "Content-Length: 4",
+    "Connection: keep-alive",
+    "Access-Control-Allow-Origin: *",
+    "Cache-Control: no-cache",
+    "ETag: abc123",
+    "Strict-Transport-Security: max-age=31556926",
+};
+
+static MB_String eventType(size_t i) {
+  static const char *const types[] = {"put", "patch", "keep-alive"};
+  return MB_String(types[i % 3]);
+}
+
+static size_t rtdbRequestStrings(const std::string &nodePath, size_t i) {
+  MB_String path = "/";
+  path += nodePath.c_str();
+
+  std::vector<MB_String> segs;
+  size_t p = 1;
+  while (true) {
+    size_t e = path.find('/', p);
+    MB_String seg;
+    path.substr(seg, p, e == MB_String::npos ? MB_String::npos : e - p);
+    segs.push_back(seg);
+    if (e == MB_String::npos) break;
+    p = e + 1;
+  }
+
+  MB_String header = "PUT ";
+  header += path;
+  header += ".json?auth=";
+  header += "eyJhbGciOiJSUzI1NiIsImtpZCI6IjFlOTczZWUwZTE2ZjdlZWY0ZjkyMWQ1MGRjNjFkNzBiMmVmZWZjMTkiLCJ0eXAiOiJKV1QifQ";
+  header += " HTTP/1.1\r\nHost: ";
+  header += "project-default-rtdb.firebaseio.com";
+  header += "\r\nConnection: keep-alive\r\nContent-Length: ";
+  header += MB_String(42);
+  header += "\r\n\r\n";
+
+  std::vector<MB_String> keys, values;
+  for (size_t k = 0; k < sizeof(RESPONSE_HEADERS) / sizeof(RESPONSE_HEADERS[0]); k++) {
+    MB_String line = RESPONSE_HEADERS[k];
+    size_t c = line.find(':');
+    if (c == MB_String::npos) continue;
+    keys.push_back(line.substr(0, c));
+    MB_String v = line.substr(c + 1);
+    v.trim();
+    values.push_back(v);
+  }
+
+  MB_String event = eventType(i);
+  event += ":";
+  event += "28.5";
+  return segs.size() + header.length() + values.size() + event.length();
+}
+
+// ================== ĐỌC PHẢN HỒI QUA CLIENT ==================
+// Client giả lập TLS: mỗi lần gọi read() tốn một lượt bơm engine cố định như BearSSL
+// trên thiết bị, nên số lần gọi read() quyết định thời gian đọc.
+class BenchClient : public Client {
+public:
+  std::string data;
+  size_t pos = 0;
+  size_t reads = 0;
+
+  int available() override { return (int)(data.size() - pos); }
+  int read() override {
+    pump();
+    return pos < data.size() ? (uint8_t)data[pos++] : -1;
+  }
+  int read(uint8_t *buf, size_t len) override {
+    pump();
+    size_t n = data.size() - pos < len ? data.size() - pos : len;
+    memcpy(buf, data.data() + pos, n);
+    pos += n;
+    return (int)n;
+  }
+
+private:
+  void pump() {
+    reads++;
+    volatile int x = 0;
+    for (int i = 0; i < 200; i++) x += i;
+  }
+};
+
+// Thân phản hồi chunked kiểu stream SSE: mỗi chunk là một dòng "data: " chứa tối đa 1 KB
+// của payload (bỏ xuống dòng) và kết thúc đúng ở '\n' để dòng không vắt qua hai chunk.
+static std::string chunkedBody(const std::string &text) {
+  std::string flat(text);
+  for (size_t i = 0; i < flat.size(); i++)
+    if (flat[i] == '\n' || flat[i] == '\r') flat[i] = ' ';
+  std::string body;
+  char size[16];
+  for (size_t i = 0; i < flat.size(); i += 1024) {
+    std::string chunk = "data: " + flat.substr(i, 1024) + "\n";
+    snprintf(size, sizeof(size), "%zx\r\n", chunk.size());
+    body += size;
+    body += chunk;
+    body += "\r\n";
+  }
+  body += "0\r\n\r\n";
+  return body;
+}
+
+// Vòng đọc từng byte như HttpHelper::readLine(Client *, ...) trước khi có FB_ReadBuffer
+static int readLineBytewise(Client *client, char *buf, int bufLen) {
+  int idx = 0;
+  while (client->available() && idx < bufLen) {
+    FBUtils::idle();
+    int res = client->read();
+    if (res > -1) {
+      buf[idx++] = (char)res;
+      if (res == '\n') return idx;
+    }
+  }
+  return idx;
+}
+
+// Giải mã chunked theo từng dòng, trả về số byte dữ liệu đã đọc
+template <typename ReadLine>
+static size_t readChunked(ReadLine readLine) {
+  char line[512];
+  size_t body = 0;
+  while (true) {
+    int n = readLine(line, 32);
+    if (n <= 0) break;
+    int size = FB_ReadBuffer::chunkSize(line, n);
+    if (size <= 0) break;
+    // dữ liệu của chunk và CRLF sau nó
+    int got = 0;
+    while (got < size + 2) {
+      int k = readLine(line, sizeof(line));
+      if (k <= 0) return body;
+      got += k;
+    }
+    body += size;
+  }
+  return body;
+}
+
+// ================== ĐO ==================
+struct Options {
+  double timeMs = 200;
+  const char *filter = NULL;
+};
+
+static Options opt;
+
+// perProbe: thao tác lặp trên các nút lá đã chọn, báo thời gian mỗi nút thay cho MB/s
+// extra: in thêm các trường riêng của thao tác (sau lần chạy cuối, nhận ns mỗi lần chạy)
+static void report(const Payload &pl, const char *op, bool perProbe, const std::function<void()> &fn,
+                   const std::function<void()> &setup = std::function<void()>(),
+                   const std::function<void(double)> &extra = std::function<void(double)>()) {
+  if (opt.filter && !strstr(op, opt.filter) && pl.name.find(opt.filter) == std::string::npos) return;
+
+  // một lần chạy riêng để lấy số cấp phát/đỉnh heap (các thao tác đều tất định)
+  if (setup) setup();
+  fn();
+  if (setup) setup();
+  heap::Snapshot s = heap::begin();
+  fn();
+  size_t allocs = heap::allocs - s.allocs;
+  size_t bytes = heap::bytes - s.bytes;
+  size_t peak = heap::peak - s.live;
+
+  // chạy thử để ước lượng số vòng cho đủ thời gian đo
+  typedef std::chrono::steady_clock clk;
+  size_t iters = 1;
+  double ns = 0;
+  while (true) {
+    double total = 0;
+    for (size_t i = 0; i < iters; i++) {
+      if (setup) setup();
+      clk::time_point t0 = clk::now();
+      fn();
+      total += std::chrono::duration<double, std::nano>(clk::now() - t0).count();
+    }
+    ns = total / iters;
+    if (total >= opt.timeMs * 1e6 || iters >= (1u << 24)) break;
+    double want = opt.timeMs * 1e6 / (ns > 1 ? ns : 1);
+    iters = want > iters * 2 ? (size_t)want : iters * 2;
+  }
+
+  printf("{\"payload\":\"%s\",\"op\":\"%s\",\"bytes\":%zu,\"probes\":%zu,\"iters\":%zu,\"ns_per_op\":%.1f,",
+         pl.name.c_str(), op, pl.text.size(), pl.probes.size(), iters, ns);
+  if (perProbe)
+    printf("\"ns_per_probe\":%.1f,", pl.probes.empty() ? 0.0 : ns / pl.probes.size());
+  else
+    printf("\"mb_per_s\":%.2f,", ns > 0 ? pl.text.size() * 1e3 / ns : 0.0);
+  printf("\"allocs_per_op\":%zu,\"alloc_bytes_per_op\":%zu,\"peak_heap_bytes\":%zu", allocs, bytes, peak);
+  if (extra) extra(ns);
+  printf("}\n");
+  fflush(stdout);
+}
+
+// Phân mảnh: mỗi vòng parse một cây, giữ lại một khối nhỏ sống lâu (như String
+// của số đo giữ tới lần gửi sau) rồi xoá cây. Khối giữ lại chặn giữa các nút đã trả
+// -> đếm lỗ trống và khối lớn nhất cấp được trong đó (trên ESP32 là
+// heap_caps_get_largest_free_block).
+static const size_t FRAG_ROUNDS = 64;
+static const size_t FRAG_KEEP_BYTES = 48;
+
+static void reportFragmentation(const Payload &pl, const char *op, FirebaseJson &json) {
+  if (opt.filter && !strstr(op, opt.filter) && pl.name.find(opt.filter) == std::string::npos) return;
+
+  // chạy trong tiến trình con để heap và arena cùng bắt đầu từ một trạng thái
+  fflush(stdout);
+  pid_t pid = fork();
+  if (pid < 0) return;
+  if (pid > 0) {
+    waitpid(pid, NULL, 0);
+    return;
+  }
+
+  std::vector<void *> keep, plugs;
+  keep.reserve(FRAG_ROUNDS);
+  plugs.reserve(4096);
+  json.clear();
+  heap::plugHoles(plugs);
+  for (size_t i = 0; i < FRAG_ROUNDS; i++) {
+    json.setJsonData(pl.text.c_str());
+    keep.push_back(malloc(FRAG_KEEP_BYTES));
+    json.clear();
+  }
+  heap::Holes h = heap::holes();
+
+  printf("{\"payload\":\"%s\",\"op\":\"%s\",\"bytes\":%zu,\"rounds\":%zu,\"free_blocks\":%zu,"
+         "\"free_bytes\":%zu,\"largest_free_bytes\":%zu,\"frag_pct\":%.1f}\n",
+         pl.name.c_str(), op, pl.text.size(), FRAG_ROUNDS, h.blocks, h.bytes, h.largest,
+         h.bytes ? 100.0 * (h.bytes - h.largest) / h.bytes : 0.0);
+  fflush(stdout);
+  _exit(0);
+}
+
+static void benchPayload(Payload &pl) {
+  const char *text = pl.text.c_str();
+  FirebaseJson json;
+  FirebaseJsonData data;
+  String out;
+  size_t sink = 0;
+
+  // ---- parse ----
+  // cây cũ được xoá trước khi đo để đỉnh heap là kích thước cây mới
+  report(pl, "parse", false, [&] { json.setJsonData(text); }, [&] { json.clear(); });
+  report(pl, "mb_parse", false, [&] { MB_JSON_Delete(MB_JSON_Parse(text)); });
+  // các khoá lặp lại trỏ tới một bản chung trong bảng khoá
+  FirebaseJsonKeyPool pool;
+  FirebaseJson pooled;
+  pooled.useKeyPool(&pool);
+  report(pl, "parse_keypool", false, [&] { pooled.setJsonData(text); }, [&] { pooled.clear(); });
+  // cây nằm trong arena, clear() trả lại các chunk (giữ chunk đầu) cho lần parse sau
+  FirebaseJson arenaJson;
+  arenaJson.useArena();
+  report(pl, "parse_arena", false, [&] { arenaJson.setJsonData(text); }, [&] { arenaJson.clear(); }, [&](double) {
+    const FirebaseJsonArena *a = arenaJson.getArena();
+    printf(",\"arena_used_bytes\":%zu,\"arena_capacity_bytes\":%zu,\"arena_peak_bytes\":%zu", a->used(),
+           a->capacity(), a->peak());
+  });
+  // cùng kịch bản parse/giữ khối nhỏ/xoá trên heap và trên arena
+  {
+    FirebaseJson fragHeap;
+    reportFragmentation(pl, "frag_heap", fragHeap);
+    FirebaseJson fragArena;
+    fragArena.useArena();
+    reportFragmentation(pl, "frag_arena", fragArena);
+  }
+  // nạp từng đoạn 256 byte như khi đọc từ Client
+  report(pl, "parse_stream", false, [&] {
+    FirebaseJsonStreamParser parser;
+    for (size_t i = 0; i < pl.text.size(); i += 256)
+      parser.feed(text + i, pl.text.size() - i < 256 ? pl.text.size() - i : 256);
+    parser.finish();
+    MB_JSON_Delete(parser.release());
+  });
+
+  json.setJsonData(text);
+
+  // ---- get ----
+  report(pl, "get", true, [&] {
+    for (size_t i = 0; i < pl.probes.size(); i++) json.get(data, pl.probes[i].path.c_str());
+  });
+  report(pl, "get_compiled", true, [&] {
+    for (size_t i = 0; i < pl.probes.size(); i++) json.get(data, pl.probes[i].compiled);
+  });
+
+  // ---- set: ghi lại đúng giá trị cũ vào các nút lá ----
+  report(pl, "set", true, [&] {
+    for (size_t i = 0; i < pl.probes.size(); i++) {
+      const Probe &p = pl.probes[i];
+      switch (p.type) {
+        case FirebaseJson::JSON_STRING: json.set(p.path.c_str(), p.str.c_str()); break;
+        case FirebaseJson::JSON_BOOL: json.set(p.path.c_str(), p.number != 0); break;
+        case FirebaseJson::JSON_INT: json.set(p.path.c_str(), (int)p.number); break;
+        default: json.set(p.path.c_str(), p.number); break;
+      }
+    }
+  });
+
+  json.setJsonData(text);
+
+  // ---- serialize ----
+  report(pl, "serialize", false, [&] { json.toString(out); });
+  report(pl, "serialize_pretty", false, [&] { json.toString(out, true); });
+  report(pl, "serialize_stream", false, [&] {
+    json.writeTo([](void *ctx, const unsigned char *buf, size_t len) -> size_t {
+      *(size_t *)ctx += len;
+      (void)buf;
+      return len;
+    }, &sink);
+  });
+  MB_JSON *tree = MB_JSON_Parse(text);
+  report(pl, "mb_print", false, [&] { MB_JSON_free(MB_JSON_PrintUnformatted(tree)); });
+  MB_JSON_Delete(tree);
+
+  // ---- iterate ----
+  report(pl, "iterate_legacy", false, [&] {
+    size_t n = json.iteratorBegin();
+    for (size_t i = 0; i < n; i++) {
+      FirebaseJson::IteratorValue v = json.valueAt(i);
+      sink += v.value.length();
+    }
+    json.iteratorEnd();
+  });
+  report(pl, "iterate_cursor", false, [&] {
+    json.visit([&](const FirebaseJsonEntry &e) {
+      sink += e.strLen;
+      return true;
+    });
+  });
+
+  // ---- fb_json_print: định dạng các số của payload ----
+  report(pl, "fb_json_snprintf", true, [&] {
+    char buf[32];
+    for (size_t i = 0; i < pl.probes.size(); i++)
+      sink += fb_json_snprintf(buf, sizeof(buf), "%.2f", pl.probes[i].number);
+  });
+
+  // ---- MB_String: mỗi nút lá là đường dẫn của một request RTDB ----
+  report(pl, "mb_string_request", true, [&] {
+    for (size_t i = 0; i < pl.probes.size(); i++) sink += rtdbRequestStrings(pl.probes[i].path, i);
+  }, std::function<void()>(), [&](double) {
+    size_t allocs = heap::allocs, reallocs = heap::reallocs;
+    for (size_t i = 0; i < pl.probes.size(); i++) sink += rtdbRequestStrings(pl.probes[i].path, i);
+    size_t n = pl.probes.empty() ? 1 : pl.probes.size();
+    printf(",\"mallocs_per_request\":%.1f,\"reallocs_per_request\":%.1f",
+           (double)(heap::allocs - allocs - (heap::reallocs - reallocs)) / n, (double)(heap::reallocs - reallocs) / n);
+  });
+
+  // ---- đọc phản hồi chunked qua Client giả lập: từng byte so với cửa sổ FB_ReadBuffer ----
+  BenchClient client;
+  client.data = chunkedBody(pl.text);
+  auto readerStats = [&](double ns) {
+    printf(",\"client_reads\":%zu,\"response_bytes\":%zu,\"us_per_kb\":%.2f", client.reads, client.data.size(),
+           ns / 1e3 / (client.data.size() / 1024.0));
+  };
+  report(pl, "read_bytewise", false, [&] {
+    sink += readChunked([&](char *buf, int len) { return readLineBytewise(&client, buf, len); });
+  }, [&] {
+    client.pos = 0;
+    client.reads = 0;
+  }, readerStats);
+  FB_ReadBuffer rx;
+  rx.setClient(&client);
+  report(pl, "read_buffered", false, [&] {
+    sink += readChunked([&](char *buf, int len) { return rx.readLine(buf, len); });
+  }, [&] {
+    client.pos = 0;
+    client.reads = 0;
+    rx.reset();
+  }, readerStats);
+
+  if (sink == 1) fprintf(stderr, "\n");  // giữ kết quả không bị tối ưu bỏ
+}
+
+int main(int argc, char **argv) {
+  // FirebaseJson lưu địa chỉ chuỗi trong uint32_t, giữ toàn bộ heap ở vùng brk
+  // dưới 4 GB (build -no-pie) thay vì mmap
+  mallopt(M_MMAP_THRESHOLD, 64 * 1024 * 1024);
+
+  std::vector<Payload> corpus;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--time-ms") && i + 1 < argc) {
+      opt.timeMs = atof(argv[++i]);
+      continue;
+    }
+    if (!strcmp(argv[i], "--filter") && i + 1 < argc) {
+      opt.filter = argv[++i];
+      continue;
+    }
+    Payload pl;
+    pl.name = baseName(argv[i]);
+    if (!readFile(argv[i], pl.text)) {
+      fprintf(stderr, "json_bench: khong doc duoc %s\n", argv[i]);
+      return 1;
+    }
+    corpus.push_back(pl);
+  }
+
+  if (corpus.empty()) {
+    fprintf(stderr, "dung: %s [--time-ms N] [--filter chuoi] payload.json...\n", argv[0]);
+    return 1;
+  }
+
+  for (size_t i = 0; i < corpus.size(); i++) {
+    collectProbes(corpus[i]);
+    benchPayload(corpus[i]);
+  }
+  return 0;
+}
@@ -0,0 +1,16 @@
+// Client giả lập cho bench, FirebaseJson chỉ cần kiểu này để khai báo các hàm đọc/ghi
+#ifndef _BENCH_MOCK_CLIENT_H_
+#define _BENCH_MOCK_CLIENT_H_
+
+#include "Arduino.h"
+
+class Client : public Stream {
+public:
+  virtual int connect(const char *, uint16_t) { return 0; }
+  virtual uint8_t connected() { return 0; }
+  virtual void stop() {}
+  virtual int read(uint8_t *, size_t) { return 0; }
+  using Stream::read;
+};
+
+#endif
@@ -0,0 +1,140 @@
+#ifndef _RECORD_WRITER_H_
+#define _RECORD_WRITER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+
+// Ghi bản ghi JSON có hình dạng cố định thẳng vào buffer trên stack.
+// Khóa và kiểu của từng trường khai báo một lần bằng REC_FIELD; đoạn ,"khóa": được
+// ghép sẵn lúc biên dịch và kích thước tối đa của bản ghi là hằng số biên dịch,
+// nên mỗi lần ghi chỉ còn lại việc định dạng các con số.
+//
+//   namespace rec_key { REC_FIELD(t, rec::Fixed2); REC_FIELD(ts, rec::U64); }
+//   typedef rec::Record<rec_key::t, rec_key::ts> Rec;
+//   Rec::Buffer buf;
+//   Rec::write(buf, 28.5f, ts);   // {"t":28.5,"ts":1760000000}
+
+namespace rec {
+
+namespace detail {
+
+static inline char *putU32(char *p, uint32_t u) {
+  char tmp[10];
+  int n = 0;
+  do { tmp[n++] = (char)('0' + u % 10); u /= 10; } while (u);
+  while (n) *p++ = tmp[--n];
+  return p;
+}
+
+static inline char *putU64(char *p, uint64_t u) {
+  // phần lớn giá trị vừa 32 bit, tránh phép chia 64 bit
+  if (u <= 0xFFFFFFFFull) return putU32(p, (uint32_t)u);
+  char tmp[20];
+  int n = 0;
+  do { tmp[n++] = (char)('0' + u % 10); u /= 10; } while (u);
+  while (n) *p++ = tmp[--n];
+  return p;
+}
+
+}  // namespace detail
+
+// Số nguyên có dấu 32 bit
+struct Int {
+  typedef int32_t value_type;
+  static constexpr size_t maxLen = 11;  // -2147483648
+  static char *put(char *p, int32_t v) {
+    if (v < 0) *p++ = '-';
+    return detail::putU32(p, v < 0 ? 0u - (uint32_t)v : (uint32_t)v);
+  }
+};
+
+// Số nguyên không dấu 64 bit (timestamp)
+struct U64 {
+  typedef uint64_t value_type;
+  static constexpr size_t maxLen = 20;  // 18446744073709551615
+  static char *put(char *p, uint64_t v) { return detail::putU64(p, v); }
+};
+
+// Số thực làm tròn 2 chữ số thập phân, bỏ số 0 thừa; NaN/Inf ghi null
+struct Fixed2 {
+  typedef float value_type;
+  static constexpr size_t maxLen = 14;  // -999999999.99 hoặc dạng %.6g
+  static char *put(char *p, float v) {
+    if (isnan(v) || isinf(v)) {
+      memcpy(p, "null", 4);
+      return p + 4;
+    }
+    if (fabsf(v) >= 1e9f) return p + snprintf(p, maxLen + 1, "%.6g", (double)v);
+
+    int64_t c = (int64_t)llround((double)v * 100.0);
+    if (c < 0) {
+      *p++ = '-';
+      c = -c;
+    }
+    p = detail::putU32(p, (uint32_t)(c / 100));
+    uint32_t f = (uint32_t)(c % 100);
+    if (f) {
+      *p++ = '.';
+      *p++ = (char)('0' + f / 10);
+      if (f % 10) *p++ = (char)('0' + f % 10);
+    }
+    return p;
+  }
+};
+
+// Khai báo trường: tên struct chính là khóa JSON, đoạn ,"khóa": là chuỗi hằng
+#define REC_FIELD(key, Kind)                                          \
+  struct key {                                                        \
+    typedef Kind kind;                                                \
+    static constexpr size_t fragLen = sizeof(",\"" #key "\":") - 1;   \
+    static const char *frag() { return ",\"" #key "\":"; }           \
+  }
+
+namespace detail {
+
+template <class... F> struct SumLen;
+template <> struct SumLen<> { static constexpr size_t value = 0; };
+template <class F, class... R> struct SumLen<F, R...> {
+  static constexpr size_t value = F::fragLen + F::kind::maxLen + SumLen<R...>::value;
+};
+
+template <class... F> struct Writer;
+template <> struct Writer<> {
+  static char *put(char *p) { return p; }
+};
+template <class F, class... R> struct Writer<F, R...> {
+  template <class V, class... VR>
+  static char *put(char *p, V v, VR... rest) {
+    memcpy(p, F::frag(), F::fragLen);
+    p = F::kind::put(p + F::fragLen, (typename F::kind::value_type)v);
+    return Writer<R...>::put(p, rest...);
+  }
+};
+
+}  // namespace detail
+
+template <class... F>
+struct Record {
+  static constexpr size_t fieldCount = sizeof...(F);
+  // dấu ',' của trường đầu được thay bằng '{', cộng thêm '}'
+  static constexpr size_t maxLen = detail::SumLen<F...>::value + 1;
+  typedef char Buffer[maxLen + 1];
+
+  // Ghi các giá trị theo đúng thứ tự trường, trả về độ dài chuỗi (không tính '\0')
+  template <class... V>
+  static size_t write(Buffer &out, V... values) {
+    static_assert(sizeof...(V) == sizeof...(F), "so gia tri phai bang so truong cua ban ghi");
+    char *p = detail::Writer<F...>::put(out, values...);
+    out[0] = '{';
+    *p++ = '}';
+    *p = '\0';
+    return (size_t)(p - out);
+  }
+};
+
+}  // namespace rec
+
+#endif
@@ -41,28 +41,12 @@
 #include <Schedule.h>
 #endif
 
-#if defined(ESP8266)
-#if __has_include(<core_esp8266_version.h>)
-#include <core_esp8266_version.h>
-#endif
-#endif
+#include "./FB_ReadBuffer.h"
 
 using namespace mb_string;
 
 #define stringPtr2Str(p) (MB_String().appendPtr(p).c_str())
 
-namespace FBUtils
-{
-    inline void idle()
-    {
-#if defined(ARDUINO_ESP8266_MAJOR) && defined(ARDUINO_ESP8266_MINOR) && defined(ARDUINO_ESP8266_REVISION) && ((ARDUINO_ESP8266_MAJOR == 3 && ARDUINO_ESP8266_MINOR >= 1) || ARDUINO_ESP8266_MAJOR > 3)
-        esp_yield();
-#else
-        delay(0);
-#endif
-    }
-};
-
 class StringHelper
 {
 public:
@@ -1007,10 +991,12 @@ public:
     }
 
     void intTCPHandler(Client *client, struct firebase_tcp_response_handler_t &tcpHandler,
-                       size_t defaultChunkSize, size_t respSize, MB_String *payload, bool isOTA)
+                       size_t defaultChunkSize, size_t respSize, MB_String *payload, bool isOTA,
+                       FB_ReadBuffer *rx = nullptr)
     {
         // set the client before calling available
         tcpHandler.client = client;
+        tcpHandler.rx = rx;
         tcpHandler.payloadLen = 0;
         tcpHandler.payloadRead = 0;
         tcpHandler.chunkBufSize = tcpHandler.available(); // client must be set before calling
@@ -1053,6 +1039,20 @@ public:
         return idx;
     }
 
+    int readLine(struct firebase_tcp_response_handler_t &tcpHandler, char *buf, int bufLen)
+    {
+        if (tcpHandler.rx)
+            return tcpHandler.rx->readLine(buf, bufLen);
+        return readLine(tcpHandler.client, buf, bufLen);
+    }
+
+    int readLine(struct firebase_tcp_response_handler_t &tcpHandler, MB_String &buf)
+    {
+        if (tcpHandler.rx)
+            return tcpHandler.rx->readLine(buf);
+        return readLine(tcpHandler.client, buf);
+    }
+
     int readLine(Client *client, MB_String &buf)
     {
         if (!client)
@@ -1112,7 +1112,6 @@ public:
 
         int bufLen = tcpHandler.chunkBufSize;
         char *buf = nullptr;
-        int p1 = 0;
         int olen = 0;
 
         if (tcpHandler.chunkState.state == 0)
@@ -1121,48 +1120,52 @@ public:
             tcpHandler.chunkState.chunkedSize = -1;
             tcpHandler.chunkState.dataLen = 0;
 
-            MB_String s;
-            int readLen = 0;
-
-            if (out2)
-                readLen = readLine(client, s);
-            else if (out1)
-            {
-                buf = reinterpret_cast<char *>(mbfs->newP(bufLen));
-                readLen = readLine(client, buf, bufLen);
-            }
+            // the chunk-size line is short, read it into a stack buffer and parse in place
+            char line[32];
+            int readLen = readLine(tcpHandler, line, sizeof(line));
 
             if (readLen)
             {
-                if (out1)
-                    s = buf;
+                // the rest of line is still arriving
+                unsigned long ms = millis();
+                while (line[readLen - 1] != '\n' && readLen < (int)sizeof(line) && millis() - ms < 1000)
+                {
+                    int n = readLine(tcpHandler, line + readLen, sizeof(line) - readLen);
+                    if (n > 0)
+                        readLen += n;
+                    else
+                        FBUtils::idle();
+                }
 
-                p1 = sh->strpos(s.c_str(), (const char *)MBSTRING_FLASH_MCR(";"), 0);
-                if (p1 == -1)
-                    p1 = sh->strpos(s.c_str(), (const char *)MBSTRING_FLASH_MCR("\r\n"), 0);
+                tcpHandler.chunkState.chunkedSize = FB_ReadBuffer::chunkSize(line, readLen);
 
-                if (p1 != -1)
+                // the chunk extensions that do not fit the buffer are skipped to the end of line
+                bool eol = line[readLen - 1] == '\n';
+                while (!eol && millis() - ms < 1000)
                 {
-                    if (out2)
-                        tcpHandler.chunkState.chunkedSize = hex2int(s.substr(0, p1).c_str());
-                    else if (out1)
-                    {
-                        char *temp = reinterpret_cast<char *>(mbfs->newP(p1 + 1));
-                        memcpy(temp, buf, p1);
-                        tcpHandler.chunkState.chunkedSize = hex2int(temp);
-                        mbfs->delP(&temp);
-                    }
+                    char skip[32];
+                    int n = readLine(tcpHandler, skip, sizeof(skip));
+                    if (n > 0)
+                        eol = skip[n - 1] == '\n';
+                    else
+                        FBUtils::idle();
                 }
 
+                // the CRLF of previous chunk that was not read with its data
+                if (line[0] == '\r' || line[0] == '\n')
+                    tcpHandler.chunkState.state = 0;
+                // invalid chunk-size line, the rest of body cannot be framed
+                else if (tcpHandler.chunkState.chunkedSize < 0)
+                {
+                    tcpHandler.error.code = FIREBASE_ERROR_TCP_RESPONSE_READ_FAILED;
+                    olen = -1;
+                }
                 // last chunk
-                if (tcpHandler.chunkState.chunkedSize < 1)
+                else if (tcpHandler.chunkState.chunkedSize < 1)
                     olen = -1;
             }
             else
                 tcpHandler.chunkState.state = 0;
-
-            if (out1)
-                mbfs->delP(&buf);
         }
         else
         {
@@ -1172,11 +1175,11 @@ public:
                 int readLen = 0;
 
                 if (out2)
-                    readLen = readLine(client, s);
+                    readLen = readLine(tcpHandler, s);
                 else if (out1)
                 {
                     buf = reinterpret_cast<char *>(mbfs->newP(bufLen));
-                    readLen = readLine(client, buf, bufLen);
+                    readLen = readLine(tcpHandler, buf, bufLen);
                 }
 
                 if (readLen > 0)
@@ -1232,7 +1235,7 @@ public:
 
         // the first chunk (line) can be http response status or already connected stream payload
         char *hChunk = reinterpret_cast<char *>(mbfs->newP(tcpHandler.chunkBufSize));
-        int readLen = readLine(client, hChunk, tcpHandler.chunkBufSize);
+        int readLen = readLine(tcpHandler, hChunk, tcpHandler.chunkBufSize);
         if (readLen > 0)
             tcpHandler.header += hChunk;
 
@@ -1255,7 +1258,7 @@ public:
         // do not check of the config here to allow legacy fcm to work
 
         char *hChunk = reinterpret_cast<char *>(mbfs->newP(tcpHandler.chunkBufSize));
-        int readLen = readLine(client, hChunk, tcpHandler.chunkBufSize);
+        int readLen = readLine(tcpHandler, hChunk, tcpHandler.chunkBufSize);
 
         // check is it the end of http header (\n or \r\n)?
         if ((readLen == 1 && hChunk[0] == '\r') || (readLen == 2 && hChunk[0] == '\r' && hChunk[1] == '\n'))
@@ -1535,6 +1538,17 @@ public:
         return ret;
     }
 
+    template <typename T>
+    bool decodeToArray(MB_FS *mbfs, const char *src, size_t len, MB_VECTOR<T> &val)
+    {
+        firebase_base64_io_t<T> out;
+        out.outL = &val;
+        unsigned char *base64DecBuf = creatBase64DecBuffer(mbfs);
+        bool ret = decode<T>(mbfs, base64DecBuf, src, len, out);
+        mbfs->delP(&base64DecBuf);
+        return ret;
+    }
+
     bool decodeToFile(MB_FS *mbfs, const char *src, size_t len, mbfs_file_type type)
     {
         firebase_base64_io_t<uint8_t> out;
@@ -1900,8 +1914,12 @@ public:
     {
         if (response->isChunkedEnc && tcpHandler->bufferAvailable < 0)
         {
-            // Read all remaining data
-            tcpHandler->client->flush();
+            // Read all remaining data, or only the end of this body when the next
+            // pipelined response is behind it
+            if (tcpHandler->keepRx && tcpHandler->rx)
+                tcpHandler->rx->skipLine(1000);
+            else
+                tcpHandler->client->flush();
             complete = true;
             return true;
         }
@@ -368,6 +368,12 @@ void FIREBASE_CLASS::setDoubleDigits(uint8_t digits)
         Core.internal.fb_double_digits = digits;
 }
 
+void FIREBASE_CLASS::setConnectionPool(uint8_t maxIdle, size_t maxBufferSize, uint32_t idleTimeoutMs)
+{
+    // the idle connections are closed when maxIdle is 0
+    Firebase_Connection_Pool::instance().setLimits(maxIdle, maxBufferSize, idleTimeoutMs);
+}
+
 #if defined(MBFS_SD_FS) && defined(MBFS_CARD_TYPE_SD)
 
 bool FIREBASE_CLASS::sdBegin(int8_t ss, int8_t sck, int8_t miso, int8_t mosi, uint32_t frequency)
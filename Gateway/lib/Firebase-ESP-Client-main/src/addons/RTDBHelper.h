@@ -138,6 +138,30 @@ void printResult(FirebaseData &data)
     }
 }
 
+/* Print the values of the paths e.g. {"temp", "sensor/[0]/hum"} from the stream JSON data.
+ * The values are extracted in one pass over the payload, the JSON object is not built.
+ */
+void printPaths(FIREBASE_STREAM_CLASS &data, const char *const *paths, size_t count)
+{
+    if (data.dataTypeEnum() != firebase_rtdb_data_type_json)
+        return;
+
+    FirebaseJsonExtractor extractor;
+    if (!extractor.begin(paths, count))
+        return;
+
+    String payload = data.jsonString();
+    auto print = [paths](size_t index, const char *value, size_t len, FirebaseJsonExtractor::value_type)
+    {
+        Serial.print(paths[index]);
+        Serial.print((const char *)FPSTR(": "));
+        Serial.write((const uint8_t *)value, len);
+        Serial.println();
+    };
+
+    extractor.feed(payload.c_str(), payload.length(), print);
+}
+
 void printResult(FIREBASE_STREAM_CLASS &data)
 {
 
@@ -0,0 +1,272 @@
+/**
+ * Firebase TCP Client connection pool v1.0.0
+ *
+ * Created October 18, 2026
+ *
+ * The MIT License (MIT)
+ * Copyright (c) 2022 K. Suwatchai (Mobizt)
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person returning a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef FIREBASE_CONNECTION_POOL_H
+#define FIREBASE_CONNECTION_POOL_H
+#include <Arduino.h>
+#include "./FB_Const.h"
+#if __has_include(<ESP_SSLClient.h>)
+#include <ESP_SSLClient.h>
+#else
+#include "./client/SSLClient/ESP_SSLClient.h"
+#endif
+#include "./FB_Network.h"
+
+/* Idle TLS connections shared by all Firebase_TCP_Client objects.
+ * A session that finished its request parks the (still connected) SSL client here,
+ * the next session that begins a request to the same host, port and certificate mode
+ * leases it and skips the TCP and TLS handshakes.
+ * Only the connections of the internal WiFi client are pooled, the pool owns the
+ * parked SSL client and its WiFi client until they are leased or evicted.
+ */
+class Firebase_Connection_Pool
+{
+public:
+  static Firebase_Connection_Pool &instance()
+  {
+    static Firebase_Connection_Pool pool;
+    return pool;
+  }
+
+  /**
+   * Set the pool limits.
+   * @param maxIdle The maximum number of idle connections, 0 disables the pool.
+   * @param maxBufferSize The maximum BearSSL io buffer bytes of the active and idle connections, 0 for no limit.
+   * @param idleTimeoutMs The time in ms that the idle connection is kept.
+   */
+  void setLimits(uint8_t maxIdle, size_t maxBufferSize, uint32_t idleTimeoutMs)
+  {
+#if defined(ESP32)
+    if (!_lock)
+      _lock = xSemaphoreCreateMutex();
+#endif
+    lock();
+    _max_idle = maxIdle;
+    _max_buffer = maxBufferSize;
+    _idle_timeout = idleTimeoutMs;
+    evict();
+    unlock();
+  }
+
+  bool enabled() const { return _max_idle > 0; }
+
+  /**
+   * Take the idle connection.
+   * @param host The host name.
+   * @param port The port.
+   * @param mode The certificate mode (firebase_cert_type) of the lessee.
+   * @param ssl The SSL client result.
+   * @param client The WiFi client result.
+   * @param size The io buffer bytes of the leased connection.
+   * @return true when the connected client was leased.
+   */
+  bool lease(const char *host, uint16_t port, uint8_t mode, ESP_SSLClient *&ssl, Client *&client, size_t &size)
+  {
+    bool ret = false;
+    lock();
+    expire();
+    // newest first, it is the least likely to be closed by the server
+    for (int i = (int)_idle.size() - 1; i >= 0; i--)
+    {
+      firebase_pool_entry_t &e = _idle[i];
+      if (e.port != port || e.mode != mode || strcmp(e.host.c_str(), host) != 0)
+        continue;
+
+      if (!e.ssl->connected())
+      {
+        drop(i);
+        continue;
+      }
+
+      ssl = e.ssl;
+      client = e.client;
+      size = e.size;
+      _idle_bytes -= e.size;
+      _active_bytes += e.size;
+      _idle.erase(_idle.begin() + i);
+      _stats.leases++;
+      ret = true;
+      break;
+    }
+    unlock();
+    return ret;
+  }
+
+  /**
+   * Park the connected client.
+   * @param ssl The connected SSL client.
+   * @param client The WiFi client used by ssl.
+   * @param host The host name.
+   * @param port The port.
+   * @param mode The certificate mode (firebase_cert_type) of the owner.
+   * @param size The io buffer bytes that was acquired for this connection.
+   * @return true when the pool takes the ownership of ssl and client.
+   */
+  bool park(ESP_SSLClient *ssl, Client *client, const char *host, uint16_t port, uint8_t mode, size_t size)
+  {
+    if (!enabled())
+      return false;
+
+    lock();
+    firebase_pool_entry_t e;
+    e.ssl = ssl;
+    e.client = client;
+    e.host = host;
+    e.port = port;
+    e.mode = mode;
+    e.size = size;
+    e.ms = millis();
+    _idle.push_back(e);
+    _active_bytes = _active_bytes > size ? _active_bytes - size : 0;
+    _idle_bytes += size;
+    _stats.parks++;
+    evict();
+    unlock();
+    return true;
+  }
+
+  /**
+   * Account the io buffer of the new connection, the oldest idle connections are
+   * closed until the total fits the buffer limit.
+   * @param size The io buffer bytes.
+   */
+  void acquire(size_t size)
+  {
+    lock();
+    _active_bytes += size;
+    evict();
+    unlock();
+  }
+
+  /**
+   * Remove the io buffer of the closed connection from the accounting.
+   * @param size The io buffer bytes.
+   */
+  void release(size_t size)
+  {
+    lock();
+    _active_bytes = _active_bytes > size ? _active_bytes - size : 0;
+    unlock();
+  }
+
+  /**
+   * Close all idle connections.
+   */
+  void clear()
+  {
+    lock();
+    while (_idle.size() > 0)
+      drop(0);
+    unlock();
+  }
+
+  size_t idleCount() const { return _idle.size(); }
+
+  size_t bufferSize() const { return _active_bytes + _idle_bytes; }
+
+  FirebaseConnectionPoolStats stats() const { return _stats; }
+
+private:
+  struct firebase_pool_entry_t
+  {
+    ESP_SSLClient *ssl = nullptr;
+    Client *client = nullptr;
+    MB_String host;
+    uint16_t port = 0;
+    uint8_t mode = 0;
+    size_t size = 0;
+    unsigned long ms = 0;
+  };
+
+  Firebase_Connection_Pool() {}
+
+  void lock()
+  {
+#if defined(ESP32)
+    if (_lock)
+      xSemaphoreTake(_lock, portMAX_DELAY);
+#endif
+  }
+
+  void unlock()
+  {
+#if defined(ESP32)
+    if (_lock)
+      xSemaphoreGive(_lock);
+#endif
+  }
+
+  void expire()
+  {
+    for (int i = (int)_idle.size() - 1; i >= 0; i--)
+    {
+      if (millis() - _idle[i].ms > _idle_timeout)
+        drop(i);
+    }
+  }
+
+  // Close the oldest idle connections until both limits are met.
+  void evict()
+  {
+    expire();
+    while (_idle.size() > 0 &&
+           (_idle.size() > _max_idle ||
+            (_max_buffer > 0 && _active_bytes + _idle_bytes > _max_buffer)))
+    {
+      drop(0);
+      _stats.evictions++;
+    }
+  }
+
+  void drop(size_t index)
+  {
+    firebase_pool_entry_t &e = _idle[index];
+    // stop frees the BearSSL io buffers
+    e.ssl->stop();
+    delete e.ssl;
+#if defined(FIREBASE_WIFI_IS_AVAILABLE) && defined(BASE_WIFICLIENT)
+    delete (BASE_WIFICLIENT *)e.client;
+#else
+    delete e.client;
+#endif
+    _idle_bytes = _idle_bytes > e.size ? _idle_bytes - e.size : 0;
+    _idle.erase(_idle.begin() + index);
+  }
+
+  MB_VECTOR<firebase_pool_entry_t> _idle;
+  uint8_t _max_idle = 0;
+  size_t _max_buffer = 0;
+  uint32_t _idle_timeout = 30000;
+  size_t _active_bytes = 0;
+  size_t _idle_bytes = 0;
+  FirebaseConnectionPoolStats _stats;
+#if defined(ESP32)
+  SemaphoreHandle_t _lock = NULL;
+#endif
+};
+
+#endif /* FIREBASE_CONNECTION_POOL_H */
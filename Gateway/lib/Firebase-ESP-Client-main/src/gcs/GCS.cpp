@@ -1162,7 +1162,8 @@ bool GG_CloudStorage::handleResponse(FirebaseData *fbdo, struct firebase_gcs_req
     struct firebase_tcp_response_handler_t tcpHandler;
 
     Core.hh.initTCPSession(fbdo->session);
-    Core.hh.intTCPHandler(&fbdo->tcpClient, tcpHandler, 2048, fbdo->session.resp_size, &payload, isOTA);
+    Core.hh.intTCPHandler(&fbdo->tcpClient, tcpHandler, 2048, fbdo->session.resp_size, &payload, isOTA,
+                          fbdo->tcpClient.rxBuffer());
 
     firebase_fcs_file_list_item_t itm;
     int fileInfoStage = 0;
@@ -49,6 +49,12 @@ FirebaseJsonBase::FirebaseJsonBase()
 FirebaseJsonBase::~FirebaseJsonBase()
 {
     mClear();
+    if (reader)
+        delete reader;
+    reader = NULL;
+    if (arena)
+        delete arena;
+    arena = NULL;
 }
 
 FirebaseJsonBase &FirebaseJsonBase::mClear()
@@ -57,26 +63,49 @@ FirebaseJsonBase &FirebaseJsonBase::mClear()
     if (root != NULL)
         MB_JSON_Delete(root);
     root = NULL;
+    // the partial tree of Serial data may be in the arena
+    if (reader)
+        reader->clear();
+    // the tree items were freed (no-op for the arena blocks), give back the arena chunks
+    if (arena)
+        arena->reset();
     buf.clear();
     errorPos = -1;
     return *this;
 }
+
+void FirebaseJsonBase::mUseArena(size_t chunkSize, bool psram)
+{
+    mClear();
+    if (arena)
+        delete arena;
+    arena = chunkSize > 0 ? new FirebaseJsonArena(chunkSize, psram) : NULL;
+}
+void FirebaseJsonBase::mUseKeyPool(FirebaseJsonKeyPool *pool)
+{
+    // the key hook stays installed, it does nothing for the trees without pool
+    if (pool)
+        MB_JSON_InitKeyHook(fb_js_intern_key);
+    keyPool = pool;
+}
+
 void FirebaseJsonBase::mCopy(FirebaseJsonBase &other)
 {
     mClear();
+    FirebaseJsonArenaScope scope(arena, keyPool);
     this->root = MB_JSON_Duplicate(other.root, true);
     this->doubleDigits = other.doubleDigits;
     this->floatDigits = other.floatDigits;
     this->httpCode = other.httpCode;
     this->serData = other.serData;
     this->root_type = other.root_type;
-    this->iterator_data = other.iterator_data;
     this->buf = other.buf;
 }
 
 bool FirebaseJsonBase::setRaw(const char *raw)
 {
     mClear();
+    FirebaseJsonArenaScope scope(arena, keyPool);
 
     if (raw)
     {
@@ -103,6 +132,7 @@ bool FirebaseJsonBase::setRaw(const char *raw)
 
 MB_JSON *FirebaseJsonBase::parse(const char *raw)
 {
+    FirebaseJsonArenaScope scope(arena, keyPool);
     const char *s = NULL;
     MB_JSON *e = MB_JSON_ParseWithOpts(raw, &s, 1);
     errorPos = (s - raw != (int)strlen(raw)) ? s - raw : -1;
@@ -113,6 +143,7 @@ void FirebaseJsonBase::prepareRoot()
 {
     if (root == NULL)
     {
+        FirebaseJsonArenaScope scope(arena, keyPool);
         if (root_type == Root_Type_JSONArray)
             root = MB_JSON_CreateArray();
         else
@@ -120,13 +151,13 @@ void FirebaseJsonBase::prepareRoot()
     }
 }
 
-void FirebaseJsonBase::searchElements(MB_VECTOR<MB_String> &keys, MB_JSON *parent, struct search_result_t &r)
+void FirebaseJsonBase::searchElements(const FirebaseJsonPath &keys, MB_JSON *parent, struct search_result_t &r)
 {
     MB_JSON *e = parent;
     for (size_t i = 0; i < keys.size(); i++)
     {
         r.status = key_status_not_existed;
-        e = getElement(parent, keys[i].c_str(), r);
+        e = getElement(parent, keys, i, r);
         r.stopIndex = i;
         if (r.status != key_status_existed)
         {
@@ -140,11 +171,11 @@ void FirebaseJsonBase::searchElements(MB_VECTOR<MB_String> &keys, MB_JSON *paren
     }
 }
 
-MB_JSON *FirebaseJsonBase::getElement(MB_JSON *parent, const char *key, struct search_result_t &r)
+MB_JSON *FirebaseJsonBase::getElement(MB_JSON *parent, const FirebaseJsonPath &keys, size_t keyIndex, struct search_result_t &r)
 {
     MB_JSON *e = NULL;
-    bool isArrKey = isArrayKey(key);
-    int index = isArrKey ? getArrIndex(key) : -1;
+    bool isArrKey = keys.isIndex(keyIndex);
+    int index = keys.index(keyIndex);
     if ((isArray(parent) && !isArrKey) || (isObject(parent) && isArrKey))
         r.status = key_status_mistype;
     else if (isArray(parent) && isArrKey)
@@ -155,7 +186,7 @@ MB_JSON *FirebaseJsonBase::getElement(MB_JSON *parent, const char *key, struct s
     }
     else if (isObject(parent) && !isArrKey)
     {
-        e = MB_JSON_GetObjectItemCaseSensitive(parent, key);
+        e = MB_JSON_GetObjectItemCaseSensitive(parent, keys.key(keyIndex));
         if (e == NULL)
             r.status = key_status_not_existed;
     }
@@ -167,15 +198,15 @@ MB_JSON *FirebaseJsonBase::getElement(MB_JSON *parent, const char *key, struct s
     return e;
 }
 
-void FirebaseJsonBase::mAdd(MB_VECTOR<MB_String> keys, MB_JSON **parent, int beginIndex, MB_JSON *value)
+void FirebaseJsonBase::mAdd(const FirebaseJsonPath &keys, MB_JSON **parent, int beginIndex, MB_JSON *value)
 {
     MB_JSON *m_parent = *parent;
 
     for (size_t i = beginIndex; i < keys.size(); i++)
     {
-        bool isArrKey = isArrayKey(keys[i].c_str());
-        int index = isArrKey ? getArrIndex(keys[i].c_str()) : -1;
-        MB_JSON *e = (i < keys.size() - 1) ? (isArrayKey(keys[i + 1].c_str()) ? MB_JSON_CreateArray() : MB_JSON_CreateObject()) : value;
+        bool isArrKey = keys.isIndex(i);
+        int index = keys.index(i);
+        MB_JSON *e = (i < keys.size() - 1) ? (keys.isIndex(i + 1) ? MB_JSON_CreateArray() : MB_JSON_CreateObject()) : value;
 
         if (isArray(m_parent))
         {
@@ -198,7 +229,7 @@ void FirebaseJsonBase::mAdd(MB_VECTOR<MB_String> keys, MB_JSON **parent, int beg
             }
             else
             {
-                MB_JSON_AddItemToObject(m_parent, keys[i].c_str(), e);
+                MB_JSON_AddItemToObject(m_parent, keys.key(i), e);
                 m_parent = e;
             }
         }
@@ -258,18 +289,18 @@ MB_JSON *FirebaseJsonBase::addArray(MB_JSON *parent, MB_JSON *e, size_t size)
     return e;
 }
 
-void FirebaseJsonBase::appendArray(MB_VECTOR<MB_String> &keys, struct search_result_t &r, MB_JSON *parent, MB_JSON *value)
+void FirebaseJsonBase::appendArray(const FirebaseJsonPath &keys, struct search_result_t &r, MB_JSON *parent, MB_JSON *value)
 {
     MB_JSON *item = NULL;
 
-    int index = getArrIndex(keys[r.stopIndex].c_str());
+    int index = keys.index(r.stopIndex);
 
     if (r.foundIndex > -1)
     {
         if (isArray(parent))
-            parent = MB_JSON_GetArrayItem(parent, getArrIndex(keys[r.foundIndex].c_str()));
+            parent = MB_JSON_GetArrayItem(parent, keys.index(r.foundIndex));
         else
-            parent = MB_JSON_GetObjectItemCaseSensitive(parent, keys[r.foundIndex].c_str());
+            parent = MB_JSON_GetObjectItemCaseSensitive(parent, keys.key(r.foundIndex));
     }
 
     if (isArray(parent))
@@ -278,7 +309,7 @@ void FirebaseJsonBase::appendArray(MB_VECTOR<MB_String> &keys, struct search_res
 
         if (r.stopIndex < (int)keys.size() - 1)
         {
-            item = isArrayKey(keys[r.stopIndex + 1].c_str()) ? MB_JSON_CreateArray() : MB_JSON_CreateObject();
+            item = keys.isIndex(r.stopIndex + 1) ? MB_JSON_CreateArray() : MB_JSON_CreateObject();
             mAdd(keys, &item, r.stopIndex + 1, value);
         }
         else
@@ -293,7 +324,7 @@ void FirebaseJsonBase::appendArray(MB_VECTOR<MB_String> &keys, struct search_res
         MB_JSON_Delete(value);
 }
 
-void FirebaseJsonBase::replaceItem(MB_VECTOR<MB_String> &keys, struct search_result_t &r, MB_JSON *parent, MB_JSON *value)
+void FirebaseJsonBase::replaceItem(const FirebaseJsonPath &keys, struct search_result_t &r, MB_JSON *parent, MB_JSON *value)
 {
     if (r.foundIndex == -1)
     {
@@ -310,9 +341,9 @@ void FirebaseJsonBase::replaceItem(MB_VECTOR<MB_String> &keys, struct search_res
     }
     else
     {
-        if (r.status == key_status_not_existed && !isArrayKey(keys[r.stopIndex].c_str()))
+        if (r.status == key_status_not_existed && !keys.isIndex(r.stopIndex))
         {
-            MB_JSON *curItem = isArray(parent) ? MB_JSON_GetArrayItem(parent, getArrIndex(keys[r.foundIndex].c_str())) : MB_JSON_GetObjectItem(parent, keys[r.foundIndex].c_str());
+            MB_JSON *curItem = isArray(parent) ? MB_JSON_GetArrayItem(parent, keys.index(r.foundIndex)) : MB_JSON_GetObjectItem(parent, keys.key(r.foundIndex));
             if (isObject(curItem))
             {
                 mAdd(keys, &curItem, r.foundIndex + 1, value);
@@ -324,7 +355,7 @@ void FirebaseJsonBase::replaceItem(MB_VECTOR<MB_String> &keys, struct search_res
 
         if ((r.status == key_status_mistype ? r.stopIndex : r.foundIndex) < (int)keys.size() - 1)
         {
-            item = isArrayKey(keys[r.stopIndex].c_str()) ? MB_JSON_CreateArray() : MB_JSON_CreateObject();
+            item = keys.isIndex(r.stopIndex) ? MB_JSON_CreateArray() : MB_JSON_CreateObject();
             mAdd(keys, &item, r.stopIndex, value);
         }
         else
@@ -334,24 +365,21 @@ void FirebaseJsonBase::replaceItem(MB_VECTOR<MB_String> &keys, struct search_res
     }
 }
 
-void FirebaseJsonBase::replace(MB_VECTOR<MB_String> &keys, struct search_result_t &r, MB_JSON *parent, MB_JSON *item)
+void FirebaseJsonBase::replace(const FirebaseJsonPath &keys, struct search_result_t &r, MB_JSON *parent, MB_JSON *item)
 {
     if (isArray(parent))
-        MB_JSON_ReplaceItemInArray(parent, getArrIndex(keys[r.foundIndex].c_str()), item);
+        MB_JSON_ReplaceItemInArray(parent, keys.index(r.foundIndex), item);
     else
-        MB_JSON_ReplaceItemInObject(parent, keys[r.foundIndex].c_str(), item);
+        MB_JSON_ReplaceItemInObject(parent, keys.key(r.foundIndex), item);
 }
 
 size_t FirebaseJsonBase::mIteratorBegin(MB_JSON *parent)
 {
     mIteratorEnd();
-    char *p = MB_JSON_PrintUnformatted(parent);
-    if (p == NULL)
+    if (parent == NULL)
         return 0;
 
-    buf = p;
-    MB_JSON_free(p);
-    iterator_data.buf_size = buf.length();
+    // only the tree items are collected, the keys and values are read from the tree on demand
     int index = -1;
     mIterate(parent, index);
     return iterator_data.result.size();
@@ -375,8 +403,6 @@ void FirebaseJsonBase::mIteratorEnd(bool clearBuf)
     if (clearBuf)
         buf.clear();
     iterator_data.path.clear();
-    iterator_data.buf_size = 0;
-    iterator_data.buf_offset = 0;
     iterator_data.result.clear();
     iterator_data.depth = -1;
     iterator_data._depth = 0;
@@ -441,34 +467,7 @@ void FirebaseJsonBase::mIterate(MB_JSON *parent, int &arrIndex)
 void FirebaseJsonBase::mCollectIterator(MB_JSON *e, int type, int &arrIndex)
 {
     struct iterator_result_t result;
-
-    if (e->string)
-    {
-        size_t pos = buf.find((const char *)e->string, iterator_data.buf_offset);
-        if (pos != MB_String::npos)
-        {
-            result.ofs1 = pos;
-            result.len1 = strlen(e->string);
-            iterator_data.buf_offset = (e->type != MB_JSON_Object && e->type != MB_JSON_Array) ? pos + result.len1 : pos;
-        }
-    }
-
-    char *p = MB_JSON_PrintUnformatted(e);
-    if (p)
-    {
-        if (result.ofs1 == 0)
-            result.ofs1 = iterator_data.buf_offset;
-
-        int i = iterator_data.buf_offset;
-        size_t pos = buf.find(p, i);
-        if (pos != MB_String::npos)
-        {
-            result.ofs2 = pos - result.ofs1 - result.len1;
-            result.len2 = strlen(p);
-            MB_JSON_free(p);
-            iterator_data.buf_offset = (e->type != MB_JSON_Object && e->type != MB_JSON_Array) ? pos + result.len2 : pos;
-        }
-    }
+    result.item = e;
     result.type = type;
     result.depth = iterator_data.depth;
     iterator_data.result.push_back(result);
@@ -480,45 +479,23 @@ int FirebaseJsonBase::mIteratorGet(size_t index, int &type, String &key, String
     value.remove(0, value.length());
     int depth = -1;
 
-    if (buf.length() == iterator_data.buf_size)
-    {
-        if (index > iterator_data.result.size() - 1)
-            return depth;
+    if (index >= iterator_data.result.size())
+        return depth;
 
-        if (iterator_data.result[index].len1 > 0)
-        {
-            char *m_key = (char *)newP(iterator_data.result[index].len1 + 1);
-            if (m_key)
-            {
-                memset(m_key, 0, iterator_data.result[index].len1 + 1);
-                strncpy(m_key, &buf[iterator_data.result[index].ofs1], iterator_data.result[index].len1);
-                key = m_key;
-                delP(&m_key);
-            }
-        }
-
-        char *m_val = (char *)newP(iterator_data.result[index].len2 + 1);
-        if (m_val)
-        {
-            memset(m_val, 0, iterator_data.result[index].len2 + 1);
-            int ofs = iterator_data.result[index].ofs1 + iterator_data.result[index].len1 + iterator_data.result[index].ofs2;
-            int len = iterator_data.result[index].len2;
+    MB_JSON *e = iterator_data.result[index].item;
 
-            if (iterator_data.result[index].type == JSON_STRING)
-            {
-                if (buf[ofs] == '"')
-                    ofs++;
-                if (buf[ofs + len - 1] == '"')
-                    len--;
-            }
+    if (e->string)
+        key = e->string;
 
-            strncpy(m_val, &buf[ofs], len);
-            value = m_val;
-            delP(&m_val);
-        }
-        type = iterator_data.result[index].type;
-        depth = iterator_data.result[index].depth;
+    char *p = MB_JSON_PrintUnformatted(e);
+    if (p)
+    {
+        value = p;
+        MB_JSON_free(p);
     }
+
+    type = iterator_data.result[index].type;
+    depth = iterator_data.result[index].depth;
     return depth;
 }
 
@@ -543,31 +520,181 @@ void FirebaseJsonBase::toBuf(fb_json_serialize_mode mode)
     }
 }
 
+bool FirebaseJsonBase::parsePayload(void *ctx, const char *data, size_t len)
+{
+    FirebaseJsonStreamParser *parser = reinterpret_cast<FirebaseJsonStreamParser *>(ctx);
+    parser->feed(data, len);
+    // no need to read the rest of malformed payload
+    return !parser->failed();
+}
+
 bool FirebaseJsonBase::mReadClient(Client *client)
 {
-    // blocking read
+    // blocking read, the tree is built while the payload arrives
+    FirebaseJsonArenaScope scope(arena, keyPool);
+    FirebaseJsonStreamParser parser;
     buf.clear();
-    if (readClient(client, buf))
+    if (readClient(client, buf, parsePayload, &parser))
     {
+        mIteratorEnd(false);
         if (root != NULL)
             MB_JSON_Delete(root);
-        root = parse(buf.c_str());
-        buf.clear();
+        root = parser.finish() ? parser.release() : NULL;
+        errorPos = root ? -1 : (int)parser.position();
         return root != NULL;
     }
     return false;
 }
 
+struct fb_js_extract_ctx_t
+{
+    FirebaseJsonBase *json;
+    FirebaseJsonExtractor *extractor;
+    const char *const *paths;
+};
+
+bool FirebaseJsonBase::extractPayload(void *ctx, const char *data, size_t len)
+{
+    fb_js_extract_ctx_t *c = reinterpret_cast<fb_js_extract_ctx_t *>(ctx);
+    bool ret = c->extractor->feed(data, len, [c](size_t i, const char *value, size_t valueLen, FirebaseJsonExtractor::value_type type)
+                                  { c->json->mSetExtracted(c->paths[i], value, valueLen, type); });
+    // stop reading when all values were found
+    return ret && !c->extractor->done();
+}
+
+void FirebaseJsonBase::mSetExtracted(const char *path, const char *value, size_t len, uint8_t type)
+{
+    FirebaseJsonArenaScope scope(arena, keyPool);
+    MB_JSON *e = NULL;
+    if (type == FirebaseJsonExtractor::EXTRACT_STRING)
+    {
+        // the value is without the quotes, let MB_JSON unescape the quoted text
+        char *s = (char *)newP(len + 3);
+        if (!s)
+            return;
+        s[0] = '"';
+        memcpy(s + 1, value, len);
+        s[len + 1] = '"';
+        e = MB_JSON_ParseWithLength(s, len + 2);
+        delP(&s);
+    }
+    else
+        e = MB_JSON_ParseWithLength(value, len);
+
+    if (e)
+        mSet(path, e);
+}
+
+bool FirebaseJsonBase::mReadClient(Client *client, const char *const *paths, size_t count)
+{
+    FirebaseJsonExtractor extractor;
+    if (!paths || !extractor.begin(paths, count))
+        return false;
+
+    mClear();
+    fb_js_extract_ctx_t ctx = {this, &extractor, paths};
+    readClient(client, buf, extractPayload, &ctx);
+    extractor.finish([&ctx](size_t i, const char *value, size_t valueLen, FirebaseJsonExtractor::value_type type)
+                     { ctx.json->mSetExtracted(ctx.paths[i], value, valueLen, type); });
+    return extractor.done();
+}
+
+bool FirebaseJsonBase::mReadStream(Stream *s, const char *const *paths, size_t count)
+{
+    FirebaseJsonExtractor extractor;
+    if (!paths || !extractor.begin(paths, count))
+        return false;
+
+    mClear();
+    fb_js_extract_ctx_t ctx = {this, &extractor, paths};
+    char chunk[64];
+    size_t len = 0;
+    bool more = true;
+    // the bytes are read only until the last value was found
+    while (more && s->available())
+    {
+        idle();
+        int r = s->read();
+        if (r < 0)
+            continue;
+        chunk[len++] = (char)r;
+        // the value ends with this byte
+        if (len == sizeof(chunk) || r == '}' || r == ']' || r == ',' || r == '"')
+        {
+            more = extractPayload(&ctx, chunk, len);
+            len = 0;
+        }
+    }
+
+    if (more && len > 0)
+        extractPayload(&ctx, chunk, len);
+
+    extractor.finish([&ctx](size_t i, const char *value, size_t valueLen, FirebaseJsonExtractor::value_type type)
+                     { ctx.json->mSetExtracted(ctx.paths[i], value, valueLen, type); });
+    return extractor.done();
+}
+
+bool FirebaseJsonBase::mBeginRead(int timeoutMS)
+{
+    if (!reader)
+        reader = new FirebaseJsonStreamParser();
+
+    if (!reader)
+        return false;
+
+    // the data that was not completed in time is dropped
+    if (timeoutMS == -1 || millis() - serData.dataTime > (unsigned long)timeoutMS)
+        mRestartRead();
+
+    return true;
+}
+
+void FirebaseJsonBase::mRestartRead()
+{
+    reader->begin(root_type == Root_Type_JSONArray ? '[' : '{');
+    serData.dataTime = millis();
+}
+
+bool FirebaseJsonBase::mReadByte(int r)
+{
+    if (r < 0)
+        return false;
+
+    char c = (char)r;
+    reader->feed(&c, 1);
+
+    if (reader->failed())
+    {
+        // drop the malformed data, this byte may begin the next one
+        mRestartRead();
+        reader->feed(&c, 1);
+        return false;
+    }
+
+    if (!reader->done())
+        return false;
+
+    mIteratorEnd(false);
+    if (root != NULL)
+        MB_JSON_Delete(root);
+    root = reader->release();
+    errorPos = -1;
+    mRestartRead();
+    return true;
+}
+
 bool FirebaseJsonBase::mReadStream(Stream *s, int timeoutMS)
 {
-    // non-blocking read
-    if (readStream(s, serData, buf, true, timeoutMS))
+    // non-blocking read, the tree is built while the data arrives
+    FirebaseJsonArenaScope scope(arena, keyPool);
+    if (!mBeginRead(timeoutMS))
+        return false;
+
+    while (s->available())
     {
-        if (root != NULL)
-            MB_JSON_Delete(root);
-        root = parse(buf.c_str());
-        buf.clear();
-        return root != NULL;
+        idle();
+        if (mReadByte(s->read()))
+            return true;
     }
     return false;
 }
@@ -576,13 +703,15 @@ bool FirebaseJsonBase::mReadStream(Stream *s, int timeoutMS)
 bool FirebaseJsonBase::mReadSdFat(SD_FAT_FILE &file, int timeoutMS)
 {
     // non-blocking read
-    if (readSdFatFile(file, serData, buf, true, timeoutMS))
+    FirebaseJsonArenaScope scope(arena, keyPool);
+    if (!mBeginRead(timeoutMS))
+        return false;
+
+    while (file.available())
     {
-        if (root != NULL)
-            MB_JSON_Delete(root);
-        root = parse(buf.c_str());
-        buf.clear();
-        return root != NULL;
+        idle();
+        if (mReadByte(file.read()))
+            return true;
     }
     return false;
 }
@@ -595,19 +724,21 @@ const char *FirebaseJsonBase::mRaw()
 }
 
 bool FirebaseJsonBase::mRemove(const char *path)
+{
+    FirebaseJsonPathRef ref(path);
+    return ref.get() ? mRemove(*ref.get()) : false;
+}
+
+bool FirebaseJsonBase::mRemove(const FirebaseJsonPath &keys)
 {
     bool ret = false;
+    mIteratorEnd(false);
     prepareRoot();
-    MB_VECTOR<MB_String> keys = MB_VECTOR<MB_String>();
-    makeList(path, keys, '/');
 
     if (keys.size() > 0)
     {
-        if (isArrayKey(keys[0].c_str()) && root_type == Root_Type_JSON)
-        {
-            clearList(keys);
+        if (keys.isIndex(0) && root_type == Root_Type_JSON)
             return false;
-        }
     }
 
     MB_JSON *parent = root;
@@ -620,38 +751,22 @@ bool FirebaseJsonBase::mRemove(const char *path)
     {
         ret = true;
         if (isArray(parent))
-            MB_JSON_DeleteItemFromArray(parent, getArrIndex(keys[r.stopIndex].c_str()));
+            MB_JSON_DeleteItemFromArray(parent, keys.index(r.stopIndex));
         else
         {
-            MB_JSON_DeleteItemFromObjectCaseSensitive(parent, keys[r.stopIndex].c_str());
+            MB_JSON_DeleteItemFromObjectCaseSensitive(parent, keys.key(r.stopIndex));
             if (parent->child == NULL && r.stopIndex > 0)
             {
-                MB_String path;
-                mGetPath(path, keys, 0, r.stopIndex - 1);
-                mRemove(path.c_str());
+                // remove the empty parent
+                FirebaseJsonPath parentPath(keys, r.stopIndex);
+                mRemove(parentPath);
             }
         }
     }
 
-    clearList(keys);
     return ret;
 }
 
-void FirebaseJsonBase::mGetPath(MB_String &path, MB_VECTOR<MB_String> paths, int begin, int end)
-{
-    if (end < 0 || end >= (int)paths.size())
-        end = paths.size() - 1;
-    if (begin < 0 || begin > end)
-        begin = 0;
-
-    for (int i = begin; i <= end; i++)
-    {
-        if (i > 0)
-            path += (const char *)MBSTRING_FLASH_MCR("/");
-        path += paths[i].c_str();
-    }
-}
-
 size_t FirebaseJsonBase::mGetSerializedBufferLength(bool prettify)
 {
     if (!root)
@@ -659,6 +774,38 @@ size_t FirebaseJsonBase::mGetSerializedBufferLength(bool prettify)
     return MB_JSON_SerializedBufferLength(root, prettify);
 }
 
+bool FirebaseJsonBase::mWriteTo(MB_JSON_write_fn write, void *ctx, bool prettify)
+{
+    if (!root)
+        return false;
+    return MB_JSON_PrintStream(root, prettify, FIREBASE_JSON_STREAM_WINDOW, write, ctx);
+}
+
+bool FirebaseJsonBase::mWriteTo(Print *out, bool prettify)
+{
+    return out ? mWriteTo(printWrite, out, prettify) : false;
+}
+
+size_t FirebaseJsonBase::printWrite(void *ctx, const unsigned char *data, size_t len)
+{
+    return reinterpret_cast<Print *>(ctx)->write(data, len);
+}
+
+bool FirebaseJsonBase::mHasKey(MB_JSON *e, const char *key)
+{
+    if (!key)
+        return false;
+
+    for (MB_JSON *c = e ? e->child : NULL; c; c = c->next)
+    {
+        if (c->string && (c->string == key || strcmp(c->string, key) == 0))
+            return true;
+        if (c->child && mHasKey(c, key))
+            return true;
+    }
+    return false;
+}
+
 void FirebaseJsonBase::mSetFloatDigits(uint8_t digits)
 {
     floatDigits = digits;
@@ -675,19 +822,20 @@ int FirebaseJsonBase::mResponseCode()
 }
 
 bool FirebaseJsonBase::mGet(MB_JSON *parent, FirebaseJsonData *result, const char *path, bool prettify)
+{
+    FirebaseJsonPathRef ref(path);
+    return ref.get() ? mGet(parent, result, *ref.get(), prettify) : false;
+}
+
+bool FirebaseJsonBase::mGet(MB_JSON *parent, FirebaseJsonData *result, const FirebaseJsonPath &keys, bool prettify)
 {
     bool ret = false;
     prepareRoot();
-    MB_VECTOR<MB_String> keys = MB_VECTOR<MB_String>();
-    makeList(path, keys, '/');
 
     if (keys.size() > 0)
     {
-        if (isArrayKey(keys[0].c_str()) && root_type == Root_Type_JSON)
-        {
-            clearList(keys);
+        if (keys.isIndex(0) && root_type == Root_Type_JSON)
             return false;
-        }
     }
 
     MB_JSON *_parent = parent;
@@ -699,28 +847,107 @@ bool FirebaseJsonBase::mGet(MB_JSON *parent, FirebaseJsonData *result, const cha
     {
         MB_JSON *data = NULL;
         if (isArray(_parent))
-            data = MB_JSON_GetArrayItem(_parent, getArrIndex(keys[r.stopIndex].c_str()));
+            data = MB_JSON_GetArrayItem(_parent, keys.index(r.stopIndex));
         else
-            data = MB_JSON_GetObjectItemCaseSensitive(_parent, keys[r.stopIndex].c_str());
+            data = MB_JSON_GetObjectItemCaseSensitive(_parent, keys.key(r.stopIndex));
 
         if (data != NULL)
         {
-            if (result != NULL)
+            mSetResult(data, result, prettify);
+            ret = true;
+        }
+    }
+
+    return ret;
+}
+
+bool FirebaseJsonBase::mGet(FirebaseJsonData *result, const FirebaseJsonEntry &entry, bool prettify)
+{
+    if (!entry.item)
+        return false;
+    mSetResult(entry.item, result, prettify);
+    return true;
+}
+
+void FirebaseJsonBase::mSetResult(MB_JSON *data, FirebaseJsonData *result, bool prettify)
+{
+    if (result == NULL)
+        return;
+
+    result->clear();
+    char *p = prettify ? MB_JSON_Print(data) : MB_JSON_PrintUnformatted(data);
+    result->stringValue = p;
+    MB_JSON_free(p);
+    result->type_num = data->type;
+    result->success = true;
+    mSetElementType(result);
+}
+
+bool FirebaseJsonBase::mExtract(FirebaseJsonData *result, const char *raw, size_t len, const char *path)
+{
+    FirebaseJsonExtractor extractor;
+    if (!result || !raw || !extractor.begin(&path, 1))
+        return false;
+
+    result->clear();
+
+    auto handler = [this, result](size_t, const char *value, size_t valueLen, FirebaseJsonExtractor::value_type type)
+    {
+        // the escaped string span is parsed as the tree does, then printed as get() prints the string item
+        if (type == FirebaseJsonExtractor::EXTRACT_STRING && memchr(value, '\\', valueLen))
+        {
+            char *s = (char *)newP(valueLen + 3);
+            if (!s)
+                return;
+            s[0] = '"';
+            memcpy(s + 1, value, valueLen);
+            s[valueLen + 1] = '"';
+            FirebaseJsonArenaScope scope(arena, keyPool);
+            MB_JSON *e = MB_JSON_ParseWithLength(s, valueLen + 2);
+            delP(&s);
+            if (e)
             {
-                result->clear();
-                char *p = prettify ? MB_JSON_Print(data) : MB_JSON_PrintUnformatted(data);
+                char *p = MB_JSON_PrintUnformatted(e);
                 result->stringValue = p;
                 MB_JSON_free(p);
-                result->type_num = data->type;
+                MB_JSON_Delete(e);
+                result->type_num = MB_JSON_String;
                 result->success = true;
-                mSetElementType(result);
             }
-            ret = true;
+            return;
         }
-    }
 
-    clearList(keys);
-    return ret;
+        char *buf = (char *)newP(valueLen + 1);
+        if (!buf)
+            return;
+        memcpy(buf, value, valueLen);
+        buf[valueLen] = 0;
+        result->stringValue = buf;
+        delP(&buf);
+
+        if (type == FirebaseJsonExtractor::EXTRACT_OBJECT)
+            result->type_num = MB_JSON_Object;
+        else if (type == FirebaseJsonExtractor::EXTRACT_ARRAY)
+            result->type_num = MB_JSON_Array;
+        else if (type == FirebaseJsonExtractor::EXTRACT_STRING)
+            result->type_num = MB_JSON_String;
+        else if (type == FirebaseJsonExtractor::EXTRACT_BOOL)
+            result->type_num = value[0] == 't' ? MB_JSON_True : MB_JSON_False;
+        else if (type == FirebaseJsonExtractor::EXTRACT_NULL)
+            result->type_num = MB_JSON_NULL;
+        else
+            result->type_num = MB_JSON_Number;
+
+        result->success = true;
+    };
+
+    extractor.feed(raw, len, handler);
+    extractor.finish(handler);
+
+    if (result->success)
+        mSetElementType(result);
+
+    return result->success;
 }
 
 void FirebaseJsonBase::mSetResInt(FirebaseJsonData *data, const char *value)
@@ -840,16 +1067,25 @@ void FirebaseJsonBase::mSetElementType(FirebaseJsonData *result)
 
 void FirebaseJsonBase::mSet(const char *path, MB_JSON *value)
 {
+    FirebaseJsonPathRef ref(path);
+    if (ref.get())
+        mSet(*ref.get(), value);
+    else
+        MB_JSON_Delete(value);
+}
+
+void FirebaseJsonBase::mSet(const FirebaseJsonPath &keys, MB_JSON *value)
+{
+    // the collected iterator items may be replaced
+    mIteratorEnd(false);
+    FirebaseJsonArenaScope scope(arena, keyPool);
     prepareRoot();
-    MB_VECTOR<MB_String> keys = MB_VECTOR<MB_String>();
-    makeList(path, keys, '/');
 
     if (keys.size() > 0)
     {
-        if ((isArrayKey(keys[0].c_str()) && root_type == Root_Type_JSON) || (!isArrayKey(keys[0].c_str()) && root_type == Root_Type_JSONArray))
+        if ((keys.isIndex(0) && root_type == Root_Type_JSON) || (!keys.isIndex(0) && root_type == Root_Type_JSONArray))
         {
             MB_JSON_Delete(value);
-            clearList(keys);
             return;
         }
     }
@@ -870,8 +1106,6 @@ void FirebaseJsonBase::mSet(const char *path, MB_JSON *value)
         replace(keys, r, parent, value);
     else
         MB_JSON_Delete(value);
-
-    clearList(keys);
 }
 
 #if defined(__AVR__)
@@ -906,23 +1140,21 @@ FirebaseJson::~FirebaseJson()
 
 FirebaseJson &FirebaseJson::nAdd(const char *key, MB_JSON *value)
 {
+    FirebaseJsonArenaScope scope(arena, keyPool);
     prepareRoot();
-    MB_VECTOR<MB_String> keys = MB_VECTOR<MB_String>();
-    // makeList(key, keys, '/');
-    MB_String ky = key;
-    keys.push_back(ky);
+    // the key is not split into the path
+    FirebaseJsonPath keys;
+    keys.compile(key, false);
 
     if (value == NULL)
         value = MB_JSON_CreateNull();
 
     if (keys.size() > 0)
     {
-        if (!isArrayKey(keys[0].c_str()) || root_type == Root_Type_JSONArray)
+        if (!keys.isIndex(0) || root_type == Root_Type_JSONArray)
             mAdd(keys, &root, 0, value);
     }
 
-    clearList(keys);
-
     return *this;
 }
 
@@ -957,6 +1189,7 @@ FirebaseJsonArray &FirebaseJsonArray::nAdd(MB_JSON *value)
 
     root_type = Root_Type_JSONArray;
 
+    FirebaseJsonArenaScope scope(arena, keyPool);
     prepareRoot();
 
     if (value == NULL)
@@ -998,6 +1231,8 @@ bool FirebaseJsonArray::mSetIdx(int index, MB_JSON *value)
 
     root_type = Root_Type_JSONArray;
 
+    mIteratorEnd(false);
+    FirebaseJsonArenaScope scope(arena, keyPool);
     prepareRoot();
 
     int size = MB_JSON_GetArraySize(root);
@@ -1017,6 +1252,7 @@ bool FirebaseJsonArray::mSetIdx(int index, MB_JSON *value)
 
 bool FirebaseJsonArray::mRemoveIdx(int index)
 {
+    mIteratorEnd(false);
     int size = MB_JSON_GetArraySize(root);
     if (index < size)
     {
@@ -1034,6 +1270,7 @@ FirebaseJsonArray &FirebaseJsonArray::clear()
 
 FirebaseJsonArray &FirebaseJsonArray::add(FirebaseJson &value)
 {
+    FirebaseJsonArenaScope scope(arena, keyPool);
     MB_JSON *e = MB_JSON_Duplicate(value.root, true);
     nAdd(e);
     return *this;
@@ -1041,6 +1278,7 @@ FirebaseJsonArray &FirebaseJsonArray::add(FirebaseJson &value)
 
 FirebaseJsonArray &FirebaseJsonArray::add(FirebaseJsonArray &value)
 {
+    FirebaseJsonArenaScope scope(arena, keyPool);
     MB_JSON *e = MB_JSON_Duplicate(value.root, true);
     nAdd(e);
     return *this;
@@ -1065,6 +1303,7 @@ bool FirebaseJsonData::getArray(FirebaseJsonArray &jsonArray)
 bool FirebaseJsonData::mGetArray(const char *source, FirebaseJsonArray &jsonArray)
 {
 
+    jsonArray.mIteratorEnd(false);
     if (jsonArray.root != NULL)
         MB_JSON_Delete(jsonArray.root);
 
@@ -1082,6 +1321,7 @@ bool FirebaseJsonData::getJSON(FirebaseJson &json)
 
 bool FirebaseJsonData::mGetJSON(const char *source, FirebaseJson &json)
 {
+    json.mIteratorEnd(false);
     if (json.root != NULL)
         MB_JSON_Delete(json.root);
 
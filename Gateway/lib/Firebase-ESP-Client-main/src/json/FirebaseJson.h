@@ -110,6 +110,10 @@
 
 #include <stdio.h>
 #include "MB_List.h"
+#include "FirebaseJsonExtractor.h"
+#include "FirebaseJsonArena.h"
+#include "FirebaseJsonPath.h"
+#include "FirebaseJsonStreamParser.h"
 
 #if !defined(__AVR__)
 #include <memory>
@@ -149,6 +153,16 @@ extern "C"
 
 #define MB_SERIAL_CLASS decltype(Serial)
 
+// The size of window in bytes that the serialized JSON is written through to Serial, Stream, File and Client.
+#if !defined(FIREBASE_JSON_STREAM_WINDOW)
+#define FIREBASE_JSON_STREAM_WINDOW 512
+#endif
+
+// The deepest level that FirebaseJsonCursor descends into, the deeper nodes are skipped (see truncated()).
+#if !defined(FIREBASE_JSON_CURSOR_DEPTH)
+#define FIREBASE_JSON_CURSOR_DEPTH 16
+#endif
+
 #ifdef Serial_Printf
 #undef Serial_Printf
 #endif
@@ -203,6 +217,8 @@ static const char fb_json_str_9[] PROGMEM = "Location: ";
 class FirebaseJson;
 class FirebaseJsonArray;
 class FirebaseJsonData;
+class FirebaseJsonCursor;
+struct FirebaseJsonEntry;
 
 static size_t getReservedLen(size_t len)
 {
@@ -219,6 +235,14 @@ static size_t getReservedLen(size_t len)
 static void *fb_js_malloc(size_t len)
 {
     void *p;
+
+    if (FirebaseJsonArena::current())
+    {
+        p = FirebaseJsonArena::current()->allocate(len);
+        if (p)
+            return p;
+    }
+
     size_t newLen = getReservedLen(len);
 
 #if defined(BOARD_HAS_PSRAM) && defined(MB_STRING_USE_PSRAM)
@@ -249,12 +273,24 @@ static void *fb_js_malloc(size_t len)
 
 static void fb_js_free(void *ptr)
 {
-    if (ptr)
+    // the arena blocks are freed with the arena
+    if (ptr && !FirebaseJsonArena::owned(ptr))
         free(ptr);
 }
 
 static void *fb_js_realloc(void *ptr, size_t sz)
 {
+    if (ptr && FirebaseJsonArena::owned(ptr))
+    {
+        void *p = fb_js_malloc(sz);
+        if (p)
+        {
+            size_t n = FirebaseJsonArena::blockSize(ptr);
+            memcpy(p, ptr, n < sz ? n : sz);
+        }
+        return p;
+    }
+
     size_t newLen = getReservedLen(sz);
 #if defined(BOARD_HAS_PSRAM) && defined(MB_STRING_USE_PSRAM)
     if (ESP.getPsramSize() > 0)
@@ -282,6 +318,12 @@ static void *fb_js_realloc(void *ptr, size_t sz)
 
 static MB_JSON_Hooks MB_JSON_hooks __attribute__((used)) = {fb_js_malloc, fb_js_free, fb_js_realloc};
 
+static const char *fb_js_intern_key(const char *key, size_t len)
+{
+    FirebaseJsonKeyPool *pool = FirebaseJsonKeyPool::current();
+    return pool ? pool->intern(key, len) : NULL;
+}
+
 namespace fb_js
 {
 
@@ -309,11 +351,12 @@ namespace fb_js
 
     struct serial_data_t
     {
-        int pos = -1, start = -1, end = -1;
-        int scnt = 0, ecnt = 0;
-        MB_String buf;
+        // the time that the current JSON text was begun to read
         unsigned long dataTime = 0;
     };
+
+    // The payload consumer of readClient, returns false to stop reading.
+    typedef bool (*payload_fn)(void *ctx, const char *data, size_t len);
 };
 
 class FirebaseJsonData
@@ -584,10 +627,7 @@ private:
 
     struct iterator_result_t
     {
-        uint16_t ofs1 = 0;
-        uint8_t len1 = 0;
-        uint8_t ofs2 = 0;
-        uint16_t len2 = 0;
+        MB_JSON *item = NULL;
         uint8_t type = 0;
         int16_t depth = -1;
     };
@@ -595,8 +635,6 @@ private:
     struct iterator_data_t
     {
         MB_VECTOR<struct iterator_result_t> result;
-        int buf_offset = 0;
-        size_t buf_size = 0;
         int depth = -1;
         int _depth = 0;
         MB_JSON *parent = NULL;
@@ -617,18 +655,18 @@ private:
     bool setRaw(const char *raw);
     void prepareRoot();
     MB_JSON *parse(const char *raw);
-    void searchElements(MB_VECTOR<MB_String> &keys, MB_JSON *parent, struct search_result_t &r);
-    MB_JSON *getElement(MB_JSON *parent, const char *key, struct search_result_t &r);
-    void mAdd(MB_VECTOR<MB_String> keys, MB_JSON **parent, int beginIndex, MB_JSON *value);
+    void searchElements(const FirebaseJsonPath &keys, MB_JSON *parent, struct search_result_t &r);
+    MB_JSON *getElement(MB_JSON *parent, const FirebaseJsonPath &keys, size_t keyIndex, struct search_result_t &r);
+    void mAdd(const FirebaseJsonPath &keys, MB_JSON **parent, int beginIndex, MB_JSON *value);
     void makeList(const MB_String &str, MB_VECTOR<MB_String> &keys, char delim);
     void pushLish(const MB_String &str, MB_VECTOR<MB_String> &keys);
     void clearList(MB_VECTOR<MB_String> &keys);
     bool isArray(MB_JSON *e);
     bool isObject(MB_JSON *e);
     MB_JSON *addArray(MB_JSON *parent, MB_JSON *e, size_t size);
-    void appendArray(MB_VECTOR<MB_String> &keys, struct search_result_t &r, MB_JSON *parent, MB_JSON *value);
-    void replaceItem(MB_VECTOR<MB_String> &keys, struct search_result_t &r, MB_JSON *parent, MB_JSON *value);
-    void replace(MB_VECTOR<MB_String> &keys, struct search_result_t &r, MB_JSON *parent, MB_JSON *item);
+    void appendArray(const FirebaseJsonPath &keys, struct search_result_t &r, MB_JSON *parent, MB_JSON *value);
+    void replaceItem(const FirebaseJsonPath &keys, struct search_result_t &r, MB_JSON *parent, MB_JSON *value);
+    void replace(const FirebaseJsonPath &keys, struct search_result_t &r, MB_JSON *parent, MB_JSON *item);
     size_t mIteratorBegin(MB_JSON *parent);
     size_t mIteratorBegin(MB_JSON *parent, MB_VECTOR<MB_String> *keys);
     void mCollectIterator(MB_JSON *e, int type, int &arrIndex);
@@ -637,23 +675,42 @@ private:
     struct fb_js_iterator_value_t mValueAt(size_t index);
     void toBuf(fb_json_serialize_mode mode);
     bool mReadClient(Client *client);
+    bool mReadClient(Client *client, const char *const *paths, size_t count);
     bool mReadStream(Stream *s, int timeoutMS);
+    bool mReadStream(Stream *s, const char *const *paths, size_t count);
 #if defined(ESP32_SD_FAT_INCLUDED)
     bool mReadSdFat(SD_FAT_FILE &file, int timeoutMS);
 #endif
+    bool mBeginRead(int timeoutMS);
+    void mRestartRead();
+    bool mReadByte(int r);
+    void mSetExtracted(const char *path, const char *value, size_t len, uint8_t type);
+    static bool parsePayload(void *ctx, const char *data, size_t len);
+    static bool extractPayload(void *ctx, const char *data, size_t len);
     const char *mRaw();
     bool mRemove(const char *path);
-    void mGetPath(MB_String &path, MB_VECTOR<MB_String> paths, int begin = 0, int end = -1);
+    bool mRemove(const FirebaseJsonPath &keys);
     size_t mGetSerializedBufferLength(bool prettify);
+    bool mWriteTo(MB_JSON_write_fn write, void *ctx, bool prettify);
+    bool mWriteTo(Print *out, bool prettify);
+    static size_t printWrite(void *ctx, const unsigned char *data, size_t len);
+    bool mHasKey(MB_JSON *e, const char *key);
     void mSetFloatDigits(uint8_t digits);
     void mSetDoubleDigits(uint8_t digits);
     int mResponseCode();
     bool mGet(MB_JSON *parent, FirebaseJsonData *result, const char *path, bool prettify = false);
+    bool mGet(MB_JSON *parent, FirebaseJsonData *result, const FirebaseJsonPath &keys, bool prettify = false);
+    bool mGet(FirebaseJsonData *result, const FirebaseJsonEntry &entry, bool prettify = false);
+    void mSetResult(MB_JSON *data, FirebaseJsonData *result, bool prettify);
+    bool mExtract(FirebaseJsonData *result, const char *raw, size_t len, const char *path);
     void mSetResInt(FirebaseJsonData *data, const char *value);
     void mSetResFloat(FirebaseJsonData *data, const char *value);
     void mSetElementType(FirebaseJsonData *result);
     void mSet(const char *path, MB_JSON *value);
+    void mSet(const FirebaseJsonPath &keys, MB_JSON *value);
     void mCopy(FirebaseJsonBase &other);
+    void mUseArena(size_t chunkSize, bool psram);
+    void mUseKeyPool(FirebaseJsonKeyPool *pool);
 #if defined(__AVR__)
     unsigned long long strtoull_alt(const char *s);
 #endif
@@ -701,6 +758,9 @@ protected:
     fb_json_root_type root_type = Root_Type_JSON;
     struct iterator_data_t iterator_data;
     MB_JSON *root = NULL;
+    FirebaseJsonArena *arena = NULL;
+    FirebaseJsonKeyPool *keyPool = NULL;
+    FirebaseJsonStreamParser *reader = NULL;
     MB_JSON_Hooks *hooks = NULL;
     MB_String buf;
 
@@ -788,14 +848,7 @@ protected:
     template <typename T>
     auto toStringHandler(T &out, bool prettify) -> typename std::enable_if<std::is_same<T, MB_SERIAL_CLASS>::value, bool>::type
     {
-        char *p = prettify ? MB_JSON_Print(root) : MB_JSON_PrintUnformatted(root);
-        if (p)
-        {
-            out.print(p);
-            MB_JSON_free(p);
-            return true;
-        }
-        return false;
+        return mWriteTo(&out, prettify);
     }
 
     template <typename T>
@@ -823,20 +876,7 @@ protected:
     template <typename T>
     bool writeStream(T &out, bool prettify)
     {
-        bool ret = false;
-
-        if (!root)
-            return false;
-
-        char *p = prettify ? MB_JSON_Print(root) : MB_JSON_PrintUnformatted(root);
-        if (p)
-        {
-            ret = out.write((const uint8_t *)p, strlen(p)) == strlen(p);
-            MB_JSON_free(p);
-            return ret;
-        }
-
-        return ret;
+        return mWriteTo(&out, prettify);
     }
 
     void idle()
@@ -1332,7 +1372,7 @@ protected:
         return olen;
     }
 
-    int readClient(Client *client, MB_String &buf)
+    int readClient(Client *client, MB_String &buf, fb_js::payload_fn consume = nullptr, void *ctx = nullptr)
     {
         int ret = -1;
 
@@ -1465,15 +1505,20 @@ protected:
                                     else
                                         availablePayload = readLine(client, pChunk, chunkBufSize);
 
+                                    bool stop = false;
                                     if (availablePayload > 0)
                                     {
                                         payloadRead += availablePayload;
-                                        buf += pChunk;
+                                        // the consumer takes the chunk, nothing is kept
+                                        if (consume)
+                                            stop = !consume(ctx, pChunk, strlen(pChunk));
+                                        else
+                                            buf += pChunk;
                                     }
 
                                     delP(&pChunk);
 
-                                    if (availablePayload < 0 || (payloadRead >= response.contentLen && !response.isChunkedEnc))
+                                    if (stop || availablePayload < 0 || (payloadRead >= response.contentLen && !response.isChunkedEnc))
                                     {
                                         while (client->available() > 0)
                                             client->read();
@@ -1513,136 +1558,6 @@ protected:
         return ret;
     }
 
-    void clearSerialData(struct fb_js::serial_data_t &data)
-    {
-        data.buf.clear();
-        data.start = -1;
-        data.end = -1;
-        data.pos = -1;
-        data.scnt = 0;
-        data.ecnt = 0;
-        data.dataTime = millis();
-    }
-
-    bool readStreamChar(int r, struct fb_js::serial_data_t &data, MB_String &buf, bool isJson)
-    {
-        bool ret = false;
-        if (r > -1)
-        {
-            data.pos++;
-
-            if (isJson)
-            {
-                if ((char)r == '{')
-                {
-                    data.scnt++;
-                    data.start = data.pos;
-                }
-                else if ((char)r == '}')
-                {
-                    data.ecnt++;
-                    data.end = data.pos;
-                }
-            }
-            else
-            {
-                if ((char)r == '[')
-                {
-                    data.scnt++;
-                    data.start = data.pos;
-                }
-                else if ((char)r == ']')
-                {
-                    data.ecnt++;
-                    data.end = data.pos;
-                }
-            }
-
-            if (data.scnt > 0)
-                data.buf += (char)r;
-
-            if (data.scnt == data.ecnt && data.scnt > 0)
-            {
-                bool ret = false;
-                if (data.end > data.start)
-                {
-                    buf = data.buf.c_str();
-                    ret = true;
-                }
-
-                clearSerialData(data);
-                return ret;
-            }
-
-            if (data.ecnt > data.scnt)
-                clearSerialData(data);
-        }
-
-        return ret;
-    }
-
-    bool readStream(Stream *s, struct fb_js::serial_data_t &data, MB_String &buf, bool isJson, int timeoutMS)
-    {
-
-        bool ret = false;
-
-        if (timeoutMS > -1)
-        {
-            if (millis() - data.dataTime > (unsigned long)timeoutMS)
-                clearSerialData(data);
-        }
-        else
-            clearSerialData(data);
-
-        while (s->available())
-        {
-            idle();
-            int r = s->read();
-            ret = readStreamChar(r, data, buf, isJson);
-            if (ret)
-            {
-                if (timeoutMS == -1)
-                    clearSerialData(data);
-                return true;
-            }
-        }
-
-        return ret;
-    }
-
-#if defined(ESP32_SD_FAT_INCLUDED)
-
-    bool readSdFatFile(SD_FAT_FILE &file, struct fb_js::serial_data_t &data, MB_String &buf, bool isJson, int timeoutMS)
-    {
-
-        bool ret = false;
-
-        if (timeoutMS > -1)
-        {
-            if (millis() - data.dataTime > (unsigned long)timeoutMS)
-                clearSerialData(data);
-        }
-        else
-            clearSerialData(data);
-
-        while (file.available())
-        {
-            idle();
-            int r = file.read();
-            ret = readStreamChar(r, data, buf, isJson);
-            if (ret)
-            {
-                if (timeoutMS == -1)
-                    clearSerialData(data);
-                return true;
-            }
-        }
-
-        return ret;
-    }
-
-#endif
-
     Stream *toStream(MB_SERIAL_CLASS *ser)
     {
         return reinterpret_cast<Stream *>(ser);
@@ -1713,6 +1628,210 @@ protected:
     }
 };
 
+/* The node of the JSON tree that was visited by FirebaseJsonCursor. The key and the
+ * string value point into the tree (nothing is copied), they are valid until the
+ * FirebaseJson or FirebaseJsonArray object is changed or cleared.
+ */
+struct FirebaseJsonEntry
+{
+    // The tree item.
+    MB_JSON *item = NULL;
+    // The object key or NULL for the array element.
+    const char *key = NULL;
+    size_t keyLen = 0;
+    // The array index or -1 for the object member.
+    int index = -1;
+    // The depth of node, 0 for the children of root.
+    int depth = 0;
+    // The FirebaseJson::JSON_xxx type.
+    uint8_t type = FirebaseJsonBase::JSON_UNDEFINED;
+    // The unescaped string value (JSON_STRING) or the raw value.
+    const char *str = NULL;
+    size_t strLen = 0;
+    // The value of JSON_INT, JSON_FLOAT, JSON_DOUBLE and JSON_BOOL.
+    double number = 0;
+
+    bool isKey(const char *k) const { return key && k && strcmp(key, k) == 0; }
+    bool isContainer() const { return type == FirebaseJsonBase::JSON_OBJECT || type == FirebaseJsonBase::JSON_ARRAY; }
+    int intValue() const { return (int)number; }
+    bool boolValue() const { return number != 0; }
+};
+
+/* Walk the JSON tree in depth first order without the iterator list and without
+ * copying the keys and values. The cursor keeps its own fixed size stack of parent
+ * nodes so it can be placed on the stack.
+ *
+ * FirebaseJsonCursor c = json.cursor();
+ * while (c.next())
+ *     Serial.println(c.entry().key);
+ */
+class FirebaseJsonCursor
+{
+public:
+    /**
+     * @param parent The object or array whose children are visited.
+     * @param recursive Set false to visit only the direct children of parent.
+     */
+    FirebaseJsonCursor(MB_JSON *parent = NULL, bool recursive = true) : _parent(parent), _recursive(recursive) {}
+
+    /**
+     * Move to the next node.
+     * @return false when all nodes were visited.
+     */
+    bool next()
+    {
+        if (!_parent)
+            return false;
+
+        if (!_started)
+        {
+            _started = true;
+            _cur = _parent->child;
+            _index = 0;
+        }
+        else if (_cur)
+        {
+            bool descend = _recursive && !_skip && _cur->child && ((_cur->type & 0xFF) == MB_JSON_Array || (_cur->type & 0xFF) == MB_JSON_Object);
+
+            // the children below the deepest level are not visited
+            if (descend && _depth + 1 >= FIREBASE_JSON_CURSOR_DEPTH)
+            {
+                descend = false;
+                _truncated = true;
+            }
+
+            if (descend)
+            {
+                _stack[_depth] = _cur;
+                _indexes[_depth] = _index;
+                _depth++;
+                _cur = _cur->child;
+                _index = 0;
+            }
+            else
+            {
+                _cur = _cur->next;
+                _index++;
+            }
+
+            // go up until the parent that has the next sibling
+            while (!_cur && _depth > 0)
+            {
+                _depth--;
+                _cur = _stack[_depth]->next;
+                _index = _indexes[_depth] + 1;
+            }
+        }
+
+        _skip = false;
+
+        if (!_cur)
+            return false;
+
+        fill();
+        return true;
+    }
+
+    // The current node.
+    const FirebaseJsonEntry &entry() const { return _entry; }
+
+    // Don't visit the children of current object or array.
+    void skipChildren() { _skip = true; }
+
+    // Some nodes deeper than FIREBASE_JSON_CURSOR_DEPTH were not visited.
+    bool truncated() const { return _truncated; }
+
+    // Start over from the first child.
+    void rewind()
+    {
+        _started = false;
+        _skip = false;
+        _truncated = false;
+        _cur = NULL;
+        _depth = 0;
+        _index = 0;
+    }
+
+private:
+    void fill()
+    {
+        MB_JSON *parent = _depth > 0 ? _stack[_depth - 1] : _parent;
+        bool inArray = (parent->type & 0xFF) == MB_JSON_Array;
+
+        _entry.item = _cur;
+        _entry.key = inArray ? NULL : _cur->string;
+        _entry.keyLen = _entry.key ? strlen(_entry.key) : 0;
+        _entry.index = inArray ? _index : -1;
+        _entry.depth = _depth;
+        _entry.str = NULL;
+        _entry.strLen = 0;
+        _entry.number = 0;
+
+        switch (_cur->type & 0xFF)
+        {
+        case MB_JSON_Object:
+            _entry.type = FirebaseJsonBase::JSON_OBJECT;
+            break;
+        case MB_JSON_Array:
+            _entry.type = FirebaseJsonBase::JSON_ARRAY;
+            break;
+        case MB_JSON_String:
+            _entry.type = FirebaseJsonBase::JSON_STRING;
+            _entry.str = _cur->valuestring;
+            _entry.strLen = _entry.str ? strlen(_entry.str) : 0;
+            break;
+        case MB_JSON_Raw:
+        {
+            // the numbers that were set by FirebaseJson are kept as the raw text
+            _entry.str = _cur->valuestring;
+            _entry.strLen = _entry.str ? strlen(_entry.str) : 0;
+            char *end = NULL;
+            _entry.number = _entry.str ? strtod(_entry.str, &end) : 0;
+            if (!_entry.str || end == _entry.str)
+                _entry.type = FirebaseJsonBase::JSON_UNDEFINED;
+            else
+                _entry.type = numberType(_entry.number, memchr(_entry.str, '.', _entry.strLen) != NULL);
+            break;
+        }
+        case MB_JSON_Number:
+            _entry.number = _cur->valuedouble;
+            _entry.type = numberType(_entry.number, _cur->valuedouble != (double)_cur->valueint);
+            break;
+        case MB_JSON_True:
+        case MB_JSON_False:
+            _entry.type = FirebaseJsonBase::JSON_BOOL;
+            _entry.number = (_cur->type & 0xFF) == MB_JSON_True ? 1 : 0;
+            break;
+        case MB_JSON_NULL:
+            _entry.type = FirebaseJsonBase::JSON_NULL;
+            break;
+        default:
+            _entry.type = FirebaseJsonBase::JSON_UNDEFINED;
+            break;
+        }
+    }
+
+    // The same rule as FirebaseJsonBase::mSetElementType.
+    static uint8_t numberType(double d, bool fraction)
+    {
+        if (!fraction)
+            return FirebaseJsonBase::JSON_INT;
+        return d > 0x7fffffff ? FirebaseJsonBase::JSON_DOUBLE : FirebaseJsonBase::JSON_FLOAT;
+    }
+
+    MB_JSON *_parent = NULL;
+    MB_JSON *_cur = NULL;
+    MB_JSON *_stack[FIREBASE_JSON_CURSOR_DEPTH];
+    int _indexes[FIREBASE_JSON_CURSOR_DEPTH];
+    int _depth = 0;
+    int _index = 0;
+    bool _recursive = true;
+    bool _started = false;
+    bool _skip = false;
+    bool _truncated = false;
+    FirebaseJsonEntry _entry;
+};
+
 class FirebaseJsonArray : public FirebaseJsonBase
 {
 
@@ -1760,7 +1879,11 @@ public:
      *
      * @return instance of an object.
      */
-    FirebaseJsonArray &add() { return nAdd(MB_JSON_CreateNull()); }
+    FirebaseJsonArray &add()
+    {
+        FirebaseJsonArenaScope scope(arena, keyPool);
+        return nAdd(MB_JSON_CreateNull());
+    }
 
     /**
      * Add value to FirebaseJsonArray object.
@@ -1773,7 +1896,11 @@ public:
      * boolean, FirebaseJson object and array.
      */
     template <typename T>
-    FirebaseJsonArray &add(T value) { return dataAddHandler(value); }
+    FirebaseJsonArray &add(T value)
+    {
+        FirebaseJsonArenaScope scope(arena, keyPool);
+        return dataAddHandler(value);
+    }
 
     FirebaseJsonArray &add(FirebaseJson &value);
 
@@ -1790,6 +1917,7 @@ public:
     template <typename First, typename... Next>
     FirebaseJsonArray &add(First v, Next... n)
     {
+        FirebaseJsonArenaScope scope(arena, keyPool);
         dataAddHandler(v);
         return add(n...);
     }
@@ -1849,6 +1977,15 @@ public:
     template <typename T>
     bool get(FirebaseJsonData &result, T index_or_path, bool prettify = false) { return dataGetHandler(index_or_path, result, prettify); }
 
+    /**
+     * Get the array value at the compiled path e.g. [1]/myData.
+     * @param result The reference of FirebaseJsonData that holds the result.
+     * @param path The FirebaseJsonPath that was compiled once and reused.
+     * @param prettify The bool flag for a prettifying string in FirebaseJsonData's stringValue.
+     * @return bool value represents the successful operation.
+     */
+    bool get(FirebaseJsonData &result, const FirebaseJsonPath &path, bool prettify = false) { return mGet(root, &result, path, prettify); }
+
     /**
      * Check whether key or path to the child element existed in FirebaseJsonArray or not.
      *
@@ -1864,6 +2001,45 @@ public:
         return ret;
     }
 
+    /**
+     * Get the cursor that walks the nodes of this array without copying.
+     * @param recursive Set false to visit only the array elements.
+     * @return FirebaseJsonCursor, call next() before reading the entry().
+     * @note The cursor is invalid once this object was changed or cleared.
+     */
+    FirebaseJsonCursor cursor(bool recursive = true) { return FirebaseJsonCursor(root, recursive); }
+
+    /**
+     * Call the visitor for every node of this array in depth first order without copying.
+     * @param visitor The function or lambda e.g. [](const FirebaseJsonEntry &e) { return true; }
+     * that returns false to stop.
+     * @param recursive Set false to visit only the array elements.
+     * @return The number of visited nodes.
+     * @note The nodes deeper than FIREBASE_JSON_CURSOR_DEPTH are skipped, cursor() reports it with truncated().
+     */
+    template <typename F>
+    size_t visit(F visitor, bool recursive = true)
+    {
+        FirebaseJsonCursor c(root, recursive);
+        size_t n = 0;
+        while (c.next())
+        {
+            n++;
+            if (!visitor(c.entry()))
+                break;
+        }
+        return n;
+    }
+
+    /**
+     * Get the value of visited node.
+     * @param result The reference of FirebaseJsonData that holds the result.
+     * @param entry The node from cursor or visitor.
+     * @param prettify The bool flag for a prettifying string in FirebaseJsonData's stringValue.
+     * @return boolean status of the operation.
+     */
+    bool get(FirebaseJsonData &result, const FirebaseJsonEntry &entry, bool prettify = false) { return mGet(&result, entry, prettify); }
+
     /**
      * Parse and collect all node/array elements in FirebaseJsonArray object.
      * @return number of child/array elements in FirebaseJson object.
@@ -1935,6 +2111,18 @@ public:
      */
     const char *raw() { return mRaw(); }
 
+    /**
+     * Write the serialized JSON array through the small window to the writer function,
+     * the whole serialized string is never held in memory.
+     *
+     * @param write The writer function that returns the number of bytes that were written.
+     * @param ctx The user data that passes to the writer function.
+     * @param prettify The text indentation and new line serialization option.
+     * @return boolean status of the operation.
+     * @note The number of bytes to write is serializedBufferLength(prettify).
+     */
+    bool writeTo(MB_JSON_write_fn write, void *ctx, bool prettify = false) { return mWriteTo(write, ctx, prettify); }
+
     /**
      * Get the size of serialized JSON array buffer
      * @param prettify The text indentation and new line serialization option.
@@ -1955,7 +2143,11 @@ public:
      * @param index_or_path The array index or path that null to be set.
      */
     template <typename T>
-    void set(T index_or_path) { dataSetHandler(index_or_path, nullptr); }
+    void set(T index_or_path)
+    {
+        FirebaseJsonArenaScope scope(arena, keyPool);
+        dataSetHandler(index_or_path, nullptr);
+    }
 
     /**
      * Set value to FirebaseJsonArray object at the specified index.
@@ -1964,13 +2156,25 @@ public:
      * @param value The value to set.
      */
     template <typename T1, typename T2>
-    void set(T1 index_or_path, T2 value) { dataSetHandler(index_or_path, value); }
+    void set(T1 index_or_path, T2 value)
+    {
+        FirebaseJsonArenaScope scope(arena, keyPool);
+        dataSetHandler(index_or_path, value);
+    }
 
     template <typename T>
-    void set(T index_or_path, FirebaseJson &value) { return dataSetHandler(index_or_path, value); }
+    void set(T index_or_path, FirebaseJson &value)
+    {
+        FirebaseJsonArenaScope scope(arena, keyPool);
+        return dataSetHandler(index_or_path, value);
+    }
 
     template <typename T>
-    void set(T index_or_path, FirebaseJsonArray &value) { return dataSetHandler(index_or_path, value); }
+    void set(T index_or_path, FirebaseJsonArray &value)
+    {
+        FirebaseJsonArenaScope scope(arena, keyPool);
+        return dataSetHandler(index_or_path, value);
+    }
 
     /**
      * Remove the array value at the specified index or path from the FirebaseJsonArray object.
@@ -1984,6 +2188,8 @@ public:
     template <typename T1>
     bool remove(T1 index_or_path) { return dataRemoveHandler(index_or_path); }
 
+    bool remove(const FirebaseJsonPath &path) { return mRemove(path); }
+
     /**
      * Get the error position at the JSON object literal from parsing.
      * @return the position of error in JSON object literal
@@ -1991,6 +2197,28 @@ public:
      */
     int errorPosition() { return errorPos; }
 
+    /**
+     * Allocate the elements of this JSON Array object from the arena instead of the heap.
+     * @param chunkSize The size of arena chunk in bytes, 0 to go back to the heap.
+     * @param psram Set true to place the arena chunks in PSRAM when available (ESP32).
+     * @note The array is cleared. The memory of the removed elements is given back on clear().
+     */
+    void useArena(size_t chunkSize = FIREBASE_JSON_ARENA_CHUNK_SIZE, bool psram = false) { mUseArena(chunkSize, psram); }
+
+    /**
+     * Get the arena of this JSON Array object.
+     * @return The arena (for its used, peak and capacity bytes) or NULL when the heap is used.
+     */
+    const FirebaseJsonArena *getArena() const { return arena; }
+
+    /**
+     * Share the object keys of this JSON Array object with the other trees through the key pool.
+     * @param pool The key pool, NULL to keep the own copy of keys.
+     * @note The keys that were added while the pool was set stay in the pool, it
+     * should outlive this JSON Array and its copies.
+     */
+    void useKeyPool(FirebaseJsonKeyPool *pool) { mUseKeyPool(pool); }
+
     /**
      * Set the precision for float to JSON Array object
      */
@@ -2342,6 +2570,31 @@ public:
      */
     bool readFrom(Client &client) { return mReadClient(&client); }
 
+    /**
+     * Set only the values of the paths from the JSON data of derived Client object.
+     *
+     * @param client The instance of derived Client object.
+     * @param paths The array of relative paths e.g. {"node1/status", "node2/status/ts"}.
+     * @param count The number of paths (up to FIREBASE_JSON_EXTRACT_MAX_PATHS).
+     * @return boolean status of the operation, true when the values of all paths were found.
+     *
+     * @note The payload is scanned while it is read and the other values are skipped,
+     * the scan stops as soon as all values were found.
+     */
+    bool readFrom(Client &client, const char *const *paths, size_t count) { return mReadClient(&client, paths, count); }
+
+    /**
+     * Set only the values of the paths from the JSON data of derived Stream object.
+     *
+     * @param stream The instance of derived Stream object.
+     * @param paths The array of relative paths.
+     * @param count The number of paths (up to FIREBASE_JSON_EXTRACT_MAX_PATHS).
+     * @return boolean status of the operation, true when the values of all paths were found.
+     *
+     * @note The data is not read further once all values were found.
+     */
+    bool readFrom(Stream &stream, const char *const *paths, size_t count) { return mReadStream(&stream, paths, count); }
+
     /**
      * Set JSON array data via Serial to FirebaseJson object.
      *
@@ -2370,6 +2623,7 @@ public:
     template <typename T>
     FirebaseJson &add(T key)
     {
+        FirebaseJsonArenaScope scope(arena, keyPool);
         uint32_t addr = 0;
         nAdd(getStr(key, addr), NULL);
         delAddr(addr);
@@ -2386,6 +2640,7 @@ public:
     template <typename T1, typename T2>
     FirebaseJson &add(T1 key, T2 value)
     {
+        FirebaseJsonArenaScope scope(arena, keyPool);
         uint32_t addr = 0;
         dataHandler(getStr(key, addr), value, fb_json_func_type_add);
         delAddr(addr);
@@ -2395,6 +2650,7 @@ public:
     template <typename T>
     FirebaseJson &add(T key, FirebaseJson &value)
     {
+        FirebaseJsonArenaScope scope(arena, keyPool);
         uint32_t addr = 0;
         dataHandler(getStr(key, addr), value, fb_json_func_type_add);
         delAddr(addr);
@@ -2404,6 +2660,7 @@ public:
     template <typename T>
     FirebaseJson &add(T key, FirebaseJsonArray &value)
     {
+        FirebaseJsonArenaScope scope(arena, keyPool);
         uint32_t addr = 0;
         dataHandler(getStr(key, addr), value, fb_json_func_type_add);
         delAddr(addr);
@@ -2471,6 +2728,40 @@ public:
         return ret;
     }
 
+    /**
+     * Get the value at the compiled node path.
+     *
+     * @param result The reference of FirebaseJsonData that holds the result.
+     * @param path The FirebaseJsonPath that was compiled once and reused.
+     * @param prettify The bool flag for a prettifying string in FirebaseJsonData's stringValue.
+     * @return boolean status of the operation.
+     */
+    bool get(FirebaseJsonData &result, const FirebaseJsonPath &path, bool prettify = false) { return mGet(root, &result, path, prettify); }
+
+    /**
+     * Get the value at the specified node path from the raw JSON text without parsing it.
+     *
+     * @param result The reference of FirebaseJsonData that holds the result.
+     * @param raw The raw JSON text.
+     * @param len The length of raw JSON text.
+     * @param path The relative path of element in the raw JSON text.
+     * @return boolean status of the operation.
+     *
+     * The raw JSON text is scanned once and only the value at the path is copied to the result,
+     * no JSON tree is built and the data in FirebaseJson object is not changed.
+     * The object and array values are not prettified.
+     *
+     * Use FirebaseJsonExtractor to get many values in one pass or from the chunked data.
+     */
+    template <typename T>
+    bool extract(FirebaseJsonData &result, const char *raw, size_t len, T path)
+    {
+        uint32_t addr = 0;
+        bool ret = mExtract(&result, raw, len, getStr(path, addr));
+        delAddr(addr);
+        return ret;
+    }
+
     /**
      * Check whether key or path to the child element existed in FirebaseJson object or not.
      *
@@ -2486,6 +2777,47 @@ public:
         return ret;
     }
 
+    bool isMember(const FirebaseJsonPath &path) { return mGet(root, NULL, path); }
+
+    /**
+     * Get the cursor that walks the nodes of this JSON object without copying.
+     * @param recursive Set false to visit only the top level members.
+     * @return FirebaseJsonCursor, call next() before reading the entry().
+     * @note The cursor is invalid once this object was changed or cleared.
+     */
+    FirebaseJsonCursor cursor(bool recursive = true) { return FirebaseJsonCursor(root, recursive); }
+
+    /**
+     * Call the visitor for every node of this JSON object in depth first order without copying.
+     * @param visitor The function or lambda e.g. [](const FirebaseJsonEntry &e) { return true; }
+     * that returns false to stop.
+     * @param recursive Set false to visit only the top level members.
+     * @return The number of visited nodes.
+     * @note The nodes deeper than FIREBASE_JSON_CURSOR_DEPTH are skipped, cursor() reports it with truncated().
+     */
+    template <typename F>
+    size_t visit(F visitor, bool recursive = true)
+    {
+        FirebaseJsonCursor c(root, recursive);
+        size_t n = 0;
+        while (c.next())
+        {
+            n++;
+            if (!visitor(c.entry()))
+                break;
+        }
+        return n;
+    }
+
+    /**
+     * Get the value of visited node.
+     * @param result The reference of FirebaseJsonData that holds the result.
+     * @param entry The node from cursor or visitor.
+     * @param prettify The bool flag for a prettifying string in FirebaseJsonData's stringValue.
+     * @return boolean status of the operation.
+     */
+    bool get(FirebaseJsonData &result, const FirebaseJsonEntry &entry, bool prettify = false) { return mGet(&result, entry, prettify); }
+
     /**
      * Parse and collect all node/array elements in FirebaseJson object.
      *
@@ -2535,6 +2867,7 @@ public:
     template <typename T>
     void set(T key)
     {
+        FirebaseJsonArenaScope scope(arena, keyPool);
         uint32_t addr = 0;
         mSet(getStr(key, addr), NULL);
         delAddr(addr);
@@ -2556,6 +2889,7 @@ public:
     template <typename T1, typename T2>
     FirebaseJson &set(T1 key, T2 value)
     {
+        FirebaseJsonArenaScope scope(arena, keyPool);
         uint32_t addr = 0;
         dataHandler(getStr(key, addr), value, fb_json_func_type_set);
         delAddr(addr);
@@ -2565,6 +2899,7 @@ public:
     template <typename T>
     FirebaseJson &set(T key, FirebaseJson &value)
     {
+        FirebaseJsonArenaScope scope(arena, keyPool);
         uint32_t addr = 0;
         dataHandler(getStr(key, addr), value, fb_json_func_type_set);
         delAddr(addr);
@@ -2574,12 +2909,52 @@ public:
     template <typename T>
     FirebaseJson &set(T key, FirebaseJsonArray &value)
     {
+        FirebaseJsonArenaScope scope(arena, keyPool);
         uint32_t addr = 0;
         dataHandler(getStr(key, addr), value, fb_json_func_type_set);
         delAddr(addr);
         return *this;
     }
 
+    /**
+     * Set null to FirebaseJson object at the compiled node path.
+     *
+     * @param path The FirebaseJsonPath that was compiled once and reused.
+     */
+    void set(const FirebaseJsonPath &path)
+    {
+        FirebaseJsonArenaScope scope(arena, keyPool);
+        pathSetHandler(path, NULL);
+    }
+
+    /**
+     * Set value to FirebaseJson object at the compiled node path.
+     *
+     * @param path The FirebaseJsonPath that was compiled once and reused.
+     * @param value The value to set.
+     */
+    template <typename T>
+    FirebaseJson &set(const FirebaseJsonPath &path, T value)
+    {
+        FirebaseJsonArenaScope scope(arena, keyPool);
+        pathSetHandler(path, createValue(value));
+        return *this;
+    }
+
+    FirebaseJson &set(const FirebaseJsonPath &path, FirebaseJson &value)
+    {
+        FirebaseJsonArenaScope scope(arena, keyPool);
+        pathSetHandler(path, MB_JSON_Duplicate(value.root, true));
+        return *this;
+    }
+
+    FirebaseJson &set(const FirebaseJsonPath &path, FirebaseJsonArray &value)
+    {
+        FirebaseJsonArenaScope scope(arena, keyPool);
+        pathSetHandler(path, MB_JSON_Duplicate(value.root, true));
+        return *this;
+    }
+
     /**
      * Remove the specified node and its content.
      *
@@ -2595,12 +2970,34 @@ public:
         return ret;
     }
 
+    bool remove(const FirebaseJsonPath &path) { return mRemove(path); }
+
     /**
      * Get raw JSON
      * @return raw JSON string
      */
     const char *raw() { return mRaw(); }
 
+    /**
+     * Write the serialized JSON object through the small window to the writer function,
+     * the whole serialized string is never held in memory.
+     *
+     * @param write The writer function that returns the number of bytes that were written.
+     * @param ctx The user data that passes to the writer function.
+     * @param prettify The text indentation and new line serialization option.
+     * @return boolean status of the operation.
+     * @note The number of bytes to write is serializedBufferLength(prettify).
+     */
+    bool writeTo(MB_JSON_write_fn write, void *ctx, bool prettify = false) { return mWriteTo(write, ctx, prettify); }
+
+    /**
+     * Check whether the key exists in any level of FirebaseJson object.
+     *
+     * @param key The key (not the path) to find.
+     * @return boolean status of the operation.
+     */
+    bool hasKey(const char *key) { return mHasKey(root, key); }
+
     /**
      * Get the error position at the JSON object literal from parsing.
      * @return the position of error in JSON object literal
@@ -2615,6 +3012,28 @@ public:
      */
     size_t serializedBufferLength(bool prettify = false) { return mGetSerializedBufferLength(prettify); }
 
+    /**
+     * Allocate the nodes of this JSON object from the arena instead of the heap.
+     * @param chunkSize The size of arena chunk in bytes, 0 to go back to the heap.
+     * @param psram Set true to place the arena chunks in PSRAM when available (ESP32).
+     * @note The object is cleared. The memory of the removed nodes is given back on clear().
+     */
+    void useArena(size_t chunkSize = FIREBASE_JSON_ARENA_CHUNK_SIZE, bool psram = false) { mUseArena(chunkSize, psram); }
+
+    /**
+     * Get the arena of this JSON object.
+     * @return The arena (for its used, peak and capacity bytes) or NULL when the heap is used.
+     */
+    const FirebaseJsonArena *getArena() const { return arena; }
+
+    /**
+     * Share the object keys of this JSON object with the other trees through the key pool.
+     * @param pool The key pool, NULL to keep the own copy of keys.
+     * @note The keys that were added while the pool was set stay in the pool, it
+     * should outlive this JSON object and its copies.
+     */
+    void useKeyPool(FirebaseJsonKeyPool *pool) { mUseKeyPool(pool); }
+
     /**
      * Set the precision for float to JSON object
      * @param digits The number of decimal places.
@@ -2635,6 +3054,49 @@ public:
 private:
     FirebaseJson &nAdd(const char *key, MB_JSON *value);
 
+    void pathSetHandler(const FirebaseJsonPath &path, MB_JSON *value)
+    {
+        if (root_type != Root_Type_JSON)
+            mClear();
+
+        root_type = Root_Type_JSON;
+
+        mSet(path, value);
+    }
+
+    template <typename T>
+    auto createValue(T value) -> typename std::enable_if<is_bool<T>::value, MB_JSON *>::type
+    {
+        return MB_JSON_CreateBool(value);
+    }
+
+    template <typename T>
+    auto createValue(T value) -> typename std::enable_if<is_num_int<T>::value, MB_JSON *>::type
+    {
+        return MB_JSON_CreateRaw(num2Str(value, -1));
+    }
+
+    template <typename T>
+    auto createValue(T value) -> typename std::enable_if<std::is_same<T, float>::value, MB_JSON *>::type
+    {
+        return MB_JSON_CreateRaw(num2Str(value, floatDigits));
+    }
+
+    template <typename T>
+    auto createValue(T value) -> typename std::enable_if<std::is_same<T, double>::value || std::is_same<T, long double>::value, MB_JSON *>::type
+    {
+        return MB_JSON_CreateRaw(num2Str(value, doubleDigits));
+    }
+
+    template <typename T>
+    auto createValue(T value) -> typename std::enable_if<is_string<T>::value, MB_JSON *>::type
+    {
+        uint32_t addr = 0;
+        MB_JSON *e = MB_JSON_CreateString(getStr(value, addr));
+        delAddr(addr);
+        return e;
+    }
+
     template <typename T1, typename T2>
     auto dataHandler(T1 arg1, T2 arg2, fb_json_func_type_t type) -> typename std::enable_if<is_string<T1>::value && is_bool<T2>::value, FirebaseJson &>::type
     {
@@ -0,0 +1,614 @@
+/*
+ * FirebaseJsonExtractor, version 1.0.0
+ *
+ * Selective (SAX style) value extractor for FirebaseJson.
+ *
+ * Created October 18, 2026
+ *
+ * The MIT License (MIT)
+ * Copyright (c) 2023 K. Suwatchai (Mobizt)
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person returning a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef FirebaseJsonExtractor_H
+#define FirebaseJsonExtractor_H
+
+#include <Arduino.h>
+
+// The maximum number of paths per extractor (up to 32).
+#if !defined(FIREBASE_JSON_EXTRACT_MAX_PATHS)
+#define FIREBASE_JSON_EXTRACT_MAX_PATHS 8
+#endif
+
+// The maximum number of segments per path.
+#if !defined(FIREBASE_JSON_EXTRACT_MAX_DEPTH)
+#define FIREBASE_JSON_EXTRACT_MAX_DEPTH 8
+#endif
+
+// The maximum nesting level of the input JSON (up to 32).
+#if !defined(FIREBASE_JSON_EXTRACT_MAX_NEST)
+#define FIREBASE_JSON_EXTRACT_MAX_NEST 32
+#endif
+
+/* Extract the values of a set of relative paths e.g. "a/b/[1]/c" from the JSON
+ * text in one pass, without building the JSON tree.
+ *
+ * The input can be fed in any number of chunks. The value of each path is passed
+ * to the handler as a span (string values without the double quotes, objects and
+ * arrays as raw JSON text) as soon as it is complete. The span points into the
+ * fed chunk when the value lies in that chunk, a value that spans chunks is kept
+ * in the internal buffer which only grows to the largest such value.
+ *
+ * The path strings must remain valid while the extractor is in use.
+ */
+class FirebaseJsonExtractor
+{
+public:
+    // the same values as FirebaseJson::jsonDataType
+    enum value_type
+    {
+        EXTRACT_OBJECT = 1,
+        EXTRACT_ARRAY = 2,
+        EXTRACT_STRING = 3,
+        EXTRACT_INT = 4,
+        EXTRACT_DOUBLE = 6,
+        EXTRACT_BOOL = 7,
+        EXTRACT_NULL = 8
+    };
+
+    FirebaseJsonExtractor() {}
+
+    ~FirebaseJsonExtractor()
+    {
+        if (_cap)
+            free(_cap);
+    }
+
+    /**
+     * Set the paths to extract and reset the parser.
+     *
+     * @param paths The array of relative paths.
+     * @param count The number of paths.
+     * @return boolean status of the operation, false when there are too many or too deep paths.
+     */
+    bool begin(const char *const *paths, size_t count)
+    {
+        _count = 0;
+        _all = 0;
+        memset(_lenMask, 0, sizeof(_lenMask));
+
+        if (count > FIREBASE_JSON_EXTRACT_MAX_PATHS || count > 32)
+            return false;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            uint8_t n = 0;
+            const char *p = paths[i];
+            while (p && *p)
+            {
+                while (*p == '/')
+                    p++;
+                if (!*p)
+                    break;
+
+                const char *e = strchr(p, '/');
+                size_t len = e ? (size_t)(e - p) : strlen(p);
+
+                if (n == FIREBASE_JSON_EXTRACT_MAX_DEPTH || len > 255)
+                    return false;
+
+                seg_t &s = _seg[i][n++];
+                s.key = p;
+                s.len = len;
+                s.index = -1;
+
+                // array index e.g. [1]
+                if (len > 2 && p[0] == '[' && p[len - 1] == ']')
+                {
+                    s.index = 0;
+                    for (size_t j = 1; j < len - 1; j++)
+                        s.index = s.index * 10 + (p[j] - '0');
+                }
+
+                p += len;
+            }
+
+            _segCount[i] = n;
+            _lenMask[n] |= (1UL << i);
+        }
+
+        _count = count;
+        _all = count == 32 ? 0xffffffffUL : ((1UL << count) - 1);
+        clear();
+        return true;
+    }
+
+    /**
+     * Reset the parser for the new input, the paths are kept.
+     */
+    void clear()
+    {
+        _state = st_value;
+        _depth = 0;
+        _arr = 0;
+        _next = _all;
+        _active = 0;
+        _found = 0;
+        _pos = 0;
+        _capBase = 0;
+        _capLen = 0;
+        _error = false;
+    }
+
+    /**
+     * Feed the JSON text.
+     *
+     * @param data The JSON text chunk.
+     * @param len The length of chunk.
+     * @param handler The callable that receives (size_t path index, const char *value, size_t length, value_type type).
+     * @return boolean status, false for malformed input, too deep nesting or out of memory.
+     */
+    template <typename Handler>
+    bool feed(const char *data, size_t len, Handler &&handler)
+    {
+        _base = _pos;
+
+        for (size_t i = 0; i < len && !_error; i++, _pos++)
+        {
+            // all values were found, no need to scan the rest
+            if (done())
+                break;
+            step(data, data[i], handler);
+        }
+
+        keep(data, len);
+        return !_error;
+    }
+
+    /**
+     * Terminate the input, completes the number or literal at the end of a primitive (root) JSON text.
+     *
+     * @param handler The callable that receives the values.
+     * @return boolean status of the operation, false when the JSON text is incomplete.
+     */
+    template <typename Handler>
+    bool finish(Handler &&handler)
+    {
+        if (_state == st_in_lit && _depth == 0)
+            endPrimitive(nullptr, _pos, litType(), handler);
+        return !_error && (done() || (_depth == 0 && _state == st_after));
+    }
+
+    /**
+     * Check whether the values of all paths were found.
+     * @return boolean status.
+     */
+    bool done() const { return _count > 0 && _found == _all && _active == 0; }
+
+    /**
+     * Check whether the value of path was found.
+     * @param index The path index.
+     * @return boolean status.
+     */
+    bool found(size_t index) const { return index < _count && (_found & (1UL << index)); }
+
+private:
+    enum parse_state
+    {
+        st_value,
+        st_key,
+        st_in_key,
+        st_in_key_esc,
+        st_colon,
+        st_in_str,
+        st_in_str_esc,
+        st_in_lit,
+        st_after
+    };
+
+    struct seg_t
+    {
+        const char *key;
+        uint8_t len;
+        int16_t index;
+    };
+
+    struct level_t
+    {
+        uint32_t mask;
+        uint16_t index;
+    };
+
+    template <typename Handler>
+    void step(const char *data, char c, Handler &&handler)
+    {
+        switch (_state)
+        {
+        case st_value:
+            if (isSpace(c))
+                return;
+            if (c == ']' && isArr())
+            {
+                // empty array
+                close(data, handler);
+                return;
+            }
+            beginValue(c);
+            return;
+
+        case st_key:
+            if (isSpace(c))
+                return;
+            if (c == '"')
+            {
+                _keyMask = _depth <= FIREBASE_JSON_EXTRACT_MAX_DEPTH ? keyCandidates(_lvl[_depth - 1].mask) : 0;
+                _keyPos = 0;
+                _state = st_in_key;
+            }
+            else if (c == '}')
+                close(data, handler);
+            else
+                _error = true;
+            return;
+
+        case st_in_key:
+            if (c == '"')
+            {
+                _next = 0;
+                uint32_t m = _keyMask;
+                for (uint8_t i = 0; m; i++, m >>= 1)
+                {
+                    if ((m & 1) && _seg[i][_depth - 1].len == _keyPos)
+                        _next |= (1UL << i);
+                }
+                _state = st_colon;
+                return;
+            }
+            if (c == '\\')
+                _state = st_in_key_esc;
+            else
+                matchKey(c);
+            return;
+
+        case st_in_key_esc:
+            matchKey(c);
+            _state = st_in_key;
+            return;
+
+        case st_colon:
+            if (isSpace(c))
+                return;
+            if (c == ':')
+                _state = st_value;
+            else
+                _error = true;
+            return;
+
+        case st_in_str:
+            if (c == '"')
+                endPrimitive(data, _pos + 1, EXTRACT_STRING, handler);
+            else if (c == '\\')
+                _state = st_in_str_esc;
+            return;
+
+        case st_in_str_esc:
+            _state = st_in_str;
+            return;
+
+        case st_in_lit:
+            if (c == ',' || c == '}' || c == ']' || isSpace(c))
+            {
+                endPrimitive(data, _pos, litType(), handler);
+                step(data, c, handler);
+            }
+            else if (c == '.' || c == 'e' || c == 'E')
+                _litDec = true;
+            return;
+
+        case st_after:
+            if (isSpace(c))
+                return;
+            if (_depth == 0)
+            {
+                // trailing data after the root value
+                _error = true;
+                return;
+            }
+            if (c == ',')
+            {
+                if (isArr())
+                {
+                    if (_depth <= FIREBASE_JSON_EXTRACT_MAX_DEPTH)
+                        _lvl[_depth - 1].index++;
+                    _next = indexCandidates();
+                    _state = st_value;
+                }
+                else
+                    _state = st_key;
+            }
+            else if ((c == '}' && !isArr()) || (c == ']' && isArr()))
+                close(data, handler);
+            else
+                _error = true;
+            return;
+        }
+    }
+
+    void beginValue(char c)
+    {
+        // values of the paths that end at this level start here
+        uint32_t exact = _depth <= FIREBASE_JSON_EXTRACT_MAX_DEPTH ? (_next & _lenMask[_depth]) : 0;
+        if (exact)
+        {
+            for (uint8_t i = 0; i < _count; i++)
+            {
+                if (exact & (1UL << i))
+                {
+                    _capStart[i] = _pos;
+                    _capDepth[i] = _depth;
+                }
+            }
+            _active |= exact;
+        }
+
+        if (c == '{' || c == '[')
+        {
+            if (_depth == FIREBASE_JSON_EXTRACT_MAX_NEST)
+            {
+                _error = true;
+                return;
+            }
+
+            if (_depth < FIREBASE_JSON_EXTRACT_MAX_DEPTH)
+            {
+                _lvl[_depth].mask = _next & ~exact;
+                _lvl[_depth].index = 0;
+            }
+
+            if (c == '[')
+                _arr |= (1UL << _depth);
+            else
+                _arr &= ~(1UL << _depth);
+
+            _depth++;
+
+            if (c == '[')
+            {
+                _next = indexCandidates();
+                _state = st_value;
+            }
+            else
+                _state = st_key;
+        }
+        else if (c == '"')
+            _state = st_in_str;
+        else
+        {
+            _litFirst = c;
+            _litDec = false;
+            _state = st_in_lit;
+        }
+    }
+
+    template <typename Handler>
+    void close(const char *data, Handler &&handler)
+    {
+        bool arr = isArr();
+        _depth--;
+        complete(data, _pos + 1, arr ? EXTRACT_ARRAY : EXTRACT_OBJECT, handler);
+        _state = st_after;
+    }
+
+    template <typename Handler>
+    void endPrimitive(const char *data, size_t end, uint8_t type, Handler &&handler)
+    {
+        complete(data, end, type, handler);
+        _state = st_after;
+    }
+
+    template <typename Handler>
+    void complete(const char *data, size_t end, uint8_t type, Handler &&handler)
+    {
+        if (!_active)
+            return;
+
+        for (uint8_t i = 0; i < _count; i++)
+        {
+            if (!(_active & (1UL << i)) || _capDepth[i] != _depth)
+                continue;
+
+            size_t start = _capStart[i];
+            size_t stop = end;
+
+            // string value without quotes
+            if (type == EXTRACT_STRING)
+            {
+                start++;
+                stop--;
+            }
+
+            const char *p = span(data, start, stop);
+            if (!p)
+                return;
+
+            _active &= ~(1UL << i);
+            _found |= (1UL << i);
+            handler((size_t)i, p, stop - start, (value_type)type);
+        }
+    }
+
+    // Get the pointer of value from the chunk or from the internal buffer when it starts in the previous chunk.
+    const char *span(const char *data, size_t start, size_t stop)
+    {
+        if (start >= _base && data)
+            return data + (start - _base);
+
+        if (data && _capBase + _capLen < stop)
+        {
+            if (!append(data + (_capBase + _capLen - _base), stop - (_capBase + _capLen)))
+                return nullptr;
+        }
+
+        return _cap + (start - _capBase);
+    }
+
+    // Keep the active values that span to the next chunk.
+    void keep(const char *data, size_t len)
+    {
+        if (!_active)
+        {
+            _capLen = 0;
+            return;
+        }
+
+        size_t from = _pos;
+        for (uint8_t i = 0; i < _count; i++)
+        {
+            if ((_active & (1UL << i)) && _capStart[i] < from)
+                from = _capStart[i];
+        }
+
+        if (from >= _base)
+        {
+            _capBase = from;
+            _capLen = 0;
+        }
+        else if (from > _capBase)
+        {
+            // drop the completed values from the buffer head
+            memmove(_cap, _cap + (from - _capBase), _capLen - (from - _capBase));
+            _capLen -= from - _capBase;
+            _capBase = from;
+        }
+
+        size_t ofs = _capBase + _capLen - _base;
+        if (ofs < len)
+            append(data + ofs, len - ofs);
+    }
+
+    bool append(const char *data, size_t len)
+    {
+        if (_capLen + len > _capSize)
+        {
+            size_t size = _capSize ? _capSize : 64;
+            while (size < _capLen + len)
+                size *= 2;
+            char *buf = reinterpret_cast<char *>(realloc(_cap, size));
+            if (!buf)
+            {
+                _error = true;
+                return false;
+            }
+            _cap = buf;
+            _capSize = size;
+        }
+        memcpy(_cap + _capLen, data, len);
+        _capLen += len;
+        return true;
+    }
+
+    uint32_t keyCandidates(uint32_t mask)
+    {
+        uint32_t out = 0;
+        for (uint8_t i = 0; mask; i++, mask >>= 1)
+        {
+            if ((mask & 1) && _seg[i][_depth - 1].index < 0)
+                out |= (1UL << i);
+        }
+        return out;
+    }
+
+    uint32_t indexCandidates()
+    {
+        if (_depth > FIREBASE_JSON_EXTRACT_MAX_DEPTH)
+            return 0;
+
+        const level_t &l = _lvl[_depth - 1];
+        uint32_t out = 0;
+        uint32_t mask = l.mask;
+        for (uint8_t i = 0; mask; i++, mask >>= 1)
+        {
+            if ((mask & 1) && _seg[i][_depth - 1].index == (int16_t)l.index)
+                out |= (1UL << i);
+        }
+        return out;
+    }
+
+    void matchKey(char c)
+    {
+        uint32_t m = _keyMask;
+        for (uint8_t i = 0; m; i++, m >>= 1)
+        {
+            if (!(m & 1))
+                continue;
+            const seg_t &s = _seg[i][_depth - 1];
+            if (_keyPos >= s.len || s.key[_keyPos] != c)
+                _keyMask &= ~(1UL << i);
+        }
+        _keyPos++;
+    }
+
+    uint8_t litType()
+    {
+        if (_litFirst == 't' || _litFirst == 'f')
+            return EXTRACT_BOOL;
+        if (_litFirst == 'n')
+            return EXTRACT_NULL;
+        return _litDec ? EXTRACT_DOUBLE : EXTRACT_INT;
+    }
+
+    bool isArr() const { return _depth > 0 && (_arr & (1UL << (_depth - 1))); }
+
+    static bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+    seg_t _seg[FIREBASE_JSON_EXTRACT_MAX_PATHS][FIREBASE_JSON_EXTRACT_MAX_DEPTH];
+    uint8_t _segCount[FIREBASE_JSON_EXTRACT_MAX_PATHS];
+    // the paths that end at each depth
+    uint32_t _lenMask[FIREBASE_JSON_EXTRACT_MAX_DEPTH + 1];
+    size_t _count = 0;
+    uint32_t _all = 0;
+
+    level_t _lvl[FIREBASE_JSON_EXTRACT_MAX_DEPTH];
+    uint32_t _arr = 0;
+    uint8_t _depth = 0;
+    uint8_t _state = st_value;
+    uint32_t _next = 0;
+    uint32_t _keyMask = 0;
+    uint16_t _keyPos = 0;
+    char _litFirst = 0;
+    bool _litDec = false;
+    bool _error = false;
+
+    uint32_t _active = 0;
+    uint32_t _found = 0;
+    size_t _capStart[FIREBASE_JSON_EXTRACT_MAX_PATHS];
+    uint8_t _capDepth[FIREBASE_JSON_EXTRACT_MAX_PATHS];
+
+    // absolute input positions
+    size_t _pos = 0;
+    size_t _base = 0;
+
+    char *_cap = nullptr;
+    size_t _capBase = 0;
+    size_t _capLen = 0;
+    size_t _capSize = 0;
+};
+
+#endif
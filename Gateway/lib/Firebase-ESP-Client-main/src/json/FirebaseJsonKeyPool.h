@@ -0,0 +1,223 @@
+/*
+ * FirebaseJsonKeyPool, version 1.0.0
+ *
+ * Shared table of the interned object keys for the MB_JSON trees.
+ *
+ * Created October 18, 2026
+ *
+ * The MIT License (MIT)
+ * Copyright (c) 2023 K. Suwatchai (Mobizt)
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person returning a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef FirebaseJsonKeyPool_H
+#define FirebaseJsonKeyPool_H
+
+#include <Arduino.h>
+
+// The default number of keys that the pool can hold.
+#if !defined(FIREBASE_JSON_KEY_POOL_KEYS)
+#define FIREBASE_JSON_KEY_POOL_KEYS 64
+#endif
+
+// The default size of key text storage in bytes.
+#if !defined(FIREBASE_JSON_KEY_POOL_BYTES)
+#define FIREBASE_JSON_KEY_POOL_BYTES 512
+#endif
+
+// The longer keys (e.g. push ids) are not interned.
+#if !defined(FIREBASE_JSON_KEY_POOL_MAX_KEY_LEN)
+#define FIREBASE_JSON_KEY_POOL_MAX_KEY_LEN 16
+#endif
+
+/* The object keys of the trees that are parsed or set while the pool is current
+ * point to the single copy in the pool instead of the separately allocated string
+ * of each member (the items are marked MB_JSON_StringIsConst so they are not freed
+ * with the tree). The repeated short keys of the telemetry arrays and documents
+ * then cost nothing per member and the equal keys have the same address.
+ *
+ * The table and the key storage are allocated once with the fixed sizes, the keys
+ * are never removed. When the pool is full or the key is too long or escaped, the
+ * member keeps its own copy as usual.
+ *
+ * The pool can be shared by any number of FirebaseJson objects and threads but it
+ * must outlive every tree (and copy of tree) that used it.
+ */
+class FirebaseJsonKeyPool
+{
+public:
+    /**
+     * @param keys The maximum number of keys.
+     * @param bytes The size of key text storage in bytes.
+     * @param psram Set true to place the pool in PSRAM when available (ESP32).
+     */
+    FirebaseJsonKeyPool(size_t keys = FIREBASE_JSON_KEY_POOL_KEYS, size_t bytes = FIREBASE_JSON_KEY_POOL_BYTES, bool psram = false)
+    {
+        // keep the load factor at most 3/4
+        _slotCount = 8;
+        while (_slotCount * 3 < keys * 4)
+            _slotCount <<= 1;
+        _maxKeys = keys;
+        _textSize = bytes;
+
+        size_t len = _slotCount * sizeof(const char *) + bytes;
+        void *p = NULL;
+#if defined(ESP32) && defined(BOARD_HAS_PSRAM)
+        if (psram && ESP.getPsramSize() > 0)
+            p = ps_malloc(len);
+#else
+        (void)psram;
+#endif
+        if (!p)
+            p = malloc(len);
+        if (!p)
+            return;
+
+        _slots = reinterpret_cast<const char **>(p);
+        memset(_slots, 0, _slotCount * sizeof(const char *));
+        _text = reinterpret_cast<char *>(p) + _slotCount * sizeof(const char *);
+    }
+
+    ~FirebaseJsonKeyPool()
+    {
+        if (current() == this)
+            current() = nullptr;
+        if (_slots)
+            free(_slots);
+        _slots = nullptr;
+    }
+
+    /**
+     * Get the shared copy of key, add it when not found.
+     * @param key The key text, it does not need the null terminator.
+     * @param len The length of key.
+     * @return The null terminated key in the pool or NULL when it cannot be added.
+     */
+    const char *intern(const char *key, size_t len)
+    {
+        if (!_slots || len > FIREBASE_JSON_KEY_POOL_MAX_KEY_LEN)
+            return NULL;
+
+        const char *ret = NULL;
+        lock();
+        size_t i = slot(key, len);
+        if (_slots[i])
+            ret = _slots[i];
+        else if (_count < _maxKeys && _textUsed + len + 1 <= _textSize)
+        {
+            char *s = _text + _textUsed;
+            memcpy(s, key, len);
+            s[len] = 0;
+            _textUsed += len + 1;
+            _slots[i] = s;
+            _count++;
+            ret = s;
+        }
+        else
+            _misses++;
+        unlock();
+        return ret;
+    }
+
+    /**
+     * Get the shared copy of key without adding it.
+     * @param key The key text, it does not need the null terminator.
+     * @param len The length of key.
+     * @return The null terminated key in the pool or NULL when not found.
+     */
+    const char *find(const char *key, size_t len)
+    {
+        if (!_slots || len > FIREBASE_JSON_KEY_POOL_MAX_KEY_LEN)
+            return NULL;
+
+        lock();
+        const char *ret = _slots[slot(key, len)];
+        unlock();
+        return ret;
+    }
+
+    // The number of keys in the pool.
+    size_t size() const { return _count; }
+
+    // The bytes of key text storage that were used.
+    size_t used() const { return _textUsed; }
+
+    // The number of keys that were not added because the pool was full.
+    size_t misses() const { return _misses; }
+
+    // The pool of the calling thread that serves the keys.
+    static FirebaseJsonKeyPool *&current()
+    {
+#if defined(ESP8266)
+        static FirebaseJsonKeyPool *cur = nullptr;
+#else
+        static thread_local FirebaseJsonKeyPool *cur = nullptr;
+#endif
+        return cur;
+    }
+
+private:
+    FirebaseJsonKeyPool(const FirebaseJsonKeyPool &) = delete;
+    FirebaseJsonKeyPool &operator=(const FirebaseJsonKeyPool &) = delete;
+
+    // The slot of key or the empty slot where it should be added (linear probing).
+    size_t slot(const char *key, size_t len) const
+    {
+        // FNV-1a
+        uint32_t h = 2166136261u;
+        for (size_t i = 0; i < len; i++)
+            h = (h ^ (uint8_t)key[i]) * 16777619u;
+
+        size_t mask = _slotCount - 1;
+        size_t i = h & mask;
+        while (_slots[i] && (strncmp(_slots[i], key, len) != 0 || _slots[i][len] != 0))
+            i = (i + 1) & mask;
+        return i;
+    }
+
+#if defined(ESP32)
+    portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+#endif
+
+    void lock()
+    {
+#if defined(ESP32)
+        portENTER_CRITICAL(&_mux);
+#endif
+    }
+
+    void unlock()
+    {
+#if defined(ESP32)
+        portEXIT_CRITICAL(&_mux);
+#endif
+    }
+
+    const char **_slots = nullptr;
+    char *_text = nullptr;
+    size_t _slotCount = 0;
+    size_t _maxKeys = 0;
+    size_t _count = 0;
+    size_t _textSize = 0;
+    size_t _textUsed = 0;
+    size_t _misses = 0;
+};
+
+#endif
@@ -0,0 +1,419 @@
+/*
+ * FirebaseJsonPath, version 1.0.0
+ *
+ * Pre-tokenized node path and the path cache for FirebaseJson.
+ *
+ * Created October 18, 2026
+ *
+ * The MIT License (MIT)
+ * Copyright (c) 2023 K. Suwatchai (Mobizt)
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person returning a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef FirebaseJsonPath_H
+#define FirebaseJsonPath_H
+
+#include <Arduino.h>
+
+// The number of compiled paths that are cached for the string path APIs, 0 to disable.
+#if !defined(FIREBASE_JSON_PATH_CACHE_SIZE)
+#define FIREBASE_JSON_PATH_CACHE_SIZE 8
+#endif
+
+/* The relative node path e.g. "/myRoot/[2]/Sensor1" that was split into its
+ * segments once. The segment texts and the array indices are kept in one memory
+ * block so that the path can be reused by FirebaseJson get, set and remove
+ * without splitting and allocating the segments on every call.
+ */
+class FirebaseJsonPath
+{
+public:
+    FirebaseJsonPath() {}
+
+    /**
+     * @param path The relative node path, the segments are separated by '/'
+     * and the array index is placed inside square brackets e.g. /myRoot/[2]/Sensor1.
+     */
+    FirebaseJsonPath(const char *path) { compile(path); }
+
+    FirebaseJsonPath(const FirebaseJsonPath &other) { copy(other, other.size()); }
+
+    /**
+     * Copy the first segments of path.
+     * @param other The path.
+     * @param count The number of segments to copy.
+     */
+    FirebaseJsonPath(const FirebaseJsonPath &other, size_t count) { copy(other, count); }
+
+    ~FirebaseJsonPath() { release(); }
+
+    FirebaseJsonPath &operator=(const FirebaseJsonPath &other)
+    {
+        if (this != &other)
+            copy(other, other.size());
+        return *this;
+    }
+
+    /**
+     * Split the path.
+     * @param path The relative node path.
+     * @param split Set false to keep the whole text as one segment (key) as is.
+     * @return true when the memory was allocated.
+     */
+    bool compile(const char *path, bool split = true)
+    {
+        release();
+
+        if (!path)
+            path = "";
+
+        size_t srcLen = strlen(path);
+
+        // count the segments and their texts
+        size_t count = 0, chars = 0;
+        scan(path, split, count, chars, nullptr);
+
+        if (!alloc(count, srcLen + 1 + chars + count))
+            return false;
+
+        memcpy(text(), path, srcLen + 1);
+        _source_len = srcLen;
+        scan(path, split, count, chars, this);
+        return true;
+    }
+
+    // The number of segments.
+    size_t size() const { return _count; }
+
+    // The text of the segment.
+    const char *key(size_t index) const { return index < _count ? text() + segs()[index].ofs : ""; }
+
+    // Check whether the segment is the array index e.g. [2].
+    bool isIndex(size_t index) const { return index < _count && segs()[index].index > -1; }
+
+    // The array index of segment or -1 for the object key.
+    int index(size_t index) const { return index < _count ? segs()[index].index : -1; }
+
+    // The path text that was compiled.
+    const char *c_str() const { return _block ? text() : ""; }
+
+private:
+    struct segment_t
+    {
+        uint16_t ofs;
+        uint16_t len;
+        int32_t index;
+    };
+
+    // Collect the trimmed non-empty segments, count only when out is null.
+    static void scan(const char *path, bool split, size_t &count, size_t &chars, FirebaseJsonPath *out)
+    {
+        count = 0;
+        chars = 0;
+        size_t ofs = out ? out->_source_len + 1 : 0;
+        const char *p = path;
+
+        while (true)
+        {
+            const char *e = split ? strchr(p, '/') : nullptr;
+            if (!e)
+                e = p + strlen(p);
+
+            const char *s = p, *t = e;
+            if (split)
+            {
+                while (s < t && (uint8_t)*s <= 32)
+                    s++;
+                while (t > s && (uint8_t)*(t - 1) <= 32)
+                    t--;
+            }
+
+            size_t len = t - s;
+            if (len > 0 || !split)
+            {
+                if (out)
+                {
+                    segment_t &seg = out->segs()[count];
+                    seg.ofs = ofs;
+                    seg.len = len;
+                    seg.index = arrayIndex(s, len);
+                    memcpy(out->text() + ofs, s, len);
+                    out->text()[ofs + len] = 0;
+                    ofs += len + 1;
+                }
+                count++;
+                chars += len;
+            }
+
+            if (!*e)
+                break;
+            p = e + 1;
+        }
+    }
+
+    // The same rule as FirebaseJsonBase isArrayKey and getArrIndex.
+    static int32_t arrayIndex(const char *s, size_t len)
+    {
+        if (len < 2 || s[0] != '[' || s[len - 1] != ']')
+            return -1;
+        int32_t n = atoi(s + 1);
+        return n < 0 ? 0 : n;
+    }
+
+    bool alloc(size_t count, size_t chars)
+    {
+        _block = (uint8_t *)malloc(count * sizeof(segment_t) + chars);
+        if (!_block)
+            return false;
+        _count = count;
+        _chars = chars;
+        return true;
+    }
+
+    void copy(const FirebaseJsonPath &other, size_t count)
+    {
+        release();
+        if (!other._block)
+            return;
+
+        if (count > other._count)
+            count = other._count;
+
+        if (!alloc(count, other._chars))
+            return;
+
+        memcpy(segs(), other.segs(), count * sizeof(segment_t));
+        memcpy(text(), other.text(), other._chars);
+        _source_len = other._source_len;
+
+        if (count < other._count)
+        {
+            // the source text of the prefix
+            size_t n = 0;
+            for (size_t i = 0; i < count; i++)
+                n += (i > 0 ? 1 : 0) + segs()[i].len;
+            char *t = text();
+            size_t k = 0;
+            for (size_t i = 0; i < count; i++)
+            {
+                if (i > 0)
+                    t[k++] = '/';
+                memmove(t + k, other.text() + other.segs()[i].ofs, segs()[i].len);
+                k += segs()[i].len;
+            }
+            t[n] = 0;
+            _source_len = n;
+        }
+    }
+
+    void release()
+    {
+        if (_block)
+            free(_block);
+        _block = nullptr;
+        _count = 0;
+        _chars = 0;
+        _source_len = 0;
+    }
+
+    segment_t *segs() const { return reinterpret_cast<segment_t *>(_block); }
+
+    char *text() const { return reinterpret_cast<char *>(_block + _count * sizeof(segment_t)); }
+
+    uint8_t *_block = nullptr;
+    size_t _count = 0;
+    size_t _chars = 0;
+    size_t _source_len = 0;
+    uint32_t _stamp = 0;
+    uint8_t _users = 0;
+    bool _cached = false;
+
+    friend class FirebaseJsonPathCache;
+};
+
+/* The recently used compiled paths of the string path APIs. A path that is in use
+ * is pinned and never evicted, the least recently used unpinned path is replaced
+ * when the cache is full.
+ */
+class FirebaseJsonPathCache
+{
+public:
+    static FirebaseJsonPathCache &instance()
+    {
+        static FirebaseJsonPathCache cache;
+        return cache;
+    }
+
+    /**
+     * Get the compiled path, it must be given back with release().
+     * @param path The relative node path.
+     * @return The compiled path or NULL when out of memory.
+     */
+    FirebaseJsonPath *acquire(const char *path)
+    {
+        if (!path)
+            path = "";
+
+        FirebaseJsonPath *p = find(path);
+        if (p)
+            return p;
+
+        p = new FirebaseJsonPath();
+        if (!p || !p->compile(path))
+        {
+            delete p;
+            return nullptr;
+        }
+
+        p->_users = 1;
+        FirebaseJsonPath *victim = nullptr;
+
+#if FIREBASE_JSON_PATH_CACHE_SIZE > 0
+        lock();
+        // the other thread may have added the same path meanwhile
+        for (size_t i = 0; i < _count; i++)
+        {
+            if (strcmp(_items[i]->c_str(), path) == 0)
+            {
+                victim = p;
+                p = _items[i];
+                p->_users++;
+                p->_stamp = ++_tick;
+                break;
+            }
+        }
+
+        if (!victim)
+        {
+            int slot = -1;
+            if (_count < FIREBASE_JSON_PATH_CACHE_SIZE)
+                slot = _count++;
+            else
+            {
+                for (size_t i = 0; i < _count; i++)
+                {
+                    if (_items[i]->_users == 0 && (slot < 0 || _items[i]->_stamp < _items[slot]->_stamp))
+                        slot = i;
+                }
+                if (slot > -1)
+                    victim = _items[slot];
+            }
+
+            if (slot > -1)
+            {
+                p->_cached = true;
+                p->_stamp = ++_tick;
+                _items[slot] = p;
+            }
+        }
+        unlock();
+#endif
+
+        // free outside the lock
+        if (victim)
+            delete victim;
+
+        return p;
+    }
+
+    /**
+     * Give back the compiled path.
+     * @param path The compiled path from acquire().
+     */
+    void release(FirebaseJsonPath *path)
+    {
+        if (!path)
+            return;
+
+        lock();
+        if (path->_users > 0)
+            path->_users--;
+        bool drop = !path->_cached;
+        unlock();
+
+        // all cache slots were pinned, the path was not cached
+        if (drop)
+            delete path;
+    }
+
+private:
+    FirebaseJsonPathCache() {}
+
+    FirebaseJsonPath *find(const char *path)
+    {
+        FirebaseJsonPath *p = nullptr;
+#if FIREBASE_JSON_PATH_CACHE_SIZE > 0
+        lock();
+        for (size_t i = 0; i < _count; i++)
+        {
+            if (strcmp(_items[i]->c_str(), path) == 0)
+            {
+                p = _items[i];
+                p->_users++;
+                p->_stamp = ++_tick;
+                break;
+            }
+        }
+        unlock();
+#endif
+        return p;
+    }
+
+#if defined(ESP32)
+    portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+#endif
+
+    void lock()
+    {
+#if defined(ESP32)
+        portENTER_CRITICAL(&_mux);
+#endif
+    }
+
+    void unlock()
+    {
+#if defined(ESP32)
+        portEXIT_CRITICAL(&_mux);
+#endif
+    }
+
+#if FIREBASE_JSON_PATH_CACHE_SIZE > 0
+    FirebaseJsonPath *_items[FIREBASE_JSON_PATH_CACHE_SIZE];
+#endif
+    size_t _count = 0;
+    uint32_t _tick = 0;
+};
+
+/* Pin the cached compiled path of the string path in this scope. */
+class FirebaseJsonPathRef
+{
+public:
+    explicit FirebaseJsonPathRef(const char *path) : _path(FirebaseJsonPathCache::instance().acquire(path)) {}
+
+    ~FirebaseJsonPathRef() { FirebaseJsonPathCache::instance().release(_path); }
+
+    // The compiled path or NULL when out of memory.
+    const FirebaseJsonPath *get() const { return _path; }
+
+private:
+    FirebaseJsonPath *_path;
+};
+
+#endif
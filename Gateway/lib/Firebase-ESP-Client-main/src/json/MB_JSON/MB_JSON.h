@@ -152,8 +152,21 @@ MB_JSON_PUBLIC(const char*) MB_JSON_Version(void);
 /* Supply malloc, realloc and free functions to MB_JSON */
 MB_JSON_PUBLIC(void) MB_JSON_InitHooks(MB_JSON_Hooks* hooks);
 
+/* Returns the shared copy of object key (len bytes, not null terminated) or NULL to let the item keep its own copy.
+ * The shared keys are marked MB_JSON_StringIsConst, they must outlive the trees. */
+typedef const char *(MB_JSON_CDECL *MB_JSON_KeyHook)(const char *key, size_t len);
+
+/* Supply the key interning function to MB_JSON, NULL to disable. It applies to the keys of parsed objects and MB_JSON_AddItemToObject. */
+MB_JSON_PUBLIC(void) MB_JSON_InitKeyHook(MB_JSON_KeyHook hook);
+
+/* Get the shared copy of key from the key hook, NULL when there is no hook or the key was not interned. */
+MB_JSON_PUBLIC(const char *) MB_JSON_InternKey(const char *key, size_t len);
+
 size_t MB_JSON_SerializedBufferLength(const MB_JSON *const item, MB_JSON_bool format);
 
+/* The writer of MB_JSON_PrintStream, returns the number of bytes that were written. */
+typedef size_t (*MB_JSON_write_fn)(void *ctx, const unsigned char *data, size_t len);
+
 /* Memory Management: the caller is always responsible to free the results from all variants of MB_JSON_Parse (with MB_JSON_Delete) and MB_JSON_Print (with stdlib free, MB_JSON_Hooks.free_fn, or MB_JSON_free as appropriate). The exception is MB_JSON_PrintPreallocated, where the caller has full responsibility of the buffer. */
 /* Supply a block of JSON, and this returns a MB_JSON object you can interrogate. */
 MB_JSON_PUBLIC(MB_JSON *)
@@ -173,6 +186,8 @@ MB_JSON_PUBLIC(char *) MB_JSON_PrintBuffered(const MB_JSON *item, int prebuffer,
 /* Render a MB_JSON entity to text using a buffer already allocated in memory with given length. Returns 1 on success and 0 on failure. */
 /* NOTE: MB_JSON is not always 100% accurate in estimating how much memory it will use, so to be safe allocate 5 bytes more than you actually need */
 MB_JSON_PUBLIC(MB_JSON_bool) MB_JSON_PrintPreallocated(MB_JSON *item, char *buffer, const int length, const MB_JSON_bool format);
+/* Render a MB_JSON entity to text through the window of given size, the text is handed over to write whenever the window is full so the whole text is never held in memory. The window only grows for a single token (string or raw) that is larger than it. Returns 1 on success and 0 on failure. */
+MB_JSON_PUBLIC(MB_JSON_bool) MB_JSON_PrintStream(const MB_JSON *item, const MB_JSON_bool format, size_t window, MB_JSON_write_fn write, void *ctx);
 /* Delete a MB_JSON entity and all subentities. */
 MB_JSON_PUBLIC(void) MB_JSON_Delete(MB_JSON *item);
 
@@ -1,11 +1,16 @@
 
 /**
- * Mobizt's SRAM/PSRAM supported String, version 1.2.12
+ * Mobizt's SRAM/PSRAM supported String, version 1.3.0
  *
- * Created March 25, 2024
+ * Created October 18, 2026
  *
  * Changes Log
  *
+ * v1.3.0
+ * - keep the short string in the inline buffer (MB_STRING_SSO_SIZE)
+ * - grow the buffer geometrically
+ * - add move constructor and move assignment, fix swap and move
+ *
  * v1.2.12
  * - using std namespace
  * 
@@ -103,6 +108,16 @@
 #define ESP8266_USE_EXTERNAL_HEAP
 #endif
 
+// The size of inline buffer in bytes (including the terminator) that keeps the short string
+// without the heap allocation, 0 to always use the heap.
+#if !defined(MB_STRING_SSO_SIZE)
+#if defined(ESP8266_USE_EXTERNAL_HEAP) || defined(__AVR__)
+#define MB_STRING_SSO_SIZE 0
+#else
+#define MB_STRING_SSO_SIZE 16
+#endif
+#endif
+
 #if defined(ESP8266) || defined(ESP32)
 #define MBSTRING_FLASH_MCR FPSTR
 #elif defined(ARDUINO_ARCH_SAMD) || defined(__AVR_ATmega4809__) || defined(ARDUINO_NANO_RP2040_CONNECT)
@@ -524,6 +539,11 @@ public:
         *this = value;
     }
 
+    MB_String(MB_String &&value) noexcept
+    {
+        move(value);
+    }
+
     MB_String(const __FlashStringHelper *str)
     {
         *this = str;
@@ -748,6 +768,12 @@ public:
         return *this;
     }
 
+    MB_String &operator=(MB_String &&rhs) noexcept
+    {
+        move(rhs);
+        return *this;
+    }
+
     MB_String &operator+=(const MB_String &rhs)
     {
         concat(rhs);
@@ -1017,7 +1043,7 @@ public:
         {
             memmove(buf, buf + p1, p2 - p1 + 1);
             buf[p2 - p1 + 1] = '\0';
-            _reserve(p2 - p1 + 1, true);
+            _trim();
         }
     }
 
@@ -1028,8 +1054,10 @@ public:
 
         size_t slen = length();
 
-        if (n > strlen(cstr))
-            n = strlen(cstr);
+        // stop at the terminator within n, the span may not be null terminated
+        const char *z = reinterpret_cast<const char *>(memchr(cstr, 0, n));
+        if (z)
+            n = z - cstr;
 
         if (_reserve(slen + n, false))
         {
@@ -1103,7 +1131,13 @@ public:
 
     void swap(MB_String &rhs)
     {
-        rhs.clear();
+        if (&rhs == this)
+            return;
+
+        MB_String t;
+        t.move(rhs);
+        rhs.move(*this);
+        move(t);
     }
 
     void shrink_to_fit()
@@ -1119,7 +1153,7 @@ public:
             size_t slen = length();
             if (slen > 0)
                 buf[slen - 1] = '\0';
-            _reserve(slen, true);
+            _trim();
         }
     }
 
@@ -1175,7 +1209,7 @@ public:
 
         buf[index + rightLen] = '\0';
 
-        _reserve(length(), true);
+        _trim();
     }
 
     size_t length() const
@@ -1689,25 +1723,44 @@ private:
         concat(cstr, strlen(cstr));
     }
 
+    // Take over the text of rhs, the heap buffer is taken as is and the inline text is copied.
     void move(MB_String &rhs)
     {
-        if (buf)
+        if (&rhs == this)
+            return;
+
+        if (!rhs.buf || rhs.isInline())
         {
-            if (bufLen >= rhs.bufLen)
-            {
-                strcpy(buf, rhs.buf);
-                bufLen = rhs.bufLen;
-                rhs.bufLen = 0;
-                return;
-            }
+            if (rhs.length() > 0)
+                copy(rhs.buf, rhs.length());
             else
-            {
-                free(buf);
-            }
+                allocate(0, false);
+            rhs.allocate(0, false);
+            return;
         }
+
+        allocate(0, false);
         buf = rhs.buf;
         bufLen = rhs.bufLen;
         rhs.buf = NULL;
+        rhs.bufLen = 0;
+    }
+
+    bool isInline() const
+    {
+#if MB_STRING_SSO_SIZE > 0
+        return buf == _sso;
+#else
+        return false;
+#endif
+    }
+
+    // Give back the memory when the buffer is more than twice the text or the text fits the inline buffer.
+    void _trim()
+    {
+        size_t need = getReservedLen(length());
+        if (bufLen > 2 * need || (!isInline() && need <= MB_STRING_SSO_SIZE))
+            _reserve(length(), true);
     }
 
     void allocate(size_t len, bool shrink)
@@ -1715,15 +1768,43 @@ private:
 
         if (len == 0)
         {
-            if (buf)
+            if (buf && !isInline())
                 free(buf);
             buf = NULL;
             bufLen = 0;
             return;
         }
 
+#if MB_STRING_SSO_SIZE > 0
+        if (len <= MB_STRING_SSO_SIZE)
+        {
+            if (!isInline())
+            {
+                size_t slen = length();
+                if (slen > MB_STRING_SSO_SIZE - 1)
+                    slen = MB_STRING_SSO_SIZE - 1;
+                if (buf)
+                {
+                    memcpy(_sso, buf, slen);
+                    free(buf);
+                }
+                _sso[slen] = '\0';
+                buf = _sso;
+                bufLen = MB_STRING_SSO_SIZE;
+            }
+            return;
+        }
+#endif
+
         if (len > bufLen || shrink)
         {
+            // the inline text is copied to the new heap buffer
+            bool wasInline = isInline();
+            if (wasInline)
+            {
+                buf = NULL;
+                bufLen = 0;
+            }
 
 #if defined(ESP8266_USE_EXTERNAL_HEAP)
             ESP.setExternalHeap();
@@ -1732,6 +1813,8 @@ private:
             if (shrink || (bufLen > 0 && buf))
             {
                 int slen = length();
+                if (slen >= (int)len)
+                    slen = len - 1;
 
 #if defined(BOARD_HAS_PSRAM) && defined(MB_STRING_USE_PSRAM)
                 if (ESP.getPsramSize() > 0)
@@ -1767,6 +1850,20 @@ private:
 #if defined(ESP8266_USE_EXTERNAL_HEAP)
             ESP.resetHeap();
 #endif
+
+#if MB_STRING_SSO_SIZE > 0
+            if (wasInline)
+            {
+                if (buf)
+                    strcpy(buf, _sso);
+                else
+                {
+                    // keep the inline text when out of memory
+                    buf = _sso;
+                    bufLen = MB_STRING_SSO_SIZE;
+                }
+            }
+#endif
         }
     }
 
@@ -1792,7 +1889,11 @@ private:
         if (shrink)
             allocate(newlen, true);
         else if (newlen > bufLen)
-            allocate(newlen, false);
+        {
+            // grow by half so that the repeated appends are amortized
+            size_t grow = bufLen + (bufLen >> 1);
+            allocate(grow > newlen ? getReservedLen(grow) : newlen, false);
+        }
 
         return newlen <= bufLen;
     }
@@ -2038,6 +2139,9 @@ private:
 
     char *buf = NULL;
     size_t bufLen = 0;
+#if MB_STRING_SSO_SIZE > 0
+    char _sso[MB_STRING_SSO_SIZE];
+#endif
 };
 
 inline MB_String operator+(const MB_String &lhs, const MB_String &rhs)
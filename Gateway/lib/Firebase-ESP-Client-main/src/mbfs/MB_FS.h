@@ -749,6 +749,62 @@ public:
         return false;
     }
 
+    // Copy len bytes from offset of the source file to the new destination file in the same storage.
+    // Both files are kept open during the copy. Return the number of bytes that were copied or negative value for error.
+    int copy(const MB_String &src, size_t ofs, size_t len, const MB_String &dst, mbfs_file_type type)
+    {
+        // the destination is removed before the shared handle is taken by the source
+        remove(dst, type);
+
+        int ret = open(src, type, mb_fs_open_mode_read);
+        if (ret < 0)
+            return ret;
+
+        if ((size_t)ret < ofs + len || !seek(type, ofs))
+        {
+            close(type);
+            return MB_FS_ERROR_FILE_IO_ERROR;
+        }
+
+        ret = MB_FS_ERROR_FILE_IO_ERROR;
+
+#if defined(MBFS_FLASH_FS)
+        if (type == mbfs_flash)
+        {
+            createDirs(dst, type);
+            fs::File file = MBFS_FLASH_FS.open(dst.c_str(), "w");
+            if (file)
+            {
+                ret = copyTo(file, type, len);
+                file.close();
+            }
+        }
+#endif
+#if defined(MBFS_SD_FS)
+        if (type == mbfs_sd)
+        {
+            createDirs(dst, type);
+#if defined(MBFS_ESP32_SDFAT_ENABLED) || defined(MBFS_SDFAT_ENABLED)
+            MBFS_SD_FILE file;
+            if (file.open(dst.c_str(), O_RDWR | O_CREAT | O_TRUNC))
+#elif defined(ESP32) || defined(ESP8266)
+            MBFS_SD_FILE file = MBFS_SD_FS.open(dst.c_str(), FILE_WRITE);
+            if (file)
+#else
+            MBFS_SD_FILE file = MBFS_SD_FS.open(dst.c_str(), "w");
+            if (file)
+#endif
+            {
+                ret = copyTo(file, type, len);
+                file.close();
+            }
+        }
+#endif
+
+        close(type);
+        return ret;
+    }
+
 // Get the Flash file instance.
 #if defined(MBFS_FLASH_FS)
     fs::File &getFlashFile()
@@ -924,6 +980,25 @@ public:
     }
 
 private:
+    // Copy len bytes from the opened file of the storage type to the other file.
+    template <typename T>
+    int copyTo(T &file, mbfs_file_type type, size_t len)
+    {
+        uint8_t buf[256];
+        size_t total = 0;
+
+        while (total < len)
+        {
+            size_t n = len - total > sizeof(buf) ? sizeof(buf) : len - total;
+            if (read(type, buf, n) != (int)n || (size_t)file.write(buf, n) != n)
+                return MB_FS_ERROR_FILE_IO_ERROR;
+            total += n;
+            yield();
+        }
+
+        return (int)total;
+    }
+
     uint16_t flash_filename_crc = 0;
     uint16_t sd_filename_crc = 0;
     MB_String flash_file, sd_file;
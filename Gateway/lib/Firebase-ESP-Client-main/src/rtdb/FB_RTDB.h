@@ -47,6 +47,38 @@
 #include "freertos/semphr.h"
 #endif
 
+// The maximum pipelined requests that wait for their responses.
+#if !defined(FIREBASE_RTDB_PIPELINE_MAX_INFLIGHT)
+#define FIREBASE_RTDB_PIPELINE_MAX_INFLIGHT 8
+#endif
+
+// The maximum pending paths of the write combiner.
+#if !defined(FIREBASE_RTDB_COMBINER_MAX_WRITES)
+#define FIREBASE_RTDB_COMBINER_MAX_WRITES 16
+#endif
+
+// The longest time that the stream task waits for the socket data before checking
+// the keep-alive timeout, reconnection and token (ESP32).
+#if !defined(FIREBASE_STREAM_IDLE_WAKE_MS)
+#define FIREBASE_STREAM_IDLE_WAKE_MS 1000
+#endif
+
+// The maximum records of the persistent error queue replayed by each processErrorQueue call.
+#if !defined(FIREBASE_ERROR_QUEUE_REPLAY_BATCH)
+#define FIREBASE_ERROR_QUEUE_REPLAY_BATCH 16
+#endif
+
+// The replayed bytes at the head of the persistent error queue file before the file is compacted
+// while records are still pending.
+#if !defined(FIREBASE_ERROR_QUEUE_COMPACT_SIZE)
+#define FIREBASE_ERROR_QUEUE_COMPACT_SIZE 4096
+#endif
+
+// The failed reads of the same persistent error queue record before the file is scanned again.
+#if !defined(FIREBASE_ERROR_QUEUE_READ_RETRY)
+#define FIREBASE_ERROR_QUEUE_READ_RETRY 3
+#endif
+
 using namespace mb_string;
 
 class FB_RTDB
@@ -89,6 +121,74 @@ public:
   template <typename T = const char *>
   void setwriteSizeLimit(FirebaseData *fbdo, T size) { return mSetwriteSizeLimit(fbdo, toStringPtr(size)); }
 
+  /** Begin sending the write requests in pipeline.
+   *
+   * @param fbdo The pointer to Firebase Data Object.
+   * @param callback Optional. The callback function that accept RTDB_PipelineResult data
+   * which is called for each response in request order.
+   * @return Boolean value, indicates the success of the operation.
+   *
+   * @note While the pipeline is open, the set, push, update and delete requests (except for the blob, file
+   * and async requests) are sent on the same keep-alive connection without waiting for the response
+   * and the functions return true when the request was sent.
+   *
+   * The responses are read in request order by endPipeline, before the request that cannot be pipelined
+   * (get, stream, file etc.) and when FIREBASE_RTDB_PIPELINE_MAX_INFLIGHT responses are waiting.
+   */
+  bool beginPipeline(FirebaseData *fbdo, RTDB_PipelineResultCallback callback = NULL);
+
+  /** Read all waiting pipelined responses and end the pipeline.
+   *
+   * @param fbdo The pointer to Firebase Data Object.
+   * @return Boolean value, true when all pipelined requests were success.
+   *
+   * @note Call [FirebaseData object].connectionStats to get the connection reuse statistics.
+   */
+  bool endPipeline(FirebaseData *fbdo);
+
+  /** Begin combining the set and update requests.
+   *
+   * @param fbdo The pointer to Firebase Data Object.
+   * @param deadline The milliseconds that the oldest pending write can wait before sent.
+   * @return Boolean value, indicates the success of the operation.
+   *
+   * @note While the combiner is enabled, the set and update requests (except for the push, blob, file, async,
+   * ETag and root path requests) are not sent, only the latest value of each path is kept and the functions
+   * return true. The pending values are sent together as one multi-location update at the deadline (checked
+   * by runWriteCombiner and by every combined write), when FIREBASE_RTDB_COMBINER_MAX_WRITES paths are pending,
+   * before any other request on this Firebase Data Object and by flushWrites.
+   *
+   * The pending values are kept when the combined update failed (unless it was taken by the error queue) and
+   * sent again by the next flush, the request that triggered the failed flush returns false.
+   *
+   * The write to a path replaces the pending writes under it, the write under a pending path sends the
+   * pending writes first, then the order of writes to the same path is kept.
+   *
+   * The server response data of the combined requests is not available.
+   */
+  bool beginWriteCombiner(FirebaseData *fbdo, unsigned long deadline = 1000);
+
+  /** Send the pending combined writes when the deadline was reached, should be called in loop.
+   *
+   * @param fbdo The pointer to Firebase Data Object.
+   * @return Boolean value, indicates the success of the operation.
+   */
+  bool runWriteCombiner(FirebaseData *fbdo);
+
+  /** Send all pending combined writes now (barrier).
+   *
+   * @param fbdo The pointer to Firebase Data Object.
+   * @return Boolean value, indicates the success of the operation.
+   */
+  bool flushWrites(FirebaseData *fbdo);
+
+  /** Send all pending combined writes and disable the combiner.
+   *
+   * @param fbdo The pointer to Firebase Data Object.
+   * @return Boolean value, indicates the success of the operation.
+   */
+  bool endWriteCombiner(FirebaseData *fbdo);
+
   /** Read the database rules.
    *
    * @param fbdo The pointer to Firebase Data Object.
@@ -2180,6 +2280,24 @@ public:
    */
   bool endStream(FirebaseData *fbdo);
 
+  /** Keep the local copy (mirror) of the subscribed node, it is updated by the stream events.
+   *
+   * @param fbdo The pointer to Firebase Data Object that is used for stream.
+   * @param maxSize (Optional) The memory limit of the mirror in bytes, 0 for no limit.
+   *
+   * @note Call [FirebaseData object].streamMirror() to read the mirrored data e.g.
+   * fbdo.streamMirror().getInt("/N01/controls/pump", value), the paths are relative to the stream path.
+   * The read returns false when the node was not received yet or was evicted by the memory limit,
+   * the data should be read from the database instead.
+   */
+  void beginStreamMirror(FirebaseData *fbdo, size_t maxSize = 0);
+
+  /** Free the stream mirror.
+   *
+   * @param fbdo The pointer to Firebase Data Object that is used for stream.
+   */
+  void endStreamMirror(FirebaseData *fbdo);
+
   /** Set the stream callback functions.
    *
    * @param fbdo The pointer to Firebase Data Object.
@@ -2259,6 +2377,21 @@ public:
     mRunStream();
   }
 
+  /** Wake the stream task to read the stream immediately.
+   *
+   * @note The stream task of ESP32 sleeps until the stream socket has data (internal WiFi client).
+   * The external clients (e.g. W5500 Ethernet) have no socket to wait for, the task is waked
+   * by this function or every stream task delay.
+   */
+  void notifyStream();
+
+  /** Wake the stream task from the interrupt handler e.g. the W5500 INT pin.
+   *
+   * @note ESP32 only. When the task waits in select, the wake socket is written by the
+   * FreeRTOS timer task after the ISR returns, the latency depends on the timer task priority.
+   */
+  void notifyStreamFromISR();
+
   /** Backup (download) the database at the defined node to the storage memory.
    *
    * @param fbdo The pointer to Firebase Data Object.
@@ -2439,12 +2572,49 @@ public:
    */
   void endAutoRunErrorQueue(FirebaseData *fbdo);
 
-  /** Clear all Firbase Error Queues in Error Queue collection.
+  /** Clear all Firbase Error Queues in Error Queue collection and the persistent error queue file.
    *
    * @param fbdo The pointer to Firebase Data Object.
    */
   void clearErrorQueue(FirebaseData *fbdo);
 
+  /** Keep the failed write operations in the queue file instead of the Error Queue collection.
+   *
+   * @param fbdo The pointer to Firebase Data Object.
+   * @param filename The queue file name.
+   * @param storageType The enum of memory storage type e.g. mem_storage_type_flash and mem_storage_type_sd. The file systems can be changed in FirebaseFS.h.
+   * @return Boolean value, indicates the success of the operation.
+   *
+   * @note The records are appended to the file and the offset of the oldest pending record is
+   * kept in the <filename>.hd file, the records that were left from the last run are resumed.
+   *
+   * processErrorQueue and beginAutoRunErrorQueue replay the records in order, up to
+   * FIREBASE_ERROR_QUEUE_REPLAY_BATCH records for each call, the replay stops at the first failure.
+   *
+   * The read (get) operations, blob data and the writes with priority are still kept
+   * in the Error Queue collection. The file uses the same record format as saveErrorQueue.
+   */
+  template <typename T = const char *>
+  bool beginPersistentErrorQueue(FirebaseData *fbdo, T filename, firebase_mem_storage_type storageType)
+  {
+    return mBeginPersistentErrorQueue(fbdo, toStringPtr(filename), storageType);
+  }
+
+  /** Stop adding the failed write operations to the queue file.
+   *
+   * @param fbdo The pointer to Firebase Data Object.
+   *
+   * @note The pending records are kept in the file.
+   */
+  void endPersistentErrorQueue(FirebaseData *fbdo);
+
+  /** Determine the number of pending records in the persistent error queue file.
+   *
+   * @param fbdo The pointer to Firebase Data Object.
+   * @return Number of pending records.
+   */
+  uint32_t persistentErrorQueueCount(FirebaseData *fbdo);
+
 #endif
 
   template <typename T1 = const char *, typename T2>
@@ -2595,12 +2765,25 @@ private:
   void rescon(FirebaseData *fbdo, const char *host, firebase_rtdb_request_info_t *req);
   void clearDataStatus(FirebaseData *fbdo);
   bool handleRequest(FirebaseData *fbdo, struct firebase_rtdb_request_info_t *req);
+  bool pipelinable(FirebaseData *fbdo, struct firebase_rtdb_request_info_t *req);
+  void addPipelineRequest(FirebaseData *fbdo, struct firebase_rtdb_request_info_t *req);
+  bool flushPipeline(FirebaseData *fbdo);
+  void failPipeline(FirebaseData *fbdo, int code);
+  int combineWrite(FirebaseData *fbdo, struct firebase_rtdb_request_info_t *req);
+  bool putCombinedWrite(FirebaseData *fbdo, const MB_String &path, const char *value, size_t len);
+  bool addCombinedWrite(FirebaseData *fbdo, const MB_String &path, const char *value, size_t len);
+  bool splitObject(const char *s, MB_VECTOR<size_t> &spans);
+  bool isSubPath(const MB_String &parent, const MB_String &path);
+  MB_String parentPath(const MB_String &path);
   bool sendRequest(FirebaseData *fbdo, struct firebase_rtdb_request_info_t *req);
   int preRequestCheck(FirebaseData *fbdo, struct firebase_rtdb_request_info_t *req);
   firebase_request_method getHTTPMethod(firebase_rtdb_request_info_t *req);
   bool hasPayload(struct firebase_rtdb_request_info_t *req);
+  bool headerTemplateValid(FirebaseData *fbdo);
+  void buildHeaderTemplate(FirebaseData *fbdo);
   bool sendRequestHeader(FirebaseData *fbdo, struct firebase_rtdb_request_info_t *req);
   int getPayloadLen(firebase_rtdb_request_info_t *req);
+  static size_t tcpWriteJson(void *ctx, const unsigned char *data, size_t len);
   bool waitResponse(FirebaseData *fbdo, firebase_rtdb_request_info_t *req);
   bool handleResponse(FirebaseData *fbdo, firebase_rtdb_request_info_t *req);
   int openFile(FirebaseData *fbdo, firebase_rtdb_request_info_t *req, mb_fs_open_mode mode, bool closeSession = false);
@@ -2658,8 +2841,8 @@ private:
   int handleRedirect(FirebaseData *fbdo, firebase_rtdb_request_info_t *req, struct firebase_tcp_response_handler_t &tcpHandler,
                      struct server_response_data_t &response);
   void sendCB(FirebaseData *fbdo);
-  void splitStreamPayload(const MB_String &payloads, MB_VECTOR<MB_String> &payload);
-  void parseStreamPayload(FirebaseData *fbdo, const MB_String &payload);
+  void setStreamDataType(const firebase_sse_event_t &ev, struct server_response_data_t &response);
+  void parseStreamPayload(FirebaseData *fbdo, const firebase_sse_event_t &ev);
   void storeToken(MB_String &atok, const char *databaseSecret);
   void restoreToken(MB_String &atok, firebase_auth_token_type tk);
   bool mSetQueryIndex(FirebaseData *fbdo, MB_StringPtr path, MB_StringPtr node, MB_StringPtr databaseSecret);
@@ -2678,6 +2861,12 @@ private:
   void runStreamTask();
   void mStopStreamLoopTask();
   void mRunStream();
+#if defined(ESP32)
+  void streamWakeInit();
+  void waitStream();
+  void stopStreamTask();
+  static void streamWakeDeferred(void *param, uint32_t value);
+#endif
 
 #if defined(ENABLE_ERROR_QUEUE) || defined(FIREBASE_ENABLE_ERROR_QUEUE)
 
@@ -2688,12 +2877,24 @@ private:
 #endif
 
   uint8_t openErrorQueue(FirebaseData *fbdo, MB_StringPtr filename, firebase_mem_storage_type storageType, uint8_t mode);
-#if (defined(MBFS_FLASH_FS) || defined(MBFS_SD_FS)) && (defined(ESP32) || defined(ESP8266) || defined(MB_ARDUINO_PICO))
-  uint8_t readQueueFile(FirebaseData *fbdo, fs::File &file, QueueItem &item, uint8_t mode);
-#endif
-#if defined(MBFS_ESP32_SDFAT_ENABLED)
-  uint8_t readQueueFileSdFat(FirebaseData *fbdo, MBFS_SD_FILE &file, QueueItem &item, uint8_t mode);
-#endif
+  int readQueueRecord(firebase_mem_storage_type storageType, QueueItem *item, MB_VECTOR<uint8_t> &buf);
+  bool queueRecordPayload(const QueueItem &item, MB_String &payload);
+  bool replayQueueItem(FirebaseData *fbdo, QueueItem &item);
+  void processQueueFile(FirebaseData *fbdo, FirebaseData::QueueInfoCallback callback);
+  bool mBeginPersistentErrorQueue(FirebaseData *fbdo, MB_StringPtr filename, firebase_mem_storage_type storageType);
+  int scanQueueFile(FirebaseData *fbdo);
+  bool appendQueueRecord(FirebaseData *fbdo, const QueueItem &item);
+  bool findQueueRecord(FirebaseData *fbdo, uint32_t qID);
+  void queueHeadFile(FirebaseData *fbdo, MB_String &name, bool tmp);
+  uint32_t readQueueHead(FirebaseData *fbdo);
+  bool writeQueueHead(FirebaseData *fbdo);
+  void resetQueueFile(FirebaseData *fbdo);
+  bool copyQueueFile(firebase_mem_storage_type storageType, const MB_String &src, uint32_t ofs,
+                     uint32_t len, const MB_String &dst);
+  bool compactQueueFile(FirebaseData *fbdo);
+  bool recoverQueueFile(FirebaseData *fbdo);
+  bool writeQueueMark(firebase_mem_storage_type storageType, const MB_String &name, mb_fs_open_mode mode, uint32_t v);
+  bool readQueueMark(firebase_mem_storage_type storageType, uint32_t &v);
 
 #endif
 
@@ -50,35 +50,17 @@ QueueManager::~QueueManager()
 void QueueManager::clear()
 {
     if (_queueCollection)
-    {
-        for (uint8_t i = 0; i < _queueCollection->size(); i++)
-        {
-#if defined(MB_USE_STD_VECTOR)
-            QueueItem item = _queueCollection->at(i);
-#else
-            QueueItem item = (*_queueCollection)[i];
-#endif
-
-            item.path.clear();
-            item.filename.clear();
-            item.payload.clear();
-            item.address.dout = 0;
-            item.address.din = 0;
-            item.blobSize = 0;
-            item.address.priority=0;
-            item.address.query = 0;
-        }
-    }
+        _queueCollection->clear();
 }
 
-bool QueueManager::add(struct QueueItem q)
+bool QueueManager::add(struct QueueItem &&q)
 {
     if (!_queueCollection)
         _queueCollection = new MB_VECTOR<QueueItem>();
 
     if (_queueCollection->size() < _maxQueue)
     {
-        _queueCollection->push_back(q);
+        _queueCollection->push_back(std::move(q));
         return true;
     }
     return false;
@@ -97,6 +79,124 @@ size_t QueueManager::size()
     return 0;
 }
 
+static void queueAddU32(MB_VECTOR<uint8_t> &buf, uint32_t v)
+{
+    for (uint8_t i = 0; i < 4; i++)
+        buf.push_back((v >> (8 * i)) & 0xff);
+}
+
+static uint32_t queueGetU32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static void queueAddStr(MB_VECTOR<uint8_t> &buf, const MB_String &str)
+{
+    queueAddU32(buf, str.length());
+    const char *p = str.c_str();
+    buf.insert(buf.end(), p, p + str.length());
+}
+
+static bool queueGetStr(uint8_t *&p, const uint8_t *end, MB_String &str)
+{
+    if (end - p < 4)
+        return false;
+
+    uint32_t len = queueGetU32(p);
+    p += 4;
+
+    if ((uint32_t)(end - p) < len)
+        return false;
+
+    // MB_String copies up to the null, borrow the first byte of the next field
+    uint8_t c = p[len];
+    p[len] = 0;
+    str.clear();
+    str.append((const char *)p, len);
+    p[len] = c;
+    p += len;
+    return true;
+}
+
+void QueueManager::encode(const QueueItem &item, const MB_String &payload, MB_VECTOR<uint8_t> &buf)
+{
+    size_t ofs = buf.size();
+
+    buf.push_back(FIREBASE_QUEUE_RECORD_MARK);
+    buf.push_back(FIREBASE_QUEUE_RECORD_VERSION);
+    buf.insert(buf.end(), 6, 0); // checksum and length, filled below
+
+    queueAddU32(buf, item.qID);
+    buf.push_back((uint8_t)item.dataType);
+    buf.push_back((uint8_t)item.subType);
+    buf.push_back((uint8_t)item.method);
+    buf.push_back((uint8_t)item.storageType);
+    buf.push_back((uint8_t)item.async);
+    queueAddU32(buf, item.blobSize);
+    queueAddStr(buf, item.path);
+    queueAddStr(buf, payload);
+    queueAddStr(buf, item.etag);
+    queueAddStr(buf, item.filename);
+
+    uint8_t *hdr = &buf[ofs];
+    uint32_t len = buf.size() - ofs - FIREBASE_QUEUE_RECORD_HEADER_SIZE;
+    uint16_t sum = checksum(hdr + FIREBASE_QUEUE_RECORD_HEADER_SIZE, len);
+    hdr[2] = sum & 0xff;
+    hdr[3] = sum >> 8;
+    for (uint8_t i = 0; i < 4; i++)
+        hdr[4 + i] = (len >> (8 * i)) & 0xff;
+}
+
+int32_t QueueManager::header(const uint8_t *hdr, uint16_t &sum)
+{
+    if (hdr[0] != FIREBASE_QUEUE_RECORD_MARK || hdr[1] != FIREBASE_QUEUE_RECORD_VERSION)
+        return -1;
+
+    uint32_t len = queueGetU32(hdr + 4);
+    if (len > FIREBASE_QUEUE_RECORD_MAX_SIZE)
+        return -1;
+
+    sum = hdr[2] | hdr[3] << 8;
+    return len;
+}
+
+bool QueueManager::decode(uint8_t *body, size_t len, QueueItem &item)
+{
+    if (len < 13)
+        return false;
+
+    uint8_t *p = body;
+    const uint8_t *end = body + len;
+
+    item.qID = queueGetU32(p);
+    item.dataType = (firebase_data_type)p[4];
+    item.subType = p[5];
+    item.method = (firebase_request_method)p[6];
+#if defined(FIREBASE_ESP_CLIENT)
+    item.storageType = (firebase_mem_storage_type)p[7];
+#else
+    item.storageType = p[7];
+#endif
+    item.async = p[8] > 0;
+    item.blobSize = queueGetU32(p + 9);
+    item.address = firebase_rtdb_address_t();
+    p += 13;
+
+    return queueGetStr(p, end, item.path) && queueGetStr(p, end, item.payload) &&
+           queueGetStr(p, end, item.etag) && queueGetStr(p, end, item.filename) && p == end;
+}
+
+uint16_t QueueManager::checksum(const uint8_t *data, size_t len, uint16_t sum)
+{
+    uint16_t s1 = sum & 0xff, s2 = sum >> 8;
+    for (size_t i = 0; i < len; i++)
+    {
+        s1 = (s1 + data[i]) % 255;
+        s2 = (s2 + s1) % 255;
+    }
+    return s2 << 8 | s1;
+}
+
 #endif
 
 #endif //ENABLE
\ No newline at end of file
@@ -36,6 +36,21 @@
 #include "./FB_Utils.h"
 #include "QueueInfo.h"
 
+/* The queue file record (little endian)
+ *
+ * header: mark (1), version (1), checksum of body (2), body length (4)
+ * body:   qID (4), dataType, subType, method, storageType, async (1 each),
+ *         blobSize (4), then path, payload, etag and filename as length (4) + bytes.
+ *
+ * The records are only appended, the reader walks them by the body length
+ * and stops at the first one that is incomplete or fails the checksum.
+ */
+#define FIREBASE_QUEUE_RECORD_MARK 0xA7
+#define FIREBASE_QUEUE_RECORD_VERSION 1
+#define FIREBASE_QUEUE_RECORD_HEADER_SIZE 8
+// The largest body accepted by the reader, anything above is treated as corrupted.
+#define FIREBASE_QUEUE_RECORD_MAX_SIZE (256 * 1024)
+
 class QueueManager
 {
     friend class FB_RTDB;
@@ -45,14 +60,54 @@ public:
     QueueManager();
     ~QueueManager();
 
-    bool add(QueueItem q);
+    bool add(QueueItem &&q);
     void remove(uint8_t index);
     size_t size();
 
 private:
     void clear();
+
+    /**
+     * Append the record of queue item to buffer.
+     * @param item The queue item.
+     * @param payload The payload to store instead of item.payload.
+     * @param buf The output buffer.
+     */
+    static void encode(const QueueItem &item, const MB_String &payload, MB_VECTOR<uint8_t> &buf);
+
+    /**
+     * Parse the record header.
+     * @param hdr The FIREBASE_QUEUE_RECORD_HEADER_SIZE bytes header.
+     * @param sum The checksum of body.
+     * @return The body length or -1 when it is not the record header.
+     */
+    static int32_t header(const uint8_t *hdr, uint16_t &sum);
+
+    /**
+     * Restore the queue item from record body.
+     * @param body The body which has one spare byte at the end.
+     * @param len The body length.
+     * @param item The queue item to restore.
+     * @return Boolean value, indicates the success of the operation.
+     */
+    static bool decode(uint8_t *body, size_t len, QueueItem &item);
+
+    // Fletcher-16, the sum can be continued from the previous call.
+    static uint16_t checksum(const uint8_t *data, size_t len, uint16_t sum = 0);
+
     MB_VECTOR<struct QueueItem> *_queueCollection = nullptr;
     uint8_t _maxQueue = 10;
+
+    // The append-only queue file (FB_RTDB::beginPersistentErrorQueue)
+    bool _logEnable = false;
+    uint8_t _logStorage = 0;
+    MB_String _logFile;
+    // offset of the oldest pending record and the end of the last complete record
+    uint32_t _logHead = 0;
+    uint32_t _logTail = 0;
+    uint32_t _logCount = 0;
+    // consecutive read failures of the record at _logHead
+    uint8_t _logReadFail = 0;
 };
 
 #endif
@@ -60,7 +60,7 @@ bool FIREBASE_MP_STREAM_CLASS::get(const String &path /* child path */)
         if (r)
         {
             FirebaseJsonData data;
-            sif->m_json->get(data, path);
+            sif->m_json->extract(data, sif->data.c_str(), sif->data.length(), path);
             if (data.success)
             {
                 type = data.type;
@@ -79,6 +79,7 @@ bool FIREBASE_MP_STREAM_CLASS::get(const String &path /* child path */)
             // check for the steam data path is matched or under the root (child path)
             if (checkPath(root, branch))
             {
+                sif->m_json->setJsonData(sif->data.c_str());
                 sif->m_json->toString(value, true);
                 type = sif->data_type_str.c_str();
                 eventType = sif->event_type_str.c_str();
@@ -0,0 +1,223 @@
+
+/**
+ * Google's Firebase Realtime Database server-sent events parser, FB_SSE.h version 1.0.0
+ *
+ * Created October 18, 2026
+ *
+ * The MIT License (MIT)
+ * Copyright (c) 2023 K. Suwatchai (Mobizt)
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person returning a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "./FirebaseFS.h"
+
+#if defined(ENABLE_RTDB) || defined(FIREBASE_ENABLE_RTDB)
+
+#ifndef FIREBASE_SSE_PARSER_H
+#define FIREBASE_SSE_PARSER_H
+#include <Arduino.h>
+#include "./FB_Const.h"
+
+/* One stream event, all spans point into the parser (or fed) buffer and are
+ * valid only inside the handler call.
+ * path is null when the data line is not a {"path":..,"data":..} object
+ * (e.g. keep-alive "data: null").
+ */
+struct firebase_sse_event_t
+{
+    const char *event = nullptr;
+    size_t eventLen = 0;
+    const char *path = nullptr;
+    size_t pathLen = 0;
+    const char *data = nullptr;
+    size_t dataLen = 0;
+};
+
+/* Push-style tokenizer for the RTDB event stream.
+ * Bytes are fed as they arrive, each complete "event: / data: " pair is passed
+ * to the handler. Complete lines are tokenized in place, only a line that is
+ * split across feeds is copied into the (reused) line buffer.
+ */
+class FB_SSEParser
+{
+public:
+    ~FB_SSEParser()
+    {
+        if (_buf)
+            free(_buf);
+    }
+
+    // Drop the partial line and the current event name (new connection).
+    void reset()
+    {
+        _len = 0;
+        _eventLen = 0;
+    }
+
+    // true when a partial line is waiting for more data.
+    bool pending() const { return _len > 0; }
+
+    /**
+     * Feed the received data.
+     * @param data The received data.
+     * @param len The length of data.
+     * @param handler The callable that receives const firebase_sse_event_t &.
+     * @return The number of events passed to handler.
+     */
+    template <typename Handler>
+    size_t feed(const char *data, size_t len, Handler &&handler)
+    {
+        size_t count = 0;
+
+        while (len > 0)
+        {
+            const char *nl = reinterpret_cast<const char *>(memchr(data, '\n', len));
+            size_t n = nl ? (size_t)(nl - data) : len;
+
+            if (!nl)
+            {
+                append(data, n);
+                break;
+            }
+
+            firebase_sse_event_t ev;
+            bool emit = false;
+
+            if (_len == 0)
+                emit = line(data, n, ev);
+            else if (append(data, n))
+            {
+                emit = line(_buf, _len, ev);
+                _len = 0;
+            }
+
+            if (emit)
+            {
+                handler(ev);
+                count++;
+            }
+
+            data += n + 1;
+            len -= n + 1;
+        }
+
+        return count;
+    }
+
+private:
+    bool append(const char *data, size_t len)
+    {
+        if (_len + len > _cap)
+        {
+            size_t cap = _cap ? _cap : 64;
+            while (cap < _len + len)
+                cap *= 2;
+            char *buf = reinterpret_cast<char *>(realloc(_buf, cap));
+            if (!buf)
+            {
+                // drop the oversized line rather than emit a truncated event
+                _len = 0;
+                return false;
+            }
+            _buf = buf;
+            _cap = cap;
+        }
+        memcpy(_buf + _len, data, len);
+        _len += len;
+        return true;
+    }
+
+    bool startsWith(const char *s, size_t len, PGM_P token, size_t &tokenLen)
+    {
+        tokenLen = strlen_P(token);
+        return len >= tokenLen && strncmp_P(s, token, tokenLen) == 0;
+    }
+
+    bool line(const char *s, size_t len, firebase_sse_event_t &ev)
+    {
+        if (len > 0 && s[len - 1] == '\r')
+            len--;
+
+        // blank line ends the event
+        if (len == 0)
+        {
+            _eventLen = 0;
+            return false;
+        }
+
+        size_t tl = 0;
+
+        if (startsWith(s, len, firebase_rtdb_pgm_str_12 /* "event: " */, tl))
+        {
+            _eventLen = len - tl < sizeof(_event) ? len - tl : sizeof(_event) - 1;
+            memcpy(_event, s + tl, _eventLen);
+            _event[_eventLen] = 0;
+            return false;
+        }
+
+        if (_eventLen == 0 || !startsWith(s, len, firebase_rtdb_pgm_str_13 /* "data: " */, tl))
+            return false;
+
+        ev.event = _event;
+        ev.eventLen = _eventLen;
+
+        s += tl;
+        len -= tl;
+
+        // {"path":"<path>","data":<value>}
+        size_t pl = 0;
+        if (len > 1 && s[0] == '{' && startsWith(s + 1, len - 1, firebase_pgm_str_54 /* "\"path\":\"" */, pl))
+        {
+            const char *p = s + 1 + pl;
+            const char *q = p;
+            // skip the escaped quotes in key
+            while ((q = reinterpret_cast<const char *>(memchr(q, '"', len - (q - s)))) && q[-1] == '\\')
+                q++;
+            size_t dl = 0;
+            if (q && q + 2 <= s + len && q[1] == ',' &&
+                startsWith(q + 2, len - (q + 2 - s), firebase_pgm_str_55 /* "\"data\":" */, dl))
+            {
+                ev.path = p;
+                ev.pathLen = q - p;
+                ev.data = q + 2 + dl;
+                ev.dataLen = s + len - ev.data;
+                // strip the closing brace of the event object
+                if (ev.dataLen > 0 && ev.data[ev.dataLen - 1] == '}')
+                    ev.dataLen--;
+                return true;
+            }
+        }
+
+        ev.data = s;
+        ev.dataLen = len;
+        return true;
+    }
+
+    char *_buf = nullptr;
+    size_t _len = 0;
+    size_t _cap = 0;
+    // longest RTDB event name is "auth_revoked"
+    char _event[16];
+    size_t _eventLen = 0;
+};
+
+#endif
+
+#endif
@@ -548,13 +548,14 @@ String FirebaseData::getBackupFilename()
 }
 
 #if defined(ENABLE_ERROR_QUEUE) || defined(FIREBASE_ENABLE_ERROR_QUEUE) && (defined(ENABLE_RTDB) || defined(FIREBASE_ENABLE_RTDB))
-void FirebaseData::addQueue(QueueItem *qItem)
+void FirebaseData::addQueue(QueueItem &&qItem)
 {
-    if (_qMan.size() < _qMan._maxQueue && qItem->payload.length() <= session.rtdb.max_blob_size)
+    if (_qMan.size() < _qMan._maxQueue && qItem.payload.length() <= session.rtdb.max_blob_size)
     {
-        qItem->qID = random(100000, 200000);
-        if (_qMan.add(*qItem))
-            session.rtdb.queue_ID = qItem->qID;
+        uint32_t qID = random(100000, 200000);
+        qItem.qID = qID;
+        if (_qMan.add(std::move(qItem)))
+            session.rtdb.queue_ID = qID;
         else
             session.rtdb.queue_ID = 0;
     }
@@ -621,6 +622,16 @@ bool FirebaseData::isKeepAlive()
     return tcpClient.isKeepAlive();
 }
 
+FirebaseConnectionStats FirebaseData::connectionStats()
+{
+    return tcpClient.stats();
+}
+
+void FirebaseData::resetConnectionStats()
+{
+    tcpClient.stats() = FirebaseConnectionStats();
+}
+
 String FirebaseData::payload()
 {
 #if defined(ENABLE_RTDB) || defined(FIREBASE_ENABLE_RTDB)
@@ -782,6 +793,11 @@ void FirebaseData::sendStreamToCB(int code, bool report)
 
 void FirebaseData::closeSession()
 {
+#if defined(ENABLE_RTDB) || defined(FIREBASE_ENABLE_RTDB)
+    _sse.reset();
+    // the pipelined requests that lost their responses with the connection are kept,
+    // the next RTDB request or endPipeline reports them as failed
+#endif
     setSession(false, false);
     Core.closeSession(&tcpClient, &session);
 }
@@ -968,16 +984,19 @@ bool FirebaseData::readPayload(MB_String *chunkOut, struct firebase_tcp_response
             {
 
                 if (tcpHandler.payloadLen == 0)
-                    tcpHandler.bufferAvailable = Core.hh.readLine(&tcpClient, pChunk, tcpHandler.chunkBufSize);
+                    tcpHandler.bufferAvailable = Core.hh.readLine(tcpHandler, pChunk, tcpHandler.chunkBufSize);
                 else
                 {
                     // for chunk base64 payload, we need to ensure the size is the multiples of 4 for decoding
                     int readIndex = 0;
                     while (readIndex < tcpHandler.chunkBufSize && tcpHandler.payloadRead + readIndex < tcpHandler.payloadLen)
                     {
-                        int r = tcpClient.read();
-                        if (r > -1)
-                            pChunk[readIndex++] = (char)r;
+                        int toRead = tcpHandler.chunkBufSize - readIndex;
+                        if (toRead > tcpHandler.payloadLen - tcpHandler.payloadRead - readIndex)
+                            toRead = tcpHandler.payloadLen - tcpHandler.payloadRead - readIndex;
+                        int r = tcpClient.readBytes(pChunk + readIndex, toRead);
+                        if (r > 0)
+                            readIndex += r;
                         if (!reconnect(tcpHandler.dataTime))
                             break;
                     }